@@ -0,0 +1,44 @@
+# Try to find the single precision FFTW headers and library.
+#
+# Usage of this module as follows:
+#
+#     find_package(FFTW)
+#
+# Variables defined by this module:
+#
+#  FFTW_FOUND               System has the fftw3f library/headers.
+#  FFTW_LIBRARIES           The fftw3f library.
+#  FFTW_INCLUDE_DIRS        The location of the FFTW headers.
+
+find_package(PkgConfig QUIET)
+
+if(PKG_CONFIG_FOUND)
+    pkg_check_modules(FFTW fftw3f)
+endif(PKG_CONFIG_FOUND)
+
+if(NOT FFTW_LIBRARIES)
+    find_library(FFTW_LIBRARIES
+        NAMES fftw3f
+    )
+endif(NOT FFTW_LIBRARIES)
+
+if(NOT FFTW_LIBRARY_DIRS)
+    get_filename_component(FFTW_LIBRARY_DIRS "${FFTW_LIBRARIES}" DIRECTORY)
+endif(NOT FFTW_LIBRARY_DIRS)
+
+if(NOT FFTW_INCLUDE_DIRS)
+    find_path(FFTW_INCLUDE_DIRS
+        NAMES fftw3.h
+    )
+endif(NOT FFTW_INCLUDE_DIRS)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(FFTW DEFAULT_MSG
+    FFTW_LIBRARIES
+    FFTW_INCLUDE_DIRS
+)
+
+mark_as_advanced(
+    FFTW_LIBRARIES
+    FFTW_INCLUDE_DIRS
+)
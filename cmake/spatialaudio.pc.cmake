@@ -5,5 +5,5 @@ includedir=${prefix}/include
 Name: libspatialaudio
 Description: Spatial audio rendering library
 Version: @PROJECT_VERSION@
-Libs: -L${libdir} -lspatialaudio @MYSOFA_LIB@ -lm -lz
+Libs: -L${libdir} -lspatialaudio @MYSOFA_LIB@ @FFTW_LIB@ @CMAKE_THREAD_LIBS_INIT@ -lm -lz
 Cflags: -I${includedir} @MYSOFA_INCLUDE@
@@ -16,14 +16,18 @@
 #ifndef _AMBISONIC_ALLRAD_H
 #define _AMBISONIC_ALLRAD_H
 
+#include <memory>
 #include <string>
 #include "AmbisonicBase.h"
 #include "BFormat.h"
 #include "AmbisonicOptimFilters.h"
 #include "LoudspeakerLayouts.h"
+#include "AlignedAllocator.h"
 
 namespace spaudio {
 
+    class ConfigCache;
+
     /// Ambisonic AllRAD decoder
 
     /** This is an AllRAD decoder for ITU BS.2051-3 layouts (and some extra ones). */
@@ -43,9 +47,13 @@ namespace spaudio {
          * @param layoutName    Loudspeaker layout name in the format X+Y+Z.
          * @param useLFE        (Optional) If true (and the layout contains one) the LFE channel will be rendered. If not, the LFE channel will be removed.
          * @param useOptimFilts (Optional) If true then psychacoustic optimisation filtering will be applied before decoding. This is false by default.
+         * @param pCache        (Optional) Cache from which the decoding matrix is loaded, or to which it is added if not found.
+         *                      The matrix is shared with other decoders using a cache with the same key.
+         *                      Its key must include the parameters of this function.
          * @return              Returns true if successfully configured.
          */
-        bool Configure(unsigned nOrder, unsigned nBlockSize, unsigned sampleRate, const std::string& layoutName, bool useLFE = true, bool useOptimFilts = false);
+        bool Configure(unsigned nOrder, unsigned nBlockSize, unsigned sampleRate, const std::string& layoutName, bool useLFE = true, bool useOptimFilts = false,
+            ConfigCache* pCache = nullptr);
 
         /** Resets the internal state. */
         void Reset();
@@ -81,10 +89,16 @@ namespace spaudio {
         // IIR low-pass for the LFE
         IIRFilter m_lowPassIIR;
 
-        std::vector<std::vector<float>> m_decMat;
+        // Decoding matrix of size nLdspk x nAmbiCh stored row-major, excluding the LFE channels. It is read-only so
+        // that it can be shared with other decoders with the same configuration
+        std::shared_ptr<const AlignedVector<float>> m_decMat;
+        // Output buffers of the loudspeakers in the rows of m_decMat
+        std::vector<float*> m_pDecOut;
 
-        /** Configure AllRAD decoding matrix */
-        void ConfigureAllRADMatrix();
+        /** Configure AllRAD decoding matrix, loading it from the cache if it is available */
+        void ConfigureAllRADMatrix(ConfigCache* pCache);
+        /** Calculate the AllRAD decoding matrix for the loudspeakers in m_pDecOut */
+        void CalculateAllRADMatrix(AlignedVector<float>& decoder) const;
 
         // Maximum block size
         unsigned m_nBlockSize = 0;
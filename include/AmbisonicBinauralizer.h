@@ -23,13 +23,15 @@
 #include "AmbisonicShelfFilters.h"
 #include "AmbisonicDecoder.h"
 #include "AmbisonicEncoder.h"
-#include "kiss_fftr.h"
+#include "FrequencyDomainConvolver.h"
 
 #include "mit_hrtf.h"
 #include "sofa_hrtf.h"
 
 namespace spaudio {
 
+    class ConfigCache;
+
     /// Ambisonic binauralizer
 
     /** B-Format to binaural decoder. */
@@ -51,6 +53,12 @@ namespace spaudio {
          * @param tailLength    Returns the length of the HRTF in samples.
          * @param HRTFPath      Path to the HRTF to be used.
          * @param lowCpuMode    If true then uses a symmetric head assumption to reduce CPU use.
+         * @param combineShelfFilters   If true then the psychoacoustic shelf filters are convolved with the HRTFs
+         *                              so that they do not need to be applied separately during processing.
+         *                              This lengthens the filters by the truncated shelf filter response.
+         * @param pCache        (Optional) Cache from which the filters are loaded, or to which they are added if not found.
+         *                      The filters are shared with other binauralizers using a cache with the same key.
+         *                      Its key must include the parameters of this function and the contents of the HRTF file.
          * @return              Returns true if correctly configured.
          */
         virtual bool Configure(unsigned nOrder,
@@ -59,7 +67,9 @@ namespace spaudio {
             unsigned nBlockSize,
             unsigned& tailLength,
             std::string HRTFPath = "",
-            bool lowCpuMode = true);
+            bool lowCpuMode = true,
+            bool combineShelfFilters = false,
+            ConfigCache* pCache = nullptr);
 
         /** Resets the state of the binauralizer. */
         virtual void Reset() override;
@@ -88,26 +98,28 @@ namespace spaudio {
         BFormat m_BFSrcTmp;
 
         bool m_useSymHead = true;
+        // If true the shelf filters are included in the convolver filters and m_shelfFilters is not used
+        bool m_combineShelfFilters = false;
 
         unsigned m_nBlockSize;
         unsigned m_nSampleRate;
         unsigned m_nTaps;
-        unsigned m_nFFTSize;
-        unsigned m_nFFTBins;
-        float m_fFFTScaler;
-        unsigned m_nOverlapLength;
-
-        std::unique_ptr<struct kiss_fftr_state, decltype(&kiss_fftr_free)> m_pFFT_cfg;
-        std::unique_ptr<struct kiss_fftr_state, decltype(&kiss_fftr_free)> m_pIFFT_cfg;
-        std::vector<std::unique_ptr<kiss_fft_cpx[]>> m_ppcpFilters[2];
-        std::unique_ptr<kiss_fft_cpx[]> m_pcpScratch;
 
-        std::vector<float> m_pfScratchBufferA;
-        std::vector<float> m_pfScratchBufferB;
-        std::vector<float> m_pfScratchBufferC;
-        std::vector<float> m_pfOverlap[2];
+        // Partitioned convolution of the input channels with the filters for each ear
+        FrequencyDomainConvolver m_convolver;
 
         HRTF* getHRTF(unsigned nSampleRate, std::string HRTFPath);
+        /** Calculates the filters for each channel and ear from the HRTF, stored one after the other. Only the left ear
+         *  filters are calculated when assuming a symmetric head.
+         * @param HRTFPath  Path to the HRTF to be used.
+         * @param filters   Filled with the filters.
+         * @return          Returns true if the filters were calculated.
+         */
+        bool CalculateFilters(const std::string& HRTFPath, std::vector<float>& filters);
+        /** Returns the truncated impulse response of the shelf filters for each channel. */
+        static std::vector<std::vector<float>> CalculateShelfResponses(unsigned nOrder, bool b3D, unsigned nSampleRate);
+        /** Returns true if the channel is subtracted to generate the right ear signal when assuming a symmetric head. */
+        static bool IsAntisymmetricChannel(unsigned nChannel);
         virtual void ArrangeSpeakers();
         virtual void AllocateBuffers();
     };
@@ -20,6 +20,7 @@
 #include <math.h>
 #include <cmath>
 #include <memory.h>
+#include <vector>
 
 #include "Coordinates.h"
 
@@ -140,6 +141,25 @@ namespace spaudio {
     template<typename T>
     T FuMaToSn3dFactor(int order, int degree);
 
+    /** Get the offset of the block of a given order in the packed block-diagonal format used by
+     *  ShRotationMatrixBlocks(). This is the sum of (2n+1)^2 for all lower orders.
+     * @param order     Order of the block.
+     * @return          Index of the first coefficient of the block.
+     */
+    unsigned OrderToRotationBlockPosition(unsigned order);
+
+    /** Calculate the rotation matrix of the real spherical harmonics of every order up to nOrder from a 3x3
+     *  rotation matrix using the recursion of Ivanic and Ruedenberg. The cost is O(nOrder^3).
+     *  Rotations only mix components of the same order so only the blocks on the diagonal are returned. They are
+     *  packed one after the other starting from order 0 and each block is a (2n+1)x(2n+1) row-major matrix with
+     *  rows and columns in ACN order. The blocks apply to both N3D and SN3D signals.
+     * @param rotMat    3x3 rotation matrix that rotates a column vector of Cartesian (x, y, z) coordinates.
+     * @param nOrder    Maximum order.
+     * @param blocks    The rotation matrix blocks. Resized to OrderToRotationBlockPosition(nOrder + 1).
+     */
+    template<typename T>
+    void ShRotationMatrixBlocks(const std::vector<std::vector<T>>& rotMat, unsigned nOrder, std::vector<T>& blocks);
+
 } // namespace spaudio
 
 #endif //_AMBISONICCOMMONS_H
@@ -21,6 +21,7 @@
 #include "BFormat.h"
 #include "AmbisonicSpeaker.h"
 #include "AmbisonicOptimFilters.h"
+#include "AlignedAllocator.h"
 
 namespace spaudio {
 
@@ -172,6 +173,12 @@ namespace spaudio {
         */
         void ConfigureDecoderMatrix();
 
+        /** Copy the coefficients of all of the speakers to m_decMat. */
+        void UpdateDecodeMatrix();
+
+        // The coefficients of all of the speakers of size nSpeakers x nAmbiCh stored row-major
+        AlignedVector<float> m_decMat;
+
         // Flag if the selected layout is 2D
         bool m_is2dLayout = false;
         // The maximum order supported by the selected layout
@@ -19,6 +19,8 @@
 #include "AmbisonicBase.h"
 #include "BFormat.h"
 
+#include <cstdint>
+
 namespace spaudio {
 
     struct RotationOrientation
@@ -28,6 +30,19 @@ namespace spaudio {
         float roll = 0.f;
     };
 
+    /** A unit quaternion describing the orientation of the listener's head, for example as reported by a head tracker.
+     *  The axes follow the same convention as RotationOrientation, so that a rotation about the z-axis by yaw, then
+     *  about the new y-axis by pitch and then about the new x-axis by roll is the same as a RotationOrientation with
+     *  the default RotationOrder::YawPitchRoll.
+     */
+    struct RotationQuaternion
+    {
+        float w = 1.f;
+        float x = 0.f;
+        float y = 0.f;
+        float z = 0.f;
+    };
+
     /** This class is used to rotate the sound field by the angles specified in RotationOrientation.
      *  It includes rotation matrix coefficient smoothing to minimise artefacts when applying real-time rotations.
      */
@@ -86,6 +101,33 @@ namespace spaudio {
         /** Get the rotation orientation angles (yaw, pitch and roll) in radians. */
         RotationOrientation GetOrientation();
 
+        /** Set the head-tracking mode update interval. In head-tracking mode the orientation comes from the samples
+         *  passed to AddTrackerOrientation() instead of SetOrientation(). The orientation is interpolated between the
+         *  samples using slerp and the rotation matrix is updated every nSamples, with a short linear cross-fade
+         *  between updates. This means the cost per block does not depend on the rate of the tracker.
+         *  Pending tracker samples are discarded when the interval is changed.
+         *
+         * @param nSamples  The number of samples between rotation matrix updates, typically 16 to 32.
+         *                  If zero then head-tracking mode is disabled. This is the default.
+         */
+        void SetTrackerUpdateInterval(unsigned nSamples);
+
+        /** Get the head-tracking mode update interval.
+         *
+         * @return  The number of samples between rotation matrix updates, or zero if head-tracking mode is disabled.
+         */
+        unsigned GetTrackerUpdateInterval() const;
+
+        /** Add an orientation sample from a head tracker. Only used in head-tracking mode. The orientation is held
+         *  after the last sample until the next one is added. Samples before the first one keep the orientation
+         *  that was active when head-tracking mode was enabled. Ignored when head-tracking mode is off. At most 64
+         *  samples are held between blocks; when the queue is full the oldest sample is dropped.
+         *
+         * @param orientation   The orientation of the listener's head. Normalised if it is not a unit quaternion.
+         * @param nOffset       The time of the sample in samples from the start of the next call to Process().
+         */
+        void AddTrackerOrientation(const RotationQuaternion& orientation, unsigned nOffset = 0);
+
         /** Rotate the B-format audio stream.
          *
          * @param pBFSrcDst     The B-format stream to be rotated. This is replaced by the rotated signal.
@@ -97,53 +139,99 @@ namespace spaudio {
         using AmbisonicBase::Configure;
         RotationOrder m_rotOrder = RotationOrder::YawPitchRoll;
         RotationOrientation m_orientation;
-        BFormat m_tempBuffer;
-        std::vector<std::vector<float>> m_targetMatrix;
-        std::vector<std::vector<float>> m_targetMatrixTmp;
-        std::vector<std::vector<float>> m_currentMatrix;
+        // The 3x3 rotation matrix in Cartesian coordinates
+        std::vector<std::vector<double>> m_targetMatrix;
+        std::vector<std::vector<double>> m_targetMatrixTmp;
+        // The spherical harmonic rotation matrix blocks before conversion to float
+        std::vector<double> m_rotationBlocks;
+
+        // The rotation matrices only mix channels of the same order so they are block diagonal. Only the blocks are
+        // stored, one after the other starting from order 0. Each block is a (2n+1)x(2n+1) row-major matrix.
+        std::vector<float> m_targetBlocks;
+        std::vector<float> m_currentBlocks;
+        // The size of the steps taken during fading for each matrix coefficient
+        std::vector<float> m_deltaBlocks;
+        // Input signals of the channels of one order for a chunk of samples so the output can be written in place
+        std::vector<float> m_chunkInput;
+
+        // A head tracker orientation and the time it applies in samples since Configure()
+        struct TrackerSample
+        {
+            uint64_t time;
+            RotationQuaternion orientation;
+        };
+        // The number of samples between rotation matrix updates in head-tracking mode, or zero if disabled
+        unsigned int m_trackerInterval = 0;
+        // Tracker samples in time order. The first one is the latest sample before the start of the next block
+        std::vector<TrackerSample> m_trackerSamples;
+        // The number of samples processed since Configure()
+        uint64_t m_sampleTime = 0;
+        // The tracker orientation of m_targetBlocks, if m_hasTrackerOrientation is true
+        RotationQuaternion m_trackerOrientation;
+        bool m_hasTrackerOrientation = false;
 
         // The time to fade from the previous orientation to the target orientation
         float m_fadingTimeMilliSec = 0.f;
         unsigned int m_fadingSamples = 0;
         unsigned int m_fadingCounter = 0;
-        // The size of the steps taken during fading for each matrix coefficient
-        std::vector<std::vector<float>> m_deltaMatrix;
 
         // Temp matrices for the individual yaw, pitch and roll rotations
-        std::vector<std::vector<float>> m_yawMatrix, m_pitchMatrix, m_rollMatrix;
-
-        // Some constants that are used frequently in rotation matrix equations
-        float m_sqrt3_2, m_sqrt6_4, m_sqrt10_4, m_sqrt15_4, m_sqrt15_2;
+        std::vector<std::vector<double>> m_yawMatrix, m_pitchMatrix, m_rollMatrix;
 
-        /** Returns the rotation matrix for a yaw rotation.
+        /** Returns the 3x3 Cartesian rotation matrix for a yaw rotation.
          *  The rotation is applied so that a positive yaw will lead to a sound source
          *  encoded to the front moving in an anti-clockwise direction as viewed from above the listener.
          *
          *  @param yaw      The yaw rotation angle in radians.
-         *  @param yawMat   The spherical harmonic yaw rotation matrix.
+         *  @param yawMat   The yaw rotation matrix.
          */
-        void getYawMatrix(float yaw, std::vector<std::vector<float>>& yawMat);
+        void getYawMatrix(double yaw, std::vector<std::vector<double>>& yawMat);
 
-        /** Returns the rotation matrix for a pitch rotation.
+        /** Returns the 3x3 Cartesian rotation matrix for a pitch rotation.
          *  The rotation is applied so that a positive pitch will lead to a sound source
          *  encoded to the front moving in an anti-clockwise direction as viewed from the left of the listener.
          *
          *  @param pitch    The pitch rotation angle in radians.
-         *  @param pitchMat The spherical harmonic pitch rotation matrix.
+         *  @param pitchMat The pitch rotation matrix.
          */
-        void getPitchMatrix(float pitch, std::vector<std::vector<float>>& pitchMat);
+        void getPitchMatrix(double pitch, std::vector<std::vector<double>>& pitchMat);
 
-        /** Returns the rotation matrix for a roll rotation.
+        /** Returns the 3x3 Cartesian rotation matrix for a roll rotation.
          *  The rotation is applied so that a positive roll will lead to a sound source
          *  encoded to the left moving in a clockwise direction as viewed from the front of the listener.
          *
          *  @param roll     The roll rotation angle in radians.
-         *  @param rollMat  The spherical harmonic roll rotation matrix.
+         *  @param rollMat  The roll rotation matrix.
          */
-        void getRollMatrix(float roll, std::vector<std::vector<float>>& rollMat);
+        void getRollMatrix(double roll, std::vector<std::vector<double>>& rollMat);
 
         /** Update the target rotation matrix using the current RotationOrder and RotationOrientation. */
         void updateTargetRotationMatrix();
+
+        /** Update the target rotation matrix blocks from the 3x3 rotation matrix m_targetMatrix. */
+        void updateTargetBlocks();
+
+        /** Get the interpolated tracker orientation at a given time.
+         *  @param time         The time in samples since Configure().
+         *  @param orientation  The orientation.
+         *  @return             False if there are no tracker samples at or before the time.
+         */
+        bool getTrackerOrientation(uint64_t time, RotationQuaternion& orientation);
+
+        /** Rotate the B-format audio stream in head-tracking mode.
+         *  @param pBFSrcDst    The B-format stream to be rotated.
+         *  @param nSamples     The number of samples to be processed.
+         */
+        void processTracking(BFormat* pBFSrcDst, unsigned nSamples);
+
+        /** Apply the rotation to a chunk of samples of the channels of one order in place.
+         *  @param pBFSrcDst    The B-format stream to be rotated.
+         *  @param nOrder       The order of the block.
+         *  @param iStart       The first sample of the chunk.
+         *  @param nSamples     The number of samples in the chunk.
+         *  @param bFade        If true the coefficients are faded from the current block by the delta block per sample.
+         */
+        void processBlock(BFormat* pBFSrcDst, unsigned nOrder, unsigned iStart, unsigned nSamples, bool bFade);
     };
 
 } // namespace spaudio
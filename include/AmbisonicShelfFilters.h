@@ -18,7 +18,7 @@
 
 #include "AmbisonicBase.h"
 #include "BFormat.h"
-#include "kiss_fftr.h"
+#include "FrequencyDomainConvolver.h"
 #include "AmbisonicPsychoacousticFilters.h"
 
 namespace spaudio {
@@ -32,7 +32,6 @@ namespace spaudio {
     {
     public:
         AmbisonicShelfFilters();
-        ~AmbisonicShelfFilters();
 
         /** Re-create the object for the given configuration. Previous data is
          *  lost. The last argument is not used, it is just there to match with
@@ -62,20 +61,11 @@ namespace spaudio {
         using AmbisonicBase::Configure;
 
     protected:
-        kiss_fftr_cfg m_pFFT_psych_cfg;
-        kiss_fftr_cfg m_pIFFT_psych_cfg;
-
-        float* m_pfScratchBufferA;
-        float** m_pfOverlap;
-        unsigned m_nFFTSize;
         unsigned m_nBlockSize;
         unsigned m_nTaps;
-        unsigned m_nOverlapLength;
-        unsigned m_nFFTBins;
-        float m_fFFTScaler;
 
-        kiss_fft_cpx** m_ppcpPsychFilters;
-        kiss_fft_cpx* m_pcpScratch;
+        // Convolves each channel with the filter for its order
+        FrequencyDomainConvolver m_convolver;
     };
 
 } // namespace spaudio
@@ -0,0 +1,177 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A persistent cache of data precomputed at configuration                 #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      ConfigCache.h                                            #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+namespace spaudio {
+
+    /** Statistics of the tables shared between all objects configured with the same ConfigCache key. */
+    struct SharedTableStatistics
+    {
+        // The number of tables in use
+        size_t nTables = 0;
+        // The total size of the tables in use in bytes
+        size_t nBytes = 0;
+    };
+
+    /** Holds arrays of data calculated during configuration, such as decoding matrices and filters, so that they
+     *  can be saved to a cache directory and loaded the next time the same configuration is used.
+     *
+     *  The entry is identified by a key that is a hash of everything the data depends on. The key is built with
+     *  the AddToKey() functions before calling Load(). Classes that accept a ConfigCache look up their data by name
+     *  with Get() and store it with Set() if it was not found. The caller is responsible for adding all of the
+     *  parameters passed to those classes to the key.
+     *
+     *  Entries are stored in a binary format that is specific to the library version and the byte order of the
+     *  machine. Files that do not match, are truncated or are corrupted are ignored.
+     *
+     *  Read-only tables can also be shared with every other ConfigCache in the process that has the same key using
+     *  GetShared() and Share(). A table is kept only while an object holds a reference to it so that objects
+     *  configured with the same parameters use a single copy instead of one each.
+     */
+    class ConfigCache
+    {
+    public:
+        ConfigCache();
+        ~ConfigCache();
+
+        /** Add data to the key identifying the entry.
+         * @param pData     Data to add.
+         * @param nBytes    Number of bytes of data.
+         */
+        void AddToKey(const void* pData, size_t nBytes);
+        void AddToKey(const std::string& str);
+        void AddToKey(unsigned int value);
+        void AddToKey(double value);
+
+        /** Add the contents of a file to the key.
+         * @param path  Path to the file.
+         * @return      Returns false if the file could not be read.
+         */
+        bool AddFileToKey(const std::string& path);
+
+        /** Get the key identifying the entry.
+         * @return  Hash of all data added to the key.
+         */
+        uint64_t GetKey() const;
+
+        /** Get the path of the file holding the entry for the current key.
+         * @param directory The cache directory.
+         * @return          The path of the entry file.
+         */
+        std::string GetFilePath(const std::string& directory) const;
+
+        /** Load the entry for the current key. Any data already held is replaced.
+         * @param directory The cache directory.
+         * @return          Returns true if a valid entry was found.
+         */
+        bool Load(const std::string& directory);
+
+        /** Save the entry for the current key. The file is written under a temporary name and then renamed so
+         *  that other processes never read a partially written entry.
+         * @param directory The cache directory. It must already exist.
+         * @return          Returns true if the entry was saved.
+         */
+        bool Save(const std::string& directory);
+
+        /** Returns true if data has been set since the entry was loaded or saved. */
+        bool IsModified() const;
+
+        /** Get a named array.
+         * @param name  Name of the array.
+         * @param data  Vector to fill with the array data.
+         * @return      Returns true if an array of the matching type was found.
+         */
+        template<typename T, typename Alloc>
+        bool Get(const std::string& name, std::vector<T, Alloc>& data) const
+        {
+            const std::vector<char>* pBytes = Find(name, GetType(T()));
+            if (pBytes == nullptr)
+                return false;
+            data.resize(pBytes->size() / sizeof(T));
+            if (!data.empty())
+                std::memcpy(data.data(), pBytes->data(), data.size() * sizeof(T));
+            return true;
+        }
+
+        /** Set a named array, replacing any array with the same name.
+         * @param name      Name of the array.
+         * @param pData     The array data.
+         * @param nValues   Number of values in the array.
+         */
+        template<typename T>
+        void Set(const std::string& name, const T* pData, size_t nValues)
+        {
+            Array& array = m_arrays[name];
+            array.type = GetType(T());
+            array.bytes.assign((const char*)pData, (const char*)(pData + nValues));
+            m_isModified = true;
+        }
+
+        /** Get a table shared by an object configured with the same key.
+         * @param name  Name of the table.
+         * @return      The table, or nullptr if no table of the matching type is in use.
+         */
+        template<typename T>
+        std::shared_ptr<const T> GetShared(const std::string& name) const
+        {
+            return std::static_pointer_cast<const T>(FindShared(name, typeid(T)));
+        }
+
+        /** Share a table with objects configured with the same key. If another object shared a table with the same
+         *  name first then that table is returned instead so that only one copy is kept.
+         * @param name      Name of the table.
+         * @param table     The table.
+         * @param nBytes    The size of the table in bytes, used for the statistics.
+         * @return          The shared table.
+         */
+        template<typename T>
+        std::shared_ptr<const T> Share(const std::string& name, std::shared_ptr<const T> table, size_t nBytes)
+        {
+            return std::static_pointer_cast<const T>(InsertShared(name, typeid(T), std::move(table), nBytes));
+        }
+
+        /** Get the number and size of the tables currently shared in the process.
+         * @return  The statistics of the shared tables.
+         */
+        static SharedTableStatistics GetSharedTableStatistics();
+
+    private:
+        struct Array
+        {
+            uint32_t type = 0;
+            std::vector<char> bytes;
+        };
+
+        // FNV-1a hash of the data added to the key
+        uint64_t m_key;
+        std::map<std::string, Array> m_arrays;
+        bool m_isModified = false;
+
+        static uint32_t GetType(float) { return 1; }
+        static uint32_t GetType(double) { return 2; }
+
+        const std::vector<char>* Find(const std::string& name, uint32_t type) const;
+        std::shared_ptr<const void> FindShared(const std::string& name, std::type_index type) const;
+        std::shared_ptr<const void> InsertShared(const std::string& name, std::type_index type, std::shared_ptr<const void> table, size_t nBytes);
+    };
+
+} // namespace spaudio
@@ -14,10 +14,12 @@
 
 #include "LoudspeakerLayouts.h"
 #include "Tools.h"
-#include "kiss_fftr.h"
+#include "FrequencyDomainConvolver.h"
 
 namespace spaudio {
 
+    class ConfigCache;
+
     /**
         This class applied decorrelation to the output speaker layouts.
         It allows allows for compensation delay to be applied to the direct signal.
@@ -34,9 +36,12 @@ namespace spaudio {
          *
          * @param layout		Target speaker layout
          * @param nBlockSize	Maximum number of samples to be passed to Process()
+         * @param pCache		(Optional) Cache from which the decorrelation filters are loaded, or to which they are added
+         *						if not found. The filters are shared with other decorrelators using a cache with the same
+         *						key. Its key must include the layout and block size.
          * @return				Returns true if correctly configured
          */
-        bool Configure(Layout layout, unsigned int nBlockSize);
+        bool Configure(Layout layout, unsigned int nBlockSize, ConfigCache* pCache = nullptr);
         /**
             Not implemented.
         */
@@ -51,8 +56,6 @@ namespace spaudio {
         void Process(float** ppInDirect, float** ppInDiffuse, unsigned int nSamples);
 
     private:
-        // The time-domain decorrelation filters
-        std::vector<std::vector<float>> decorrelationFilters;
         // Output layout
         Layout m_layout;
         // The number of channels in the output array
@@ -61,23 +64,14 @@ namespace spaudio {
         // According to Rec. ITU-R BS.2127-0 sec. 7.4 the decorrelation filter length is 512 samples
         const unsigned int m_nDecorrelationFilterSamples = 512;
 
-        kiss_fftr_cfg m_pFFT_decor_cfg;
-        kiss_fftr_cfg m_pIFFT_decor_cfg;
-
-        float* m_pfScratchBufferA = nullptr;
-        float** m_pfOverlap = nullptr;
-        unsigned m_nFFTSize;
         unsigned m_nBlockSize;
         unsigned m_nTaps;
-        unsigned m_nOverlapLength;
-        unsigned m_nFFTBins;
-        float m_fFFTScaler;
 
-        kiss_fft_cpx** m_ppcpDecorFilters;
-        kiss_fft_cpx* m_pcpScratch;
+        // Convolves each diffuse channel with its decorrelation filter
+        FrequencyDomainConvolver m_convolver;
 
         // Buffers to hold the delayed direct signals
-        float** m_ppfDirectDelay = nullptr;
+        std::vector<std::vector<float>> m_ppfDirectDelay;
         unsigned int m_nDelayLineLength;
         int m_nDelay = (m_nDecorrelationFilterSamples - 1) / 2;
         int m_nReadPos = 0;
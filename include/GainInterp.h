@@ -17,7 +17,12 @@
 namespace spaudio {
 
     /**
-    *	A class to handle the interpolation from one gain vector applied to a mono input over a specified duration
+    *	A class to handle the interpolation from one gain vector applied to a mono input over a specified duration.
+    *
+    *	The gains are applied in single precision. During interpolation the gain after n samples is calculated
+    *	directly as start + n * delta rather than accumulated, so the samples of a ramp can be processed in parallel
+    *	and the ramp does not drift. For gains with a magnitude of up to 1 the applied gain is within 1e-6 of the
+    *	exact linear interpolation, and the target is reached exactly at the end of the interpolation.
     */
     template <typename T>
     class GainInterp
@@ -67,8 +72,10 @@ namespace spaudio {
         void Reset();
 
     private:
-        // The gain vector, the target gain vector to interpolate towards, and a vector holding the change per sample
-        std::vector<T> m_currentGainVec, m_targetGainVec, m_targetGainVecTmp, m_deltaGainVec;
+        // The target gain vector to interpolate towards and a temporary vector used by SetGainValue()
+        std::vector<T> m_targetGainVec, m_targetGainVecTmp;
+        // The gain vector at the start of the interpolation and a vector holding the change per sample
+        std::vector<float> m_startGainVec, m_deltaGainVec;
 
         // The interpolation duration in samples
         unsigned int m_interpDurInSamples = 0;
@@ -77,6 +84,12 @@ namespace spaudio {
 
         // Flag if it is the first call of Process or ProcessAccumul to avoid fade in from zero
         bool m_isFirstCall = true;
+
+        /** Get the gain currently applied to a channel.
+         * @param iCh	The channel index.
+         * @return		The gain after the number of samples interpolated so far.
+         */
+        float GetCurrentGain(unsigned int iCh) const;
     };
 
 } // namespace spaudio
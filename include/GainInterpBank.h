@@ -0,0 +1,78 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  Apply interpolated gain vectors to many mono inputs and mix them        #*/
+/*#                                                                          #*/
+/*#  Filename:      GainInterpBank.h                                         #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+#include <vector>
+
+namespace spaudio {
+
+    /**
+    *	Interpolates the gain vectors of a set of mono sources and mixes the sources to a shared multichannel output.
+    *	Each source behaves like a GainInterp, but the current, target and per-sample change of the gains of all
+    *	sources are stored in contiguous arrays. This means that a group of sources can be mixed in a single pass
+    *	over the output, one block of samples of each output channel at a time, instead of each source reading
+    *	and writing the whole output.
+    *
+    *	Different sources can be processed on different threads at the same time as long as they write to
+    *	different outputs.
+    */
+    class GainInterpBank
+    {
+    public:
+        GainInterpBank();
+        ~GainInterpBank();
+
+        /** Configure the bank. Previous gains are lost.
+         * @param nSources	The number of sources.
+         * @param nCh		The number of output channels.
+         */
+        void Configure(unsigned int nSources, unsigned int nCh);
+
+        /** Set the gain vector target of a source and the time in samples to interpolate to it.
+         *
+         * @param iSource				Index of the source.
+         * @param newGainVec			Vector of new gains. Must have the same length as the number of channels.
+         * @param interpTimeInSamples	The number of samples over which to interpolate to the new gain vector.
+         */
+        void SetGainVector(unsigned int iSource, const std::vector<double>& newGainVec, unsigned int interpTimeInSamples);
+
+        /** Apply the gains to a group of sources and _add_ them to the output buffer.
+         *
+         * @param pSourceInds	Indices of the sources to process. Each source must only appear once.
+         * @param ppIn			Mono input buffer for each of the sources.
+         * @param nSources		Number of sources to process.
+         * @param ppOut			Output to which the sources multiplied by their gain vectors are added.
+         * @param nSamples		The number of samples to process.
+         * @param nOffset		Number of samples of delay to applied to the signals.
+         */
+        void ProcessAccumul(const unsigned int* pSourceInds, const float* const* ppIn, unsigned int nSources, float** ppOut, unsigned int nSamples, unsigned int nOffset = 0);
+
+        /** Resets all of the sources by setting the gain vectors to the target and making sure there is no interpolation pending. */
+        void Reset();
+
+    private:
+        unsigned int m_nSources = 0;
+        unsigned int m_nCh = 0;
+
+        // The current, target and change per sample of the gains of every source. Size nSources x nCh
+        std::vector<float> m_currentGains;
+        std::vector<float> m_targetGains;
+        std::vector<float> m_deltaGains;
+        // The number of samples of interpolation remaining for each source
+        std::vector<unsigned int> m_interpRemaining;
+        // Flag for each source if it has not been processed yet to avoid fade in from zero.
+        // Not vector<bool> so that sources can be updated from different threads
+        std::vector<char> m_isFirstCall;
+    };
+
+} // namespace spaudio
@@ -38,6 +38,17 @@ namespace spaudio {
         void CalculateGains(CartesianPosition<double> directionUnitVec, std::vector<double>& gainsOut);
         void CalculateGains(PolarPosition<double> directionUnitVec, std::vector<double>& gainsOut);
 
+        /** Calculate the panning gains for a batch of directions. The directions are grouped by the regions that can
+         *  contain them so that the gains of each triplet are calculated for all of its directions at once. This does
+         *  not modify the object so it can be called from several threads at the same time.
+         * @param directions    The directions of the sources. They do not need to be unit vectors.
+         * @param nDirections   The number of directions.
+         * @param gainsOut      Output array of nDirections * getNumChannels() gains, holding the gains of each
+         *                      direction one after the other.
+         */
+        void CalculateGains(const CartesianPosition<double>* directions, size_t nDirections, double* gainsOut) const;
+        void CalculateGains(const CartesianPosition<double>* directions, size_t nDirections, float* gainsOut) const;
+
         /** Get the number of loudspeakers set in the targetLayout. */
         unsigned int getNumChannels();
 
@@ -75,6 +86,14 @@ namespace spaudio {
         std::vector<double> m_tripletGains;
         std::vector<double> m_quadGains;
 
+        // The number of bins along each edge of each face of the cube map used to find the regions for a direction
+        static const unsigned int kNumCubeMapBins = 8;
+        // The regions that can have non-zero gains for directions in each bin of the cube map, in the order they are
+        // checked. Regions are numbered with the virtual Ngons first, followed by the triplets and then the quads.
+        // The regions of bin i are m_binRegions[m_binRegionStart[i]] to m_binRegions[m_binRegionStart[i + 1] - 1]
+        std::vector<unsigned int> m_binRegionStart;
+        std::vector<unsigned int> m_binRegions;
+
         /** Return the extra loudspeakers needed to fill in the gaps in the array.
          *	This currently works for the supported arrays: 0+5+0, 0+4+0, 0+7+0
          *	See Rec. ITU-R BS.2127-0 pg. 27.
@@ -90,6 +109,46 @@ namespace spaudio {
          */
         void CalculateGainsFromRegions(CartesianPosition<double> directionUnitVec, std::vector<double>& gainsOut);
 
+        /** Build the cube map holding the regions that can have non-zero gains for the directions in each bin.
+         *  A region is added to a bin if the spherical caps bounding them overlap, so the regions checked for a direction
+         *  always include all of those that would be found by checking every region.
+         * @param regionVertices    The unit vectors of the vertices of each region, numbered as in m_binRegions. The
+         *                          virtual Ngons have one set of vertices for each of their triplets.
+         */
+        void BuildRegionLookup(const std::vector<std::vector<std::vector<CartesianPosition<double>>>>& regionVertices);
+
+        /** Get the bin of the cube map containing a direction.
+         * @param directionUnitVec  Unit vector in the direction.
+         * @return                  The index of the bin.
+         */
+        static unsigned int GetCubeMapBin(const std::vector<double>& directionUnitVec);
+
+        /** Calculate the gains of a region and add them to the output if they are not zero.
+         * @param iRegion   The region index, numbered as in m_binRegions.
+         * @param gainsOut  Output vector of the panning gains.
+         * @return          Returns true if the gains of the region are not zero.
+         */
+        bool CalculateRegionGains(unsigned int iRegion, std::vector<double>& gainsOut);
+
+        /** Calculate the gains of a batch of directions on the internal layout.
+         * @param directions    The directions of the sources.
+         * @param nDirections   The number of directions.
+         * @param gainsOut      Output array of nDirections * m_internalLayout.getNumChannels() gains.
+         */
+        void CalculateGainsFromRegions(const CartesianPosition<double>* directions, unsigned int nDirections, double* gainsOut) const;
+
+        /** Downmix the gains on the internal layout to the output layout.
+         * @param internalGains The gains for each loudspeaker in the internal layout.
+         * @param gainsOut      Output gains for each loudspeaker in the output layout.
+         */
+        void DownmixGains(const double* internalGains, double* gainsOut) const;
+
+        template<typename T>
+        void CalculateGainsBatch(const CartesianPosition<double>* directions, size_t nDirections, T* gainsOut) const;
+
+        // The maximum number of directions processed at once by the batch gain calculation
+        static const unsigned int kBatchSize = 4096;
+
         /** Check the layout for M+SC and M-SC speakers and checks if they are in the narrow (5 < az < 25)
          *  or wide (35 < az < 60) for each of the two speakers.
          *  This function assumes that the layout includes M+SC and M-SC. If it does not then wideLeft and
@@ -79,6 +79,14 @@ namespace spaudio {
         Triplet(std::vector<unsigned int> chanInds, std::vector<PolarPosition<double>> polPos);
 
         void CalculateGains(const std::vector<double>& directionUnitVec, std::vector<double>& gainsOut);
+        void CalculateGains(const double* directionUnitVec, double* gainsOut) const;
+
+        /** Calculate the gains for a batch of directions. Directions outside of the triplet are given zero gains.
+         * @param directionUnitVecs Pointers to the x, y and z components of the unit vectors of the directions.
+         * @param nDirections       The number of directions.
+         * @param gainsOut          Pointers to the 3 arrays holding the gain of each loudspeaker for each direction.
+         */
+        void CalculateGains(const double* const* directionUnitVecs, unsigned int nDirections, double* const* gainsOut) const;
 
     private:
         // Inverse of the matrix holding the triplet unit vectors
@@ -96,14 +104,13 @@ namespace spaudio {
         VirtualNgon(std::vector<unsigned int> chanInds, std::vector<PolarPosition<double>> polPos, PolarPosition<double> centrePosition);
 
         void CalculateGains(const std::vector<double>& directionUnitVec, std::vector<double>& gainsOut);
+        void CalculateGains(const double* directionUnitVec, double* gainsOut) const;
 
     private:
         std::vector<Triplet> m_triplets;
         double m_downmixCoefficient;
         // The number of channels in the Ngon
         unsigned int m_nCh = 0;
-        // Temp vector holding gains of a triplet
-        std::vector<double> m_tripletGains;
     };
 
     /**
@@ -115,9 +122,10 @@ namespace spaudio {
     public:
         QuadRegion(std::vector<unsigned int> chanInds, std::vector<PolarPosition<double>> polPos);
 
-        double GetPanningValue(const std::vector<double>& directionUnitVec, std::vector<std::vector<double>>& xprodTerms);
+        double GetPanningValue(const double* directionUnitVec, const std::vector<std::vector<double>>& xprodTerms) const;
 
         void CalculateGains(const std::vector<double>& directionUnitVec, std::vector<double>& gainsOut);
+        void CalculateGains(const double* directionUnitVec, double* gainsOut) const;
 
     private:
         std::vector<std::vector<double>> CalculatePolyXProdTerms(const std::vector<CartesianPosition<double>>& quadVertices);
@@ -129,10 +137,6 @@ namespace spaudio {
         // The cross product terms from the final equation in section 6.1.2.3.2 (pg 24)
         std::vector<std::vector<double>> m_polynomialXProdX;
         std::vector<std::vector<double>> m_polynomialXProdY;
-
-        // Temp vectors for gain calculation
-        std::vector<double> m_gainsTmp;
-        std::vector<double> m_gP;
     };
 
     struct LayoutRegions
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 #include "Ambisonics.h"
@@ -22,8 +24,10 @@
 #include "Tools.h"
 #include "Conversions.h"
 #include "GainInterp.h"
+#include "GainInterpBank.h"
 #include "DirectSpeakerGainCalc.h"
 #include "Decorrelator.h"
+#include "ConfigCache.h"
 #include "GainCalculator.h"
 
 namespace spaudio {
@@ -76,6 +80,17 @@ namespace spaudio {
          */
         void AddObject(float* pIn, unsigned int nSamples, const ObjectMetadata& metadata, unsigned int nOffset = 0);
 
+        /** Add a group of audio Objects to be rendered. This gives the same result as calling AddObject() for each
+         *	Object but mixes them to the speaker buses together, which is faster when there are many Objects.
+         *
+         * @param ppIn		Array of pointers to the object buffers to be rendered. Size nObjects x nSamples.
+         * @param pMetadata	Array of metadata for each of the object streams. Size nObjects.
+         * @param nObjects	Number of Objects.
+         * @param nSamples	Number of samples in each stream.
+         * @param nOffset	Number of samples of delay to applied to the signals.
+         */
+        void AddObjects(float** ppIn, const ObjectMetadata* pMetadata, unsigned int nObjects, unsigned int nSamples, unsigned int nOffset = 0);
+
         /** Adds an HOA stream to be rendered. Currently only supports SN3D normalisation.
          *
          * @param pHoaIn	The HOA audio channels to be rendered of size nAmbiCh x nSamples
@@ -127,6 +142,105 @@ namespace spaudio {
          */
         void SetOutputGain(double outGain);
 
+        /** Set the number of worker threads used to render the Object, DirectSpeaker and HOA streams.
+         *  With more than one worker, each stream added to the renderer is queued and rendered on a worker thread
+         *  while the caller continues to add streams. Each worker accumulates to its own speaker buses, which
+         *  are summed in a fixed order in GetRenderedAudio() so the output does not depend on thread timing.
+         *  The same stream is always rendered by the same worker so its metadata is applied in the order it was added.
+         *  The input audio is copied so the buffers passed to AddObject(), AddDirectSpeaker() and AddHoa() can
+         *  be reused immediately. Can be called before or after Configure(), and between adding streams and calling
+         *  GetRenderedAudio(), in which case the streams already added are still included in the rendered audio.
+         *
+         * @param nWorkers	The number of worker threads. 0 or 1 renders on the calling thread (the default).
+         * @return			Returns true if the workers were successfully set up.
+         */
+        bool SetWorkerCount(unsigned int nWorkers);
+
+        /** Get the number of worker threads used to render the streams.
+         * @return Number of workers, or 0 if rendering on the calling thread.
+         */
+        unsigned int GetWorkerCount() const;
+
+        /** Set the number of frames of latency with which Object gains are applied. With a latency of 0 (the default)
+         *  the gains are calculated in AddObject() whenever the metadata changes, which can take a long time for Objects
+         *  with extent, divergence or zone exclusion. With a latency of nFrames the metadata is instead passed to a
+         *  background thread and the gains are applied nFrames frames (calls to GetRenderedAudio()) later, at the same
+         *  offset within the frame. If the gains are not ready by then the previous gains are kept until they are,
+         *  so AddObject() never waits for the calculation. Can be called before or after Configure().
+         *
+         * @param nFrames	The number of frames of latency. 0 calculates the gains in AddObject().
+         */
+        void SetObjectGainLatency(unsigned int nFrames);
+
+        /** Get the number of frames of latency with which Object gains are applied.
+         * @return Number of frames of latency, or 0 if the gains are calculated in AddObject().
+         */
+        unsigned int GetObjectGainLatency() const;
+
+        /** Configure the cache of Object gains. When enabled, the gains of the most recently used Object metadata are
+         *  stored so that Objects returning to a previous position, extent etc. do not need their gains calculated again.
+         *  With non-zero step sizes the metadata is rounded before the gains are calculated so that nearby positions
+         *  share gains. Each gain calculator (one per worker) has its own cache of the specified size.
+         *  Can be called before or after Configure().
+         *
+         * @param settings	The maximum number of cached gain vectors (0 to disable) and the rounding of the metadata.
+         */
+        void SetObjectGainCache(const adm::ObjectGainCacheSettings& settings);
+
+        /** Get the total usage of the Object gain caches since they were last configured.
+         * @return The number of cache hits, misses and entries.
+         */
+        adm::ObjectGainCacheStatistics GetObjectGainCacheStatistics() const;
+
+        /** Configure the cache of the spread panner gains used for polar Object extent. When enabled, the gains of the
+         *  most recently used extents are stored so that Objects sharing an extent, or with depth, do not need them
+         *  calculated again. With a non-zero step size the direction, width and height are rounded before the gains are
+         *  calculated. Each gain calculator (one per worker) has its own cache of the specified size.
+         *  Can be called before or after Configure().
+         *
+         * @param settings	The maximum number of cached gain vectors (0 to disable) and the rounding of the extent.
+         */
+        void SetExtentGainCache(const adm::ExtentGainCacheSettings& settings);
+
+        /** Get the total usage of the extent gain caches since they were last configured.
+         * @return The number of cache hits, misses and entries.
+         */
+        adm::ExtentGainCacheStatistics GetExtentGainCacheStatistics() const;
+
+        /** Get the total number of DirectSpeaker gain calculations that reused the gains of the previous metadata of
+         *  the track, because it had not changed, and the number that had to calculate them.
+         * @return The number of cache hits and misses.
+         */
+        adm::DirectSpeakerGainCacheStatistics GetDirectSpeakerGainCacheStatistics() const;
+
+        /** Wait until the background thread has calculated the gains of all the Object metadata added so far.
+         *  This makes the output independent of thread timing (e.g. for offline rendering) but should not be
+         *  called from a real-time thread. Has no effect if the Object gain latency is 0.
+         */
+        void WaitForObjectGains();
+
+        /** Set a directory in which to cache the data calculated by Configure(): the HOA decoder, the decorrelation
+         *  filters, the spread panner gains and the binaural filters. When Configure() is next called with the same
+         *  layout, loudspeaker positions, HOA order, sample rate, block size and HRTF file the data is loaded from the
+         *  directory instead of being calculated. The directory must already exist. Takes effect at the next Configure().
+         *  Data that is shared with another renderer in the process is not loaded from or saved to the directory.
+         *
+         * @param directory	The cache directory. An empty string (the default) disables the cache.
+         */
+        void SetConfigCacheDirectory(const std::string& directory);
+
+        /** Get the path of the cache file used by the last call to Configure().
+         * @return Path of the cache file, or an empty string if the cache was not used.
+         */
+        std::string GetConfigCachePath() const;
+
+        /** Get the number and size of the read-only tables calculated by Configure() that are in use by all of the
+         *  renderers in the process. Renderers with the same configuration share a single copy of each table.
+         *
+         * @return The statistics of the shared tables.
+         */
+        static SharedTableStatistics GetSharedTableStatistics();
+
     private:
         OutputLayout m_RenderLayout;
         // Number of channels in the array (use virtual speakers for binaural rendering)
@@ -152,21 +266,11 @@ namespace spaudio {
         // in the stream at configuration
         std::map<int, int> m_channelToObjMap;
 
-        // Object metadata for internal use when converting to polar coordinates
-        ObjectMetadata m_objMetaDataTmp;
-
-        // Temp DirectSpeaker metadata when in binaural mode to ensure only the desired gain calculation elements are used
-        DirectSpeakerMetadata m_dirSpkBinMetaDataTmp;
-
         // The channel indices of the tracks that can use a point source panner
         std::vector<std::pair<unsigned int, TypeDefinition>> m_pannerTrackInd;
-        // Gain interpolators
-        std::vector<GainInterp<double>> m_gainInterpDirect;
-        std::vector<GainInterp<double>> m_gainInterpDiffuse;
-        // The gain calculator for Object type channels
-        std::unique_ptr<adm::ObjectGainCalculator> m_objectGainCalc;
-        // The gain calculator for the DirectSpeaker channels
-        std::unique_ptr<adm::DirectSpeakersGainCalc> m_directSpeakerGainCalc;
+        // Gain interpolators for the direct and diffuse paths of every Object
+        GainInterpBank m_gainInterpDirect;
+        GainInterpBank m_gainInterpDiffuse;
         // Gain interpolators for DirectSpeaker streams
         std::vector<GainInterp<double>> m_directSpeakerGainInterp;
         // Time in samples to interpolate from one metadata or output gain to the next
@@ -215,10 +319,177 @@ namespace spaudio {
         std::unique_ptr<float[]> m_pZeros;
         void ClearHoaBuffer();
 
-        // Temp vectors
-        std::vector<double> m_directGains;
-        std::vector<double> m_diffuseGains;
-        std::vector<double> m_directSpeakerGains;
+        // Calculates the Object gains on a background thread when the Object gain latency is not zero
+        struct ObjectGainRequest;
+        struct ObjectGainResult;
+        struct AsyncGainCalc;
+        // The number of frames of latency with which Object gains are applied
+        unsigned int m_objectGainLatency = 0;
+        // Settings of the cache in every Object gain calculator
+        adm::ObjectGainCacheSettings m_objectGainCacheSettings;
+        // Settings of the extent cache in every Object gain calculator
+        adm::ExtentGainCacheSettings m_extentGainCacheSettings;
+        // The number of frames rendered since Configure()
+        uint64_t m_frameIndex = 0;
+
+        // Directory in which the data calculated by Configure() is cached. Empty if disabled
+        std::string m_configCacheDirectory;
+        // Path of the cache file used by the last call to Configure()
+        std::string m_configCachePath;
+        // The cache of the data calculated by the last call to Configure(). Null if its key could not be made
+        std::unique_ptr<ConfigCache> m_configCache;
+
+        /** Add everything the cached data depends on to the key of the cache.
+         * @param cache         The cache.
+         * @param nSampleRate   The sample rate passed to Configure().
+         * @param HRTFPath      The HRTF file passed to Configure().
+         * @return              Returns false if the HRTF file could not be read.
+         */
+        bool AddConfigToCacheKey(ConfigCache& cache, unsigned int nSampleRate, const std::string& HRTFPath) const;
+
+        /** The gain calculators, temporary data and speaker buses used to render Object and DirectSpeaker streams.
+         *  Each worker thread has its own so that streams can be rendered in parallel.
+         */
+        struct MixContext
+        {
+            // The gain calculator for Object type channels
+            std::unique_ptr<adm::ObjectGainCalculator> objectGainCalc;
+            // The gain calculator for the DirectSpeaker channels
+            std::unique_ptr<adm::DirectSpeakersGainCalc> directSpeakerGainCalc;
+            // Object metadata for internal use when converting to polar coordinates
+            ObjectMetadata objMetaDataTmp;
+            // Temp DirectSpeaker metadata when in binaural mode to ensure only the desired gain calculation elements are used
+            DirectSpeakerMetadata dirSpkBinMetaDataTmp;
+            // Temp vectors
+            std::vector<double> directGains;
+            std::vector<double> diffuseGains;
+            std::vector<double> directSpeakerGains;
+            // The background Object gain calculation. Null when the Object gain latency is 0
+            std::unique_ptr<AsyncGainCalc> asyncGainCalc;
+            // Buses to which the DirectSpeaker, direct Object and diffuse Object signals are accumulated
+            float** speakerOut = nullptr;
+            float** speakerOutDirect = nullptr;
+            float** speakerOutDiffuse = nullptr;
+        };
+        // Context used when rendering on the calling thread. Its buses are m_speakerOut, m_speakerOutDirect and m_speakerOutDiffuse
+        MixContext m_mixContext;
+        // Object indices and input pointers of the Objects passed to AddObjects()
+        std::vector<unsigned int> m_batchObjectInds;
+        std::vector<const float*> m_batchObjectInputs;
+        // Flag for each Object if it is in the current batch
+        std::vector<char> m_isObjectInBatch;
+        // Flag for each Object if gains have been passed to its gain interpolators
+        std::vector<char> m_objectHasGains;
+
+        /** Set up the gain calculators and temporary vectors of a context for the current layout.
+         * @param context The context to configure.
+         * @param pCache  (Optional) Cache of the data calculated for the layout.
+         */
+        void ConfigureMixContext(MixContext& context, ConfigCache* pCache = nullptr);
+
+        /** Calculate the gains for an Object if its metadata has changed and pass them to the gain interpolators.
+         *  If the Object gain latency is not zero the metadata is queued to the background thread and any gains
+         *  that are due are passed to the gain interpolators instead.
+         * @param context	The context to use to calculate the gains.
+         * @param iObj		Index of the Object.
+         * @param metadata	Metadata for the object stream.
+         * @param nOffset	Number of samples of delay to applied to the signal.
+         * @return			Returns false if the Object has no gains yet so does not need to be mixed.
+         */
+        bool UpdateObjectGains(MixContext& context, int iObj, const ObjectMetadata& metadata, unsigned int nOffset);
+
+        /** Set up the background Object gain calculation of a context for the current Object gain latency.
+         * @param context The context to configure.
+         */
+        void ConfigureAsyncGainCalc(MixContext& context);
+
+        /** Pass the gains calculated by the background thread of a context that are due to the gain interpolators of an Object.
+         * @param context	The context whose background thread calculated the gains.
+         * @param iObj			Index of the Object.
+         * @param frameIndex	The current frame.
+         * @param nOffset		Offset in the current frame of the signal about to be rendered.
+         */
+        void ApplyDueObjectGains(MixContext& context, int iObj, uint64_t frameIndex, unsigned int nOffset);
+
+        /** Wait for the background thread of a context to calculate all the queued gains and pass the most recent gains
+         *  of every Object to the gain interpolators, whether or not they are due.
+         * @param context The context to flush.
+         */
+        void FlushObjectGains(MixContext& context);
+
+        /** Get all the contexts used to render Objects.
+         * @return Pointers to the contexts.
+         */
+        std::vector<MixContext*> GetMixContexts();
+
+        /** Get the index of the Object with the track index in the metadata.
+         * @param metadata	Metadata for the object stream.
+         * @return			Index of the Object, or -1 if the track was not declared as an Object.
+         */
+        int GetObjectIndex(const ObjectMetadata& metadata);
+
+        /** Calculate the gains for an Object and add it to the buses of the context.
+         * @param context	The context to use to calculate the gains and to accumulate the signal.
+         * @param iObj		Index of the Object.
+         * @param metadata	Metadata for the object stream.
+         * @param pIn		Pointer to the object buffer to be rendered.
+         * @param nSamples	Number of samples in the stream.
+         * @param nOffset	Number of samples of delay to applied to the signal.
+         */
+        void MixObject(MixContext& context, int iObj, const ObjectMetadata& metadata, const float* pIn, unsigned int nSamples, unsigned int nOffset);
+
+        /** Mix the Objects in m_batchObjectInds to the Object buses and clear their batch flags.
+         * @param nSamples	Number of samples in the streams.
+         * @param nOffset	Number of samples of delay to applied to the signals.
+         */
+        void MixObjectBatch(unsigned int nSamples, unsigned int nOffset);
+
+        /** Calculate the gains for a DirectSpeaker and add it to the buses of the context.
+         * @param context	The context to use to calculate the gains and to accumulate the signal.
+         * @param iDirSpk	Index of the DirectSpeaker.
+         * @param metadata	Metadata for the DirectSpeaker stream.
+         * @param pIn		Pointer to the DirectSpeaker buffer to be rendered.
+         * @param nSamples	Number of samples in the stream.
+         * @param nOffset	Number of samples of delay to applied to the signal.
+         */
+        void MixDirectSpeaker(MixContext& context, int iDirSpk, const DirectSpeakerMetadata& metadata, const float* pIn, unsigned int nSamples, unsigned int nOffset);
+
+        /** Add a channel of an HOA stream to the HOA buffer.
+         * @param iHoaCh				The HOA channel to write to.
+         * @param pIn					Pointer to the HOA channel to be rendered.
+         * @param nSamples				Number of samples in the stream.
+         * @param nOffset				Number of samples of delay to applied to the signal.
+         * @param gain					The metadata gain.
+         * @param normConversionGain	Gain to convert the channel to SN3D.
+         */
+        void MixHoaChannel(unsigned int iHoaCh, const float* pIn, unsigned int nSamples, unsigned int nOffset, double gain, float normConversionGain);
+
+        // Worker threads used to render the streams in parallel. Empty when rendering on the calling thread
+        struct Job;
+        struct Worker;
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        // The number of workers requested with SetWorkerCount()
+        unsigned int m_nWorkers = 0;
+
+        /** Create the worker threads and their contexts.
+         * @param pCache  (Optional) Cache of the data calculated for the layout.
+         */
+        bool StartWorkers(ConfigCache* pCache = nullptr);
+
+        /** Stop and destroy the worker threads. The streams they have been given are rendered and added to the output first. */
+        void StopWorkers();
+
+        /** Get a job in the queue of the worker with the specified index. SubmitJob() must be called once it is filled in. */
+        Job& GetNextJob(unsigned int iWorker);
+
+        /** Queue the job returned by the previous call to GetNextJob(). */
+        void SubmitJob(unsigned int iWorker);
+
+        /** Wait until the workers have rendered all the queued jobs. */
+        void WaitForWorkers();
+
+        /** Add the speaker buses of the workers to the output buses and clear them. */
+        void SumWorkerBuses();
 
         /** Find the element of a vector matching the input. If the track types do not match or no matching elements then returns -1 */
         int GetMatchingIndex(const std::vector<std::pair<unsigned int, TypeDefinition>>& vector, unsigned int nElement, TypeDefinition trackType);
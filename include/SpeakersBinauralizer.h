@@ -47,7 +47,9 @@ namespace spaudio {
             unsigned /* nBlockSize */,
             unsigned& /* tailLength */,
             std::string /* HRTFPath */,
-            bool /* lowCpuMode */) override { return false; };
+            bool /* lowCpuMode */,
+            bool /* combineShelfFilters */,
+            ConfigCache* /* pCache */) override { return false; };
 
     protected:
         unsigned m_nSpeakers;
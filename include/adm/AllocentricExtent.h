@@ -61,8 +61,26 @@ namespace spaudio {
 
             // Individual axis gains for all loudspeakers
             std::vector<double> m_gx, m_gy, m_gz;
+
+            /** The individual axis gains of all loudspeakers at every grid coordinate for a set of excluded loudspeakers.
+             *  The x-, y- and z-axis gains only depend on the x, y and z grid coordinates respectively so they are stored
+             *  for each coordinate along the axis rather than for every grid point.
+             */
+            struct GridGains
+            {
+                std::vector<bool> excluded;
+                // Gains of size m_xs.size() x nLdspk, m_ys.size() x nLdspk and m_zs.size() x nLdspk
+                std::vector<double> gx, gy, gz;
+            };
+            // Grid gains for the most recently used sets of excluded loudspeakers, most recent first
+            std::vector<GridGains> m_gridGainsCache;
+            const unsigned int m_nMaxCachedGridGains = 4;
             // Weighted sum of gains in each axis for all loudspeakers
             std::vector<double> m_fx, m_fy, m_fz;
+            // Weights at each coordinate along each axis of the grid
+            std::vector<double> m_wx, m_wy, m_wz;
+            // Flag for each z coordinate of the grid if it is used for the current layout and excluded loudspeakers
+            std::vector<char> m_isZUsed;
             // Inside gains
             std::vector<double> m_gInside;
             // Boundary gains
@@ -78,10 +96,25 @@ namespace spaudio {
             // Intermediate boundary gains
             std::vector<double> m_bFloor, m_bCeil, m_bLeft, m_bRight, m_bFront, m_bBack;
 
+            /** Get the grid gains for a set of excluded loudspeakers. They are only calculated if they are not in the cache.
+             * @param excluded Which loudspeakers are excluded.
+             * @return The individual axis gains at each grid coordinate.
+             */
+            const GridGains& getGridGains(const std::vector<bool>& excluded);
+
             double calculateSEff(const std::vector<CartesianPosition<double>>& cartesianPositions, const std::vector<bool>& excluded, double sx, double sy, double sz);
 
             std::tuple<double, double, double> calculateWeights(double xs, double ys, double zs, double xo, double yo, double zo, double sx, double sy, double sz);
 
+            /** Add (w * g)^p to f for each loudspeaker.
+             * @param w			The weight.
+             * @param g			The gains of each loudspeaker.
+             * @param p			The exponent.
+             * @param f			The sums of each loudspeaker to add to.
+             * @param nLdspk	The number of loudspeakers.
+             */
+            void accumulatePoweredGains(double w, const double* g, double p, double* f, unsigned int nLdspk);
+
             /** Normalisation of the gains with a check for small norms
              * @param gains Gains to be normalised.
              */
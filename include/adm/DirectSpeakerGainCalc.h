@@ -21,9 +21,22 @@
 #include "PointSourcePannerGainCalc.h"
 #include "Screen.h"
 
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
 namespace spaudio {
     namespace adm {
 
+        /** The usage of the gains stored for each track by DirectSpeakersGainCalc. */
+        struct DirectSpeakerGainCacheStatistics
+        {
+            // Number of calls that used the stored gains of the track
+            uint64_t hits = 0;
+            // Number of calls that had to calculate the gains
+            uint64_t misses = 0;
+        };
+
         /** A class to calculate the gains to be applied to a set of loudspeakers for DirectSpeaker processing. */
         class DirectSpeakersGainCalc
         {
@@ -38,6 +51,12 @@ namespace spaudio {
              */
             void calculateGains(const DirectSpeakerMetadata& metadata, std::vector<double>& gainsOut);
 
+            /** Get the number of calls to calculateGains() that used the gains stored for the track, because its
+             *  metadata had not changed, and the number that had to calculate them. Can be called from any thread.
+             * @return The number of cache hits and misses.
+             */
+            DirectSpeakerGainCacheStatistics GetCacheStatistics() const;
+
         private:
             unsigned int m_nCh = 0;
             Layout m_layout;
@@ -50,6 +69,48 @@ namespace spaudio {
 
             std::vector<unsigned int> m_withinBounds;
 
+            // The nominal speaker labels are identified by their index in bs2094::channelLabels. This maps each speaker
+            // label that has been seen to the index of its nominal label
+            std::unordered_map<std::string, unsigned int> m_nominalLabelIds;
+            // The index of the channel in the layout with each nominal label, or -1 if there is none
+            std::vector<int> m_labelChannels;
+            // Flag if each nominal label is an LFE label
+            std::vector<bool> m_labelIsLfe;
+            // The index of the LFE1 channel in the layout, or -1 if there is none
+            int m_lfeChannel = -1;
+
+            // Maps the ITU audioPackFormatIDs to the index of their layout in m_packRules
+            std::unordered_map<std::string, unsigned int> m_packLayoutIds;
+            // The index in m_ruleGains of the first mapping rule that applies to each pack layout and nominal label
+            // on the output layout, stored in m_packRules[iPackLayout * nLabels + iLabel]. -1 if no rule applies
+            std::vector<int> m_packRules;
+            // The output channel indices and gains of the mapping rules that apply to the output layout
+            std::vector<std::vector<std::pair<unsigned int, double>>> m_ruleGains;
+
+            // The last metadata of each track and the gains calculated for it
+            struct TrackGains
+            {
+                DirectSpeakerMetadata metadata;
+                std::vector<double> gains;
+            };
+            std::unordered_map<unsigned int, TrackGains> m_trackGains;
+            std::atomic<uint64_t> m_cacheHits{ 0 };
+            std::atomic<uint64_t> m_cacheMisses{ 0 };
+
+            /** Calculate the gain vector corresponding to the metadata input without using the stored gains.
+             *
+             * @param metadata	DirectSpeaker metadata.
+             * @param gainsOut	Return of the gain vector corresponding to the input metadata.
+             */
+            void CalculateSpeakerGains(const DirectSpeakerMetadata& metadata, std::vector<double>& gainsOut);
+
+            /** Check if two sets of metadata give the same gains. The gain and track index are ignored.
+             * @param a First metadata.
+             * @param b Second metadata.
+             * @return  Returns true if the gains are the same.
+             */
+            static bool HasSameGains(const DirectSpeakerMetadata& a, const DirectSpeakerMetadata& b);
+
             /** Find the closest speaker in the layout within the tolerance bounds set.
              *
              * @param direction	Polar position of the DirectSpeaker
@@ -68,6 +129,16 @@ namespace spaudio {
              * @return				Returns true if a mapping rule applies.
              */
             bool MappingRuleApplies(const MappingRule& rule, const std::string& input_layout, const std::string& speakerLabel, Layout& output_layout);
+
+            /** Build the tables used to look up the mapping rules and channels for the nominal speaker labels. */
+            void CompileMappingRules();
+
+            /** Get the index of the nominal label of a speaker label in bs2094::channelLabels. The string search
+             *  is only done the first time each label is seen.
+             * @param speakerLabel  The speaker label from the metadata.
+             * @return              The index of the nominal label.
+             */
+            unsigned int GetNominalLabelId(const std::string& speakerLabel);
         };
 
     } // namespace adm
@@ -20,9 +20,39 @@
 #include "AmbisonicEncoder.h"
 #include "Screen.h"
 
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
 namespace spaudio {
     namespace adm {
 
+        /** Settings of the cache of gains in ObjectGainCalculator. Before looking up or calculating the gains, the
+         *  metadata values are rounded to the nearest multiple of the step sizes, so all the metadata that rounds
+         *  to the same values gets the same gains. With step sizes of 0 the values must match exactly.
+         */
+        struct ObjectGainCacheSettings
+        {
+            // The maximum number of gain vectors to store. The least recently used is discarded when it is full. 0 disables the cache
+            unsigned int maxEntries = 0;
+            // Step in degrees of the azimuth, elevation, width, height and divergence azimuth range
+            double angleStep = 0.;
+            // Step of the distance, Cartesian coordinates, depth, divergence value and divergence position range
+            double linearStep = 0.;
+        };
+
+        /** The usage of the cache of gains in ObjectGainCalculator. */
+        struct ObjectGainCacheStatistics
+        {
+            // Number of calls that used gains from the cache
+            uint64_t hits = 0;
+            // Number of calls that had to calculate the gains
+            uint64_t misses = 0;
+            // Number of gain vectors currently stored
+            size_t nEntries = 0;
+        };
+
         /** A class to apply ChannelLocking as described in Rec. ITU-R BS.2127-1 sec. 7.3.6 pg44. */
         class ChannelLockHandler
         {
@@ -144,7 +174,12 @@ namespace spaudio {
         class ObjectGainCalculator
         {
         public:
-            ObjectGainCalculator(Layout outputLayoutNoLFE);
+            /** Set up the gain calculator for the output layout.
+             * @param outputLayoutNoLFE The output layout.
+             * @param pCache            (Optional) Cache from which data calculated for the layout is loaded, or to
+             *                          which it is added if not found. Its key must include the layout.
+             */
+            ObjectGainCalculator(Layout outputLayoutNoLFE, ConfigCache* pCache = nullptr);
             ~ObjectGainCalculator();
 
             /** Calculate the panning (loudspeaker or HOA) gains to apply to a
@@ -156,6 +191,30 @@ namespace spaudio {
              */
             void CalculateGains(const ObjectMetadata& metadata, std::vector<double>& directGains, std::vector<double>& diffuseGains);
 
+            /** Configure the cache of gains. The spatial gains (before the metadata gain and diffuseness are applied) are
+             *  stored for the most recently used metadata so they do not have to be calculated again when an Object
+             *  returns to a previous position. Previously stored gains are discarded.
+             *
+             * @param settings	The cache size and the rounding applied to the metadata.
+             */
+            void ConfigureCache(const ObjectGainCacheSettings& settings);
+
+            /** Get the usage of the cache since it was configured. Can be called from any thread.
+             * @return The number of cache hits, misses and entries.
+             */
+            ObjectGainCacheStatistics GetCacheStatistics() const;
+
+            /** Configure the cache of the spread panner gains used for polar extent. Previously stored gains are discarded.
+             *
+             * @param settings	The cache size and the rounding applied to the direction and extent.
+             */
+            void ConfigureExtentCache(const ExtentGainCacheSettings& settings);
+
+            /** Get the usage of the extent cache since it was configured. Can be called from any thread.
+             * @return The number of cache hits, misses and entries.
+             */
+            ExtentGainCacheStatistics GetExtentCacheStatistics() const;
+
         private:
             // The output layout
             Layout m_outputLayout;
@@ -193,6 +252,40 @@ namespace spaudio {
             bool m_cartesianLayout = false;
             ObjectMetadata m_objMetadata;
 
+            ObjectGainCacheSettings m_cacheSettings;
+            // Metadata rounded to the cache step sizes
+            ObjectMetadata m_roundedMetadata;
+            // The values of the metadata that affect the spatial gains used to look up the cache
+            std::vector<double> m_cacheKey;
+            struct CacheKeyHash
+            {
+                size_t operator()(const std::vector<double>& key) const;
+            };
+            struct CacheEntry
+            {
+                std::vector<double> gains;
+                // Position of the entry in m_cacheOrder
+                std::list<const std::vector<double>*>::iterator order;
+            };
+            std::unordered_map<std::vector<double>, CacheEntry, CacheKeyHash> m_cache;
+            // Keys of the cache entries from the most to the least recently used
+            std::list<const std::vector<double>*> m_cacheOrder;
+            std::atomic<uint64_t> m_cacheHits{ 0 };
+            std::atomic<uint64_t> m_cacheMisses{ 0 };
+            std::atomic<size_t> m_cacheSize{ 0 };
+
+            /** Calculate the spatial gains of the Object without LFE channels, before the metadata gain and diffuseness are applied.
+             * @param metadata	Object metadata to be used to calculate the gains.
+             * @param gains		Output vector of gains of size m_nChNoLFE.
+             */
+            void CalculateSpatialGains(const ObjectMetadata& metadata, std::vector<double>& gains);
+
+            /** Round the metadata values to the cache step sizes and fill m_cacheKey with the values that affect the spatial gains.
+             * @param metadata			The Object metadata.
+             * @param roundedMetadata	Output copy of the metadata with rounded values.
+             */
+            void GetCacheKey(const ObjectMetadata& metadata, ObjectMetadata& roundedMetadata);
+
             /** Get the diverged source positions and directions. See Rec. ITU-R BS.2127-1 sec. 7.3.7 pg. 45.
             * @param objectDivergence		Optional object divergence. If not set then returns original position with a single unity gain.
             * @param position				The position of the source.
@@ -12,12 +12,22 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
 #include "Coordinates.h"
 #include "Tools.h"
 #include "PointSourcePannerGainCalc.h"
 #include "AmbisonicSource.h"
 
 namespace spaudio {
+
+    class ConfigCache;
+
     namespace adm {
 
         /*
@@ -37,7 +47,13 @@ namespace spaudio {
         class SpreadPanner
         {
         public:
-            SpreadPanner(PointSourcePannerGainCalc& psp);
+            /** Calculates the panning gains of the virtual sources.
+             * @param psp       The point source panner used to calculate the gains.
+             * @param pCache    (Optional) Cache from which the virtual source gains are loaded, or to which they are
+             *                  added if not found. The gains are shared with other panners using a cache with the
+             *                  same key. Its key must include the layout used by psp.
+             */
+            SpreadPanner(PointSourcePannerGainCalc& psp, ConfigCache* pCache = nullptr);
             ~SpreadPanner();
 
             /** Calculate the gains for a source in the defined direction and with the specified width and height.
@@ -52,13 +68,27 @@ namespace spaudio {
             PointSourcePannerGainCalc& m_pointSourcePannerGainCalc;
             unsigned int m_nCh = 0;
 
-            std::vector<CartesianPosition<double>> m_virtualSourcePositions;
-            std::vector<std::vector<double>> m_virtualSourcePanningVectors;
+            // The virtual source directions and their panning gains, which only depend on the layout
+            struct VirtualSources
+            {
+                std::vector<CartesianPosition<double>> positions;
+                // The panning gains of size nVirtualSources x nCh
+                std::vector<double> gains;
+                // The sources are on rows of equal elevation with equally spaced azimuths starting from 0 degrees.
+                // Row i holds the sources rowStart[i] to rowStart[i + 1] - 1
+                std::vector<double> rowElevation;
+                std::vector<unsigned int> rowStart;
+            };
+            // Read-only so that they can be shared with other panners for the same layout
+            std::shared_ptr<const VirtualSources> m_virtualSources;
 
             // The number of virtual source positions
             int m_nVirtualSources;
-            // The weights to be applied to the virtual sources
+            // The indices of the virtual sources with non-zero weights and the weights to be applied to them
+            std::vector<unsigned int> m_activeSources;
             std::vector<double> m_weights;
+            // The indices of the virtual sources that may have non-zero weights
+            std::vector<unsigned int> m_candidateSources;
 
             // The last set width and heights
             double m_width = 0.;
@@ -91,6 +121,13 @@ namespace spaudio {
              */
             double CalculateWeights(CartesianPosition<double> position);
 
+            /** Calculate the virtual source directions and their panning gains, loading the gains from the cache
+             *  if they are available.
+             * @param pCache    (Optional) Cache of the data calculated for the layout.
+             * @return          The virtual sources.
+             */
+            std::shared_ptr<const VirtualSources> CalculateVirtualSources(ConfigCache* pCache);
+
             /** Calculate the rotation matrix and "stadium" for the weighting function for a source
              *  a direction specified by position and the defined width and height.
              * @param position	The centre position of the "stadium" of the weighting function.
@@ -98,14 +135,45 @@ namespace spaudio {
              * @param height	The angular height of the "stadium".
              */
             void ConfigureWeightingFunction(CartesianPosition<double> position, double width, double height);
+
+            /** Find the virtual sources within a spherical cap. Sources just outside of the cap may also be returned.
+             * @param centre    The direction of the centre of the cap.
+             * @param radius    The angular radius of the cap in degrees.
+             * @param sources   Output vector of the indices of the sources in ascending order.
+             */
+            void FindSourcesInCap(CartesianPosition<double> centre, double radius, std::vector<unsigned int>& sources) const;
         };
 
 
+        /** Settings of the cache of spread panner gains in PolarExtentHandler. Before looking up or calculating the
+         *  gains, the source direction and the modified width and height are rounded to the nearest multiple of the
+         *  step size, so all the extents that round to the same values get the same gains. With a step size of 0 the
+         *  values must match exactly.
+         */
+        struct ExtentGainCacheSettings
+        {
+            // The maximum number of gain vectors to store. The least recently used is discarded when it is full. 0 disables the cache
+            unsigned int maxEntries = 0;
+            // Step in degrees of the azimuth, elevation, width and height
+            double angleStep = 0.;
+        };
+
+        /** The usage of the cache of spread panner gains in PolarExtentHandler. */
+        struct ExtentGainCacheStatistics
+        {
+            // Number of spread panner calculations that used gains from the cache
+            uint64_t hits = 0;
+            // Number of spread panner calculations that had to calculate the gains
+            uint64_t misses = 0;
+            // Number of gain vectors currently stored
+            size_t nEntries = 0;
+        };
+
         /** Class that handles the extent parameters to calculate a gain vector */
         class PolarExtentHandler
         {
         public:
-            PolarExtentHandler(PointSourcePannerGainCalc& psp);
+            PolarExtentHandler(PointSourcePannerGainCalc& psp, ConfigCache* pCache = nullptr);
             ~PolarExtentHandler();
 
             /** Return a vector of gains for the loudspeakers in the output layout that correspond
@@ -119,6 +187,19 @@ namespace spaudio {
              */
             void handle(CartesianPosition<double> position, double width, double height, double depth, std::vector<double>& gainsOut);
 
+            /** Configure the cache of spread panner gains. The gains are stored for the most recently used extents so
+             *  that they do not have to be calculated again for the same extent on another object, a later frame or the
+             *  other distance used for the depth. Previously stored gains are discarded.
+             *
+             * @param settings	The cache size and the rounding applied to the direction and extent.
+             */
+            void ConfigureCache(const ExtentGainCacheSettings& settings);
+
+            /** Get the usage of the cache since it was configured. Can be called from any thread.
+             * @return The number of cache hits, misses and entries.
+             */
+            ExtentGainCacheStatistics GetCacheStatistics() const;
+
         private:
             PointSourcePannerGainCalc m_pointSourcePannerGainGalc;
             SpreadPanner m_spreadPanner;
@@ -133,6 +214,26 @@ namespace spaudio {
             std::vector<double> m_g1;
             std::vector<double> m_g2;
 
+            ExtentGainCacheSettings m_cacheSettings;
+            // The direction, width and height used to look up the cache
+            using CacheKey = std::array<double, 5>;
+            struct CacheKeyHash
+            {
+                size_t operator()(const CacheKey& key) const;
+            };
+            struct CacheEntry
+            {
+                std::vector<double> gains;
+                // Position of the entry in m_cacheOrder
+                std::list<const CacheKey*>::iterator order;
+            };
+            std::unordered_map<CacheKey, CacheEntry, CacheKeyHash> m_cache;
+            // Keys of the cache entries from the most to the least recently used
+            std::list<const CacheKey*> m_cacheOrder;
+            std::atomic<uint64_t> m_cacheHits{ 0 };
+            std::atomic<uint64_t> m_cacheMisses{ 0 };
+            std::atomic<size_t> m_cacheSize{ 0 };
+
             /** Modifies the width and height extent based on the distance as described in ITU-R BS.2127-0 section 7.3.8.2.1 pg 48.
              * @param distance	The distance of the source.
              * @param extent	Width/height extent.
@@ -147,6 +248,14 @@ namespace spaudio {
              * @param gainsOut	Output vector of panning gains.
              */
             void CalculatePolarExtentGains(CartesianPosition<double> position, double width, double height, std::vector<double>& gainsOut);
+
+            /** Get the spread panner gains from the cache, calculating and adding them if they are not found.
+             * @param position	Source position.
+             * @param width		Source width in degrees.
+             * @param height	Source height in degrees.
+             * @param gainsOut	Output vector of spread panner gains.
+             */
+            void CalculateCachedSpreadGains(CartesianPosition<double> position, double width, double height, std::vector<double>& gainsOut);
         };
 
     } // namespace adm
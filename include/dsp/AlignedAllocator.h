@@ -0,0 +1,67 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  An allocator for SIMD-aligned containers                                #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      AlignedAllocator.h                                       #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace spaudio {
+
+    /** A standard allocator that returns memory aligned to the specified number of bytes
+     *  so that the data can be loaded efficiently with SIMD instructions.
+     */
+    template<typename T, std::size_t Alignment = 32>
+    class AlignedAllocator
+    {
+    public:
+        using value_type = T;
+
+        template<typename U>
+        struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+        AlignedAllocator() noexcept {}
+        template<typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+        T* allocate(std::size_t n)
+        {
+            // Over-allocate and store the original pointer just before the aligned block
+            void* pRaw = std::malloc(n * sizeof(T) + Alignment + sizeof(void*));
+            if (!pRaw)
+                throw std::bad_alloc();
+            std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(pRaw) + sizeof(void*) + Alignment - 1) & ~(std::uintptr_t)(Alignment - 1);
+            reinterpret_cast<void**>(aligned)[-1] = pRaw;
+            return reinterpret_cast<T*>(aligned);
+        }
+
+        void deallocate(T* p, std::size_t) noexcept
+        {
+            if (p)
+                std::free(reinterpret_cast<void**>(p)[-1]);
+        }
+
+        template<typename U>
+        bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+        template<typename U>
+        bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+    };
+
+    /** A vector whose data is aligned for SIMD processing. */
+    template<typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+} // namespace spaudio
@@ -0,0 +1,105 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A real-valued FFT with a selectable implementation                      #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      FFT.h                                                    #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+#include <memory>
+
+namespace spaudio {
+
+    /** The FFT implementations that the library can use. */
+    enum class FFTBackend
+    {
+        // The bundled kiss_fft. Always available
+        KissFFT,
+        // FFTW single precision. Only available when the library is built with FFTW support
+        FFTW,
+    };
+
+    class FFTImplementation;
+
+    /** A real-to-complex FFT and its complex-to-real inverse. Spectra are stored as nSize / 2 + 1 interleaved
+     *  complex values (real followed by imaginary). Neither transform is scaled, so a forward transform followed
+     *  by an inverse multiplies the signal by nSize.
+     *
+     *  The implementation is chosen when the FFT is configured. kiss_fft is always available. Faster backends can
+     *  be enabled at build time and are then used by default by all of the processing classes in the library.
+     */
+    class FFT
+    {
+    public:
+        FFT();
+        ~FFT();
+
+        /** Configure the FFT. Configuring is thread-safe so different FFT objects can be configured on
+         *  multiple threads at the same time.
+         * @param nSize     The size of the FFT. Must be even.
+         * @param backend   The implementation to use.
+         * @return          Returns true on successful configuration. Returns false if the backend is not available.
+         */
+        bool Configure(unsigned int nSize, FFTBackend backend = GetDefaultBackend());
+
+        /** Calculate the spectrum of a real signal.
+         * @param pfIn          Input signal of size nSize.
+         * @param pfSpectrum    Output interleaved spectrum of size 2 x (nSize / 2 + 1).
+         */
+        void Forward(const float* pfIn, float* pfSpectrum);
+
+        /** Calculate the real signal from its spectrum.
+         * @param pfSpectrum    Input interleaved spectrum of size 2 x (nSize / 2 + 1). It is not modified.
+         * @param pfOut         Output signal of size nSize.
+         */
+        void Inverse(const float* pfSpectrum, float* pfOut);
+
+        /** Get the size of the FFT.
+         * @return  FFT size, or 0 if not configured.
+         */
+        unsigned int GetSize() const;
+
+        /** Get the implementation in use.
+         * @return  The backend set in Configure().
+         */
+        FFTBackend GetBackend() const;
+
+        /** Get the implementation used by FFTs configured without specifying a backend. This is the fastest
+         *  available backend unless another has been set with SetDefaultBackend().
+         * @return  The default backend.
+         */
+        static FFTBackend GetDefaultBackend();
+
+        /** Set the implementation used by FFTs configured without specifying a backend. Only affects objects
+         *  configured after the call.
+         * @param backend   The backend to use.
+         * @return          Returns false if the backend is not available in this build.
+         */
+        static bool SetDefaultBackend(FFTBackend backend);
+
+        /** Check if a backend was enabled when the library was built.
+         * @param backend   The backend to check.
+         * @return          True if it can be used.
+         */
+        static bool IsBackendAvailable(FFTBackend backend);
+
+        /** Get a readable name for a backend.
+         * @param backend   The backend.
+         * @return          Name of the backend.
+         */
+        static const char* GetBackendName(FFTBackend backend);
+
+    private:
+        unsigned int m_nSize = 0;
+        FFTBackend m_backend = FFTBackend::KissFFT;
+        std::unique_ptr<FFTImplementation> m_pImpl;
+    };
+
+} // namespace spaudio
@@ -0,0 +1,181 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A uniformly partitioned multichannel convolver                          #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      FrequencyDomainConvolver.h                               #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "AlignedAllocator.h"
+#include "FFT.h"
+
+namespace spaudio {
+
+    /** A multiple-input multiple-output FIR convolver using uniformly partitioned overlap-save convolution
+     *  with a frequency-domain delay line. Each output is the sum of the inputs convolved with the filter set
+     *  for that input/output pair. Pairs without a filter are skipped.
+     *
+     *  The filters are split into partitions of equal length so the FFT size depends only on the partition
+     *  size and not on the filter length. This keeps the cost per sample roughly constant for small block sizes.
+     *  Blocks of any length can be processed without adding latency: a block that does not fill a partition is
+     *  handled by transforming the partially-filled partition and adding the precomputed contribution of the
+     *  previous partitions.
+     *
+     *  The spectra are stored in aligned split (separate real and imaginary) format so that the complex
+     *  multiply-accumulate, which dominates the cost when there are many partitions, is vectorised.
+     *
+     *  The filter spectra can be shared between convolvers with the same configuration using GetFilters() and
+     *  SetFilters(). A convolver makes its own copy if a filter is changed while they are shared.
+     */
+    class FrequencyDomainConvolver
+    {
+    public:
+        /** The filter spectra of all input/output pairs and the inputs with a filter for each output. */
+        struct FilterSet
+        {
+            unsigned int nInputs = 0;
+            unsigned int nOutputs = 0;
+            unsigned int nMaxTaps = 0;
+            unsigned int nPartitions = 0;
+            unsigned int nBinStride = 0;
+            // Filter spectra for each input/output pair. Size (nInputs * nOutputs) x nPartitions spectra
+            AlignedVector<float> spectra;
+            // The inputs that have a filter set for each output
+            std::vector<std::vector<unsigned int>> routing;
+
+            /** Get the size of the filter set in bytes. */
+            size_t GetMemoryUsage() const;
+        };
+
+        FrequencyDomainConvolver();
+        ~FrequencyDomainConvolver();
+
+        /** Configure the convolver. Previous filters and state are lost.
+         * @param nInputs           The number of input channels.
+         * @param nOutputs          The number of output channels.
+         * @param nMaxTaps          The maximum length of the filters to be set.
+         * @param nPartitionSize    The number of samples in each filter partition. Normally the expected block size.
+         *                          If it is not a power of 2 it is rounded up to the next power of 2.
+         * @return                  Returns true on successful configuration.
+         */
+        bool Configure(unsigned int nInputs, unsigned int nOutputs, unsigned int nMaxTaps, unsigned int nPartitionSize);
+
+        /** Set the filter for an input/output pair.
+         * @param iInput    The index of the input channel.
+         * @param iOutput   The index of the output channel.
+         * @param pfFilter  The time-domain filter.
+         * @param nTaps     The length of the filter. Must be less than or equal to nMaxTaps set in Configure().
+         */
+        void SetFilter(unsigned int iInput, unsigned int iOutput, const float* pfFilter, unsigned int nTaps);
+
+        /** Remove all filters so that all outputs are silent. */
+        void ClearFilters();
+
+        /** Get the filters so that they can be shared with other convolvers with the same configuration.
+         * @return  The filter set. It is not changed by later calls to SetFilter() or ClearFilters().
+         */
+        std::shared_ptr<const FilterSet> GetFilters();
+
+        /** Use a filter set from another convolver, replacing all filters.
+         * @param filters   The filter set.
+         * @return          Returns false if the filter set does not match the configuration of this convolver.
+         */
+        bool SetFilters(std::shared_ptr<const FilterSet> filters);
+
+        /** Clear the convolution state. */
+        void Reset();
+
+        /** Convolve the input signals with the filters. The input and output can point to the same buffers.
+         * @param ppfIn     Input signals of size nInputs x nSamples.
+         * @param ppfOut    Output signals of size nOutputs x nSamples.
+         * @param nSamples  The number of samples to process.
+         */
+        void Process(const float* const* ppfIn, float** ppfOut, unsigned int nSamples);
+
+        /** Get the number of samples in each partition.
+         * @return  Partition size in samples.
+         */
+        unsigned int GetPartitionSize() const;
+
+        /** Get the number of partitions the filters are split into.
+         * @return  Number of partitions.
+         */
+        unsigned int GetPartitionCount() const;
+
+    private:
+        unsigned int m_nInputs = 0;
+        unsigned int m_nOutputs = 0;
+        unsigned int m_nPartitionSize = 0;
+        unsigned int m_nPartitions = 0;
+        unsigned int m_nFFTSize = 0;
+        unsigned int m_nFFTBins = 0;
+        // Number of floats between the real and imaginary parts of a spectrum. The bins are padded to a multiple
+        // of the SIMD width so every spectrum starts on an aligned boundary
+        unsigned int m_nBinStride = 0;
+
+        // The number of samples of the current partition that have been received
+        unsigned int m_nFill = 0;
+        // Index of the most recent spectrum in the frequency-domain delay line
+        unsigned int m_iFdlHead = 0;
+
+        FFT m_fft;
+
+        // Spectra are stored in split format: the real parts followed by the imaginary parts.
+        // Input history holding the previous and current partitions for each input. Size nInputs x FFT size
+        AlignedVector<float> m_inputHistory;
+        // Spectra of the most recent complete input windows for each input. Size nInputs x (nPartitions - 1) spectra
+        AlignedVector<float> m_fdl;
+        // Spectrum of the current (possibly partially-filled) input window for each input. Size nInputs spectra
+        AlignedVector<float> m_inputSpectrum;
+        // The filters, which are only written to when they are not shared with another convolver
+        std::shared_ptr<FilterSet> m_filters;
+        // The filters when they are shared with other convolvers
+        std::shared_ptr<const FilterSet> m_sharedFilters;
+        // The filters in use, pointing to either m_filters or m_sharedFilters
+        const FilterSet* m_pFilters = nullptr;
+        // Contribution of all partitions except the first to the current output partition. Size nOutputs spectra
+        AlignedVector<float> m_tailSpectrum;
+        // Accumulator for the output spectrum
+        AlignedVector<float> m_accum;
+        // Interleaved spectrum passed to and from the FFT
+        std::vector<float> m_fftSpectrum;
+        // Time-domain scratch buffer of size FFT size
+        AlignedVector<float> m_scratch;
+
+        /** Process a segment of samples that does not cross a partition boundary.
+         * @param ppfIn     Input signals.
+         * @param ppfOut    Output signals.
+         * @param nOffset   Offset of the segment in the input and output buffers.
+         * @param nSamples  Number of samples in the segment.
+         */
+        void ProcessSegment(const float* const* ppfIn, float** ppfOut, unsigned int nOffset, unsigned int nSamples);
+
+        /** Push the spectra of the completed partition into the delay line and compute the contribution of the
+         *  delayed partitions to the next output partition.
+         */
+        void AdvancePartition();
+
+        /** Transform a time-domain signal of FFT size to a spectrum in split format. */
+        void ForwardFFT(const float* pfIn, float* pSpectrum);
+
+        /** Transform a spectrum in split format to the time domain. */
+        void InverseFFT(const float* pSpectrum, float* pfOut);
+
+        /** Get the filters to be changed, copying them first if they are shared. */
+        FilterSet& GetWritableFilters();
+
+        /** Get a pointer to the spectrum of the partition of the filter for an input/output pair. */
+        const float* GetFilterSpectrum(unsigned int iInput, unsigned int iOutput, unsigned int iPartition) const;
+    };
+
+} // namespace spaudio
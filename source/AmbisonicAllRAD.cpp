@@ -16,11 +16,21 @@
 #include "PointSourcePannerGainCalc.h"
 #include "AmbisonicCommons.h"
 #include "AmbisonicSource.h"
+#include "ConfigCache.h"
 #include "t_design_5200.h"
+#include "dsp/SimdKernels.h"
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 namespace spaudio {
 
+    // Number of t-design points evaluated together when calculating the decoder
+    static const unsigned int kGridChunkSize = 256;
+    // Maximum number of threads used to calculate the decoder
+    static const unsigned int kMaxConfigThreads = 4;
+
     AmbisonicAllRAD::AmbisonicAllRAD()
     {
     }
@@ -29,7 +39,7 @@ namespace spaudio {
     {
     }
 
-    bool AmbisonicAllRAD::Configure(unsigned nOrder, unsigned nBlockSize, unsigned sampleRate, const std::string& layoutName, bool useLFE, bool useOptimFilts)
+    bool AmbisonicAllRAD::Configure(unsigned nOrder, unsigned nBlockSize, unsigned sampleRate, const std::string& layoutName, bool useLFE, bool useOptimFilts, ConfigCache* pCache)
     {
         bool success = AmbisonicBase::Configure(nOrder, true, 0);
         if (!success)
@@ -60,7 +70,7 @@ namespace spaudio {
 
         m_pBFSrcTmp.Configure(nOrder, m_b3D, nBlockSize);
 
-        ConfigureAllRADMatrix();
+        ConfigureAllRADMatrix(pCache);
         Refresh();
 
         return true;
@@ -80,10 +90,14 @@ namespace spaudio {
 
     void AmbisonicAllRAD::Process(const BFormat* pBFSrc, unsigned nSamples, float** ppfDst)
     {
-        // Process a copy of the input to avoid overwriting it
-        m_pBFSrcTmp = *pBFSrc;
+        // Filter a copy of the input to avoid overwriting it
+        const BFormat* pBFDecode = pBFSrc;
         if (m_useOptimFilters)
+        {
+            m_pBFSrcTmp = *pBFSrc;
             m_shelfFilters.Process(&m_pBFSrcTmp, nSamples);
+            pBFDecode = &m_pBFSrcTmp;
+        }
 
         // Decode the input signal
         unsigned int ii = 0;
@@ -100,20 +114,12 @@ namespace spaudio {
                 iLFE++;
             }
             else
-            {
-                memset(ppfDst[niSpeaker], 0, nSamples * sizeof(float));
-                for (size_t niChannel = 0; niChannel < m_decMat[0].size(); niChannel++)
-                {
-                    float* in = m_pBFSrcTmp.m_ppfChannels[niChannel];
-                    float* out = ppfDst[niSpeaker];
-
-                    const float coeff = m_decMat[ii][niChannel];
-                    for (unsigned int niSample = 0; niSample < nSamples; niSample++)
-                        *out++ += (*in++) * coeff;
-                }
-                ii++;
-            }
+                m_pDecOut[ii++] = ppfDst[niSpeaker];
         }
+
+        // Decode to all of the other loudspeakers in one pass over the input
+        simd::MatrixMultiply(m_decMat->data(), (unsigned int)m_pDecOut.size(), m_nChannelCount,
+            pBFDecode->m_ppfChannels.get(), m_pDecOut.data(), nSamples);
     }
 
     unsigned AmbisonicAllRAD::GetSpeakerCount()
@@ -126,73 +132,156 @@ namespace spaudio {
         return m_useOptimFilters;
     }
 
-    void AmbisonicAllRAD::ConfigureAllRADMatrix()
+    void AmbisonicAllRAD::ConfigureAllRADMatrix(ConfigCache* pCache)
     {
-        // Set up the point source panner
-        PointSourcePannerGainCalc psp(m_layout);
-
-        unsigned int nLdspk = psp.getNumChannels();
-        unsigned int nGrid = tDesign5200::nTdesignPoints;
-        float recipNumGrid = 1.f / (float)nGrid;
-
-        // Set up the virtual source grid spherical harmonics Y with N3D normalisation
-        AmbisonicSource ambiSrc;
-        ambiSrc.Configure(m_nOrder, m_b3D, 0);
-        std::vector<std::vector<float>> Y((m_nOrder + 1) * (m_nOrder + 1), std::vector<float>(nGrid, 0.f));
-        std::vector<std::vector<float>> YT(nGrid, std::vector<float>((m_nOrder + 1) * (m_nOrder + 1), 0.f));
-        std::vector<double> pspGainsTmp(psp.getNumChannels(), 0.);
-        std::vector<std::vector<float>> G(nLdspk, std::vector<float>(nGrid, 0.f));
-        for (unsigned i = 0; i < nGrid; ++i)
+        const unsigned int nCh = m_nChannelCount;
+        const unsigned int nLdspk = (unsigned int)Layout::getLayoutWithoutLFE(m_layout).getNumChannels();
+
+        m_pDecOut.resize(nLdspk);
+
+        // Use the decoder of another object with the same configuration if there is one
+        if (pCache)
         {
-            float azRad = tDesign5200::points[i][0];
-            float elRad = tDesign5200::points[i][1];
-            ambiSrc.SetPosition({ azRad, elRad, 1.f });
-            ambiSrc.Refresh();
-            // Store transpose of Y
-            ambiSrc.GetCoefficients(YT[i]);
-
-            // Convert to N3D
-            for (unsigned iCoeff = 0; iCoeff < (unsigned)YT[i].size(); ++iCoeff)
+            m_decMat = pCache->GetShared<AlignedVector<float>>("AmbisonicAllRAD.decoder");
+            if (m_decMat && m_decMat->size() == nLdspk * nCh)
+                return;
+        }
+
+        auto decoder = std::make_shared<AlignedVector<float>>();
+        if (!pCache || !pCache->Get("AmbisonicAllRAD.decoder", *decoder) || decoder->size() != nLdspk * nCh)
+        {
+            CalculateAllRADMatrix(*decoder);
+            if (pCache)
+                pCache->Set("AmbisonicAllRAD.decoder", decoder->data(), decoder->size());
+        }
+
+        m_decMat = decoder;
+        if (pCache)
+            m_decMat = pCache->Share<AlignedVector<float>>("AmbisonicAllRAD.decoder", m_decMat, decoder->size() * sizeof(float));
+    }
+
+    void AmbisonicAllRAD::CalculateAllRADMatrix(AlignedVector<float>& decoder) const
+    {
+        const unsigned int nGrid = tDesign5200::nTdesignPoints;
+        const unsigned int nChunks = (nGrid + kGridChunkSize - 1) / kGridChunkSize;
+        const unsigned int nCh = m_nChannelCount;
+        const unsigned int nLdspk = (unsigned int)m_pDecOut.size();
+
+        // The decoder is D = G * Y^T / nGrid where G holds the point source panning gains and Y the N3D spherical
+        // harmonics of each grid point. The Gram matrix Y * Y^T is used for the normalisation. The grid is split into
+        // chunks and the products are calculated for each chunk with the SIMD matrix kernel. The partial products
+        // are added in order at the end so that the result does not depend on the number of threads.
+        std::vector<std::vector<float>> chunkDec(nChunks, std::vector<float>(nLdspk * nCh, 0.f));
+        std::vector<std::vector<float>> chunkGram(nChunks, std::vector<float>(nCh * nCh, 0.f));
+        std::atomic<unsigned int> nextChunk(0);
+        // The batch gain calculation does not modify the panner so it is shared by all of the threads
+        const PointSourcePannerGainCalc psp(m_layout);
+        auto evaluateGrid = [&]() {
+            AmbisonicSource ambiSrc;
+            ambiSrc.Configure(m_nOrder, m_b3D, 0);
+            std::vector<CartesianPosition<double>> directions(kGridChunkSize);
+            std::vector<float> pspGains(kGridChunkSize * nLdspk, 0.f);
+            // The gains G and the transpose of Y for the chunk, with one row per loudspeaker or coefficient
+            std::vector<float> G(nLdspk * kGridChunkSize, 0.f);
+            std::vector<float> Y(nCh * kGridChunkSize, 0.f);
+            // Y with one row per grid point
+            std::vector<std::vector<float>> YT(kGridChunkSize, std::vector<float>(nCh, 0.f));
+            std::vector<const float*> pYT(kGridChunkSize);
+            for (unsigned int i = 0; i < kGridChunkSize; ++i)
+                pYT[i] = YT[i].data();
+            std::vector<float*> pDec(nLdspk), pGram(nCh);
+
+            for (unsigned int iChunk = nextChunk++; iChunk < nChunks; iChunk = nextChunk++)
             {
-                float n2sn = (float)std::sqrt(2 * ComponentPositionToOrder(iCoeff, m_b3D) + 1);
-                YT[i][iCoeff] *= n2sn;
-            }
+                unsigned int iStart = iChunk * kGridChunkSize;
+                unsigned int nPoints = std::min(nGrid - iStart, kGridChunkSize);
+                for (unsigned int iPoint = 0; iPoint < nPoints; ++iPoint)
+                {
+                    float azRad = tDesign5200::points[iStart + iPoint][0];
+                    float elRad = tDesign5200::points[iStart + iPoint][1];
+                    ambiSrc.SetPosition({ azRad, elRad, 1.f });
+                    ambiSrc.Refresh();
+                    ambiSrc.GetCoefficients(YT[iPoint]);
+
+                    // Convert to N3D
+                    for (unsigned iCoeff = 0; iCoeff < nCh; ++iCoeff)
+                    {
+                        YT[iPoint][iCoeff] *= (float)std::sqrt(2 * ComponentPositionToOrder(iCoeff, m_b3D) + 1);
+                        Y[iCoeff * kGridChunkSize + iPoint] = YT[iPoint][iCoeff];
+                    }
+
+                    directions[iPoint] = PolarToCartesian(PolarPosition<double>{ (double)RadiansToDegrees(azRad), (double)RadiansToDegrees(elRad), 1. });
+                }
 
-            // Store Y for normalisation
-            for (size_t j = 0; j < YT[i].size(); ++j)
-                Y[j][i] = YT[i][j];
+                // Calculate the point source panning vectors for the grid directions of the chunk
+                psp.CalculateGains(directions.data(), nPoints, pspGains.data());
+                for (unsigned iPoint = 0; iPoint < nPoints; ++iPoint)
+                    for (unsigned iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+                        G[iLdspk * kGridChunkSize + iPoint] = pspGains[iPoint * nLdspk + iLdspk];
 
-            // Divide YT by the number of grid points
-            for (auto& y : YT[i])
-                y *= recipNumGrid;
+                // Points past the end of the grid in the last chunk do not contribute
+                for (unsigned iPoint = nPoints; iPoint < kGridChunkSize; ++iPoint)
+                {
+                    for (unsigned iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+                        G[iLdspk * kGridChunkSize + iPoint] = 0.f;
+                    for (unsigned iCoeff = 0; iCoeff < nCh; ++iCoeff)
+                        Y[iCoeff * kGridChunkSize + iPoint] = 0.f;
+                }
 
-            // Calculate the point source panning vectors for each source grid direction G
-            psp.CalculateGains(PolarPosition<double>{ (double)RadiansToDegrees(azRad), (double)RadiansToDegrees(elRad), 1. }, pspGainsTmp);
+                // G * Y^T and Y * Y^T for the chunk
+                for (unsigned iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+                    pDec[iLdspk] = &chunkDec[iChunk][iLdspk * nCh];
+                for (unsigned iCoeff = 0; iCoeff < nCh; ++iCoeff)
+                    pGram[iCoeff] = &chunkGram[iChunk][iCoeff * nCh];
+                simd::MatrixMultiply(G.data(), nLdspk, kGridChunkSize, pYT.data(), pDec.data(), nCh);
+                simd::MatrixMultiply(Y.data(), nCh, kGridChunkSize, pYT.data(), pGram.data(), nCh);
+            }
+        };
+
+        // Panning is the most expensive part so share the grid between a few threads
+        unsigned int nThreads = std::max(1u, std::min(std::thread::hardware_concurrency(), kMaxConfigThreads));
+        std::vector<std::thread> threads;
+        for (unsigned int iThread = 1; iThread < nThreads; ++iThread)
+            threads.emplace_back(evaluateGrid);
+        evaluateGrid();
+        for (auto& thread : threads)
+            thread.join();
+
+        std::vector<double> decMat(nLdspk * nCh, 0.);
+        std::vector<double> gram(nCh * nCh, 0.);
+        for (unsigned int iChunk = 0; iChunk < nChunks; ++iChunk)
+        {
+            for (size_t i = 0; i < decMat.size(); ++i)
+                decMat[i] += chunkDec[iChunk][i];
+            for (size_t i = 0; i < gram.size(); ++i)
+                gram[i] += chunkGram[iChunk][i];
+        }
+        for (auto& d : decMat)
+            d /= (double)nGrid;
 
-            // Store the gain matrix
-            for (size_t j = 0; j < nLdspk; ++j)
-                G[j][i] = (float)pspGainsTmp[j];
+        // Take the Frobenius norm of the decoded sampling matrix D * Y, using ||D * Y||^2 = sum over the rows d of D
+        // of d * (Y * Y^T) * d^T
+        double froNormSq = 0.;
+        for (unsigned iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+        {
+            const double* pD = &decMat[iLdspk * nCh];
+            for (unsigned iRow = 0; iRow < nCh; ++iRow)
+            {
+                double gramD = 0.;
+                for (unsigned iCol = 0; iCol < nCh; ++iCol)
+                    gramD += gram[iRow * nCh + iCol] * pD[iCol];
+                froNormSq += pD[iRow] * gramD;
+            }
         }
 
-        // Multiply G * Y^T to get the decoder
-        m_decMat = multiplyMat(G, YT);
-
-        // Calculate the normalisation value
-        auto sampleMat = multiplyMat(m_decMat, Y); // Decode the sampling matrix to get the loudspeaker gains at each grid position
-        // Take the Frobenius norm of sampleMat
-        float froNorm = 0.f;
-        for (size_t iLdspk = 0; iLdspk < sampleMat.size(); ++iLdspk)
-            for (size_t iGrid = 0; iGrid < sampleMat[0].size(); ++iGrid)
-                froNorm += sampleMat[iLdspk][iGrid] * sampleMat[iLdspk][iGrid];
-        froNorm = std::sqrt(froNorm);
-
-        // Normalise the decoder and convert to a decoder for SN3D normalised signals
-        float normFactor = std::sqrt((float)nGrid) / froNorm;
-        for (unsigned iCoeff = 0; iCoeff < (unsigned)m_decMat[0].size(); ++iCoeff)
+        // Normalise the decoder, convert to a decoder for SN3D normalised signals and store it contiguously for processing
+        double normFactor = std::sqrt((double)nGrid / froNormSq);
+        decoder.resize(nLdspk * nCh);
+        for (unsigned iCoeff = 0; iCoeff < nCh; ++iCoeff)
         {
-            float n2snDec = (float)std::sqrt(2 * ComponentPositionToOrder(iCoeff, m_b3D) + 1);
-            for (size_t iLdspk = 0; iLdspk < m_decMat.size(); ++iLdspk)
-                m_decMat[iLdspk][iCoeff] *= normFactor * n2snDec;
+            double n2snDec = std::sqrt(2 * ComponentPositionToOrder(iCoeff, m_b3D) + 1);
+            for (unsigned iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+                decoder[iLdspk * nCh + iCoeff] = (float)(decMat[iLdspk * nCh + iCoeff] * normFactor * n2snDec);
         }
     }
 
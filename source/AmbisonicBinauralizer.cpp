@@ -16,23 +16,19 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "AmbisonicBinauralizer.h"
+#include "ConfigCache.h"
 
 namespace spaudio {
 
     AmbisonicBinauralizer::AmbisonicBinauralizer()
-        : m_pFFT_cfg(nullptr, kiss_fftr_free)
-        , m_pIFFT_cfg(nullptr, kiss_fftr_free)
     {
         m_nBlockSize = 0;
         m_nSampleRate = 0;
         m_nTaps = 0;
-        m_nFFTSize = 0;
-        m_nFFTBins = 0;
-        m_fFFTScaler = 0.f;
-        m_nOverlapLength = 0;
     }
 
     bool AmbisonicBinauralizer::Configure(unsigned nOrder,
@@ -41,55 +37,124 @@ namespace spaudio {
         unsigned nBlockSize,
         unsigned& tailLength,
         std::string HRTFPath,
-        bool lowCpuMode)
+        bool lowCpuMode,
+        bool combineShelfFilters,
+        ConfigCache* pCache)
     {
         bool success = AmbisonicBase::Configure(nOrder, b3D, 0);
         if (!success)
             return false;
 
-        success = m_BFSrcTmp.Configure(nOrder, b3D, nBlockSize);
-        if (!success)
-            return false;
-
         m_nSampleRate = nSampleRate;
+        m_nBlockSize = nBlockSize;
         m_useSymHead = lowCpuMode;
+        m_combineShelfFilters = combineShelfFilters;
+
+        // A copy of the input is only needed to apply the shelf filters separately
+        if (!m_combineShelfFilters)
+        {
+            success = m_BFSrcTmp.Configure(nOrder, b3D, nBlockSize);
+            if (!success)
+                return false;
+        }
+
+        // Optimisation filters to pre-process the FIR filters with basic/max-rE gains
+        if (!m_combineShelfFilters)
+        {
+            bool bShelfConfig = m_shelfFilters.Configure(nOrder, b3D, nBlockSize, nSampleRate);
+            if (!bShelfConfig)
+                return false;
+        }
+
+        // The cached and shared filters are named after the options that change them in case the cache key does not
+        // include them
+        std::string filtersName = std::string("AmbisonicBinauralizer.filters") + (m_useSymHead ? ".symmetric" : "")
+            + (m_combineShelfFilters ? ".shelf" : "");
+
+        // Use the filters of another binauralizer with the same configuration if there is one
+        auto sharedFilters = pCache ? pCache->GetShared<FrequencyDomainConvolver::FilterSet>(filtersName) : nullptr;
+        if (sharedFilters)
+        {
+            tailLength = m_nTaps = sharedFilters->nMaxTaps;
+            AllocateBuffers();
+            if (m_convolver.SetFilters(sharedFilters))
+                return true;
+        }
+
+        // The filters only depend on the configuration so they are loaded from the cache if possible
+        unsigned nEars = m_useSymHead ? 1u : 2u;
+        std::vector<float> filters;
+        if (!pCache || !pCache->Get(filtersName, filters)
+            || filters.empty() || filters.size() % (m_nChannelCount * nEars) != 0)
+        {
+            if (!CalculateFilters(HRTFPath, filters))
+                return false;
+            if (pCache)
+                pCache->Set(filtersName, filters.data(), filters.size());
+        }
+        tailLength = m_nTaps = (unsigned)filters.size() / (m_nChannelCount * nEars);
+
+        //Allocate buffers with new settings
+        AllocateBuffers();
+
+        // Set the filters in the convolver. When assuming a symmetric head only the left ear filters are used.
+        // Channels that are added and subtracted for the right ear are accumulated to separate outputs
+        for (unsigned niChannel = 0; niChannel < m_nChannelCount; niChannel++)
+        {
+            for (unsigned niEar = 0; niEar < nEars; niEar++)
+            {
+                unsigned iOutput = m_useSymHead ? (IsAntisymmetricChannel(niChannel) ? 1 : 0) : niEar;
+                m_convolver.SetFilter(niChannel, iOutput, &filters[(niChannel * nEars + niEar) * m_nTaps], m_nTaps);
+            }
+        }
+
+        if (pCache)
+        {
+            auto convolverFilters = m_convolver.GetFilters();
+            m_convolver.SetFilters(pCache->Share(filtersName, convolverFilters, convolverFilters->GetMemoryUsage()));
+        }
 
+        return true;
+    }
+
+    bool AmbisonicBinauralizer::CalculateFilters(const std::string& HRTFPath, std::vector<float>& filters)
+    {
         //Iterators
         unsigned niEar = 0;
         unsigned niChannel = 0;
         unsigned niSpeaker = 0;
         unsigned niTap = 0;
 
-        HRTF* p_hrtf = getHRTF(nSampleRate, HRTFPath);
+        HRTF* p_hrtf = getHRTF(m_nSampleRate, HRTFPath);
         if (p_hrtf == nullptr)
             return false;
 
-        tailLength = m_nTaps = p_hrtf->getHRTFLen();
-        m_nBlockSize = nBlockSize;
+        unsigned nHRTFTaps = p_hrtf->getHRTFLen();
 
-        //What will the overlap size be?
-        m_nOverlapLength = m_nTaps - 1;
-        //How large does the FFT need to be
-        m_nFFTSize = 1;
-        while (m_nFFTSize < (m_nBlockSize + m_nTaps - 1))
-            m_nFFTSize <<= 1;
-        //How many bins is that
-        m_nFFTBins = m_nFFTSize / 2 + 1;
-        //What do we need to scale the result of the iFFT by
-        m_fFFTScaler = 1.f / m_nFFTSize;
+        // When combining the shelf filters with the HRTFs the filters are lengthened by the shelf filter responses
+        std::vector<std::vector<float>> shelfResponses;
+        unsigned nShelfTaps = 1;
+        if (m_combineShelfFilters)
+        {
+            shelfResponses = CalculateShelfResponses(m_nOrder, m_b3D, m_nSampleRate);
+            if (shelfResponses.empty())
+            {
+                delete p_hrtf;
+                return false;
+            }
+            for (auto& response : shelfResponses)
+                nShelfTaps = std::max(nShelfTaps, (unsigned)response.size());
+        }
+        unsigned nTaps = nHRTFTaps + nShelfTaps - 1;
 
         //Position speakers and recalculate coefficients
         ArrangeSpeakers();
 
         unsigned nSpeakers = m_AmbDecoder.GetSpeakerCount();
-
-        //Allocate buffers with new settings
-        AllocateBuffers();
-
         //Allocate temporary buffers for retrieving taps from mit_hrtf_lib
         float* pfHRTF[2];
         for (niEar = 0; niEar < 2; niEar++)
-            pfHRTF[niEar] = new float[m_nTaps];
+            pfHRTF[niEar] = new float[nHRTFTaps];
 
         //Allocate buffers for HRTF accumulators
         float** ppfAccumulator[2];
@@ -97,7 +162,7 @@ namespace spaudio {
         {
             ppfAccumulator[niEar] = new float* [m_nChannelCount];
             for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
-                ppfAccumulator[niEar][niChannel] = new float[m_nTaps]();
+                ppfAccumulator[niEar][niChannel] = new float[nHRTFTaps]();
         }
 
         for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
@@ -113,13 +178,13 @@ namespace spaudio {
 
                 //Scale the HRTFs by the coefficient of the current channel/component
                 float fCoefficient = m_AmbDecoder.GetCoefficient(niSpeaker, niChannel);
-                for (niTap = 0; niTap < m_nTaps; niTap++)
+                for (niTap = 0; niTap < nHRTFTaps; niTap++)
                 {
                     pfHRTF[0][niTap] *= fCoefficient;
                     pfHRTF[1][niTap] *= fCoefficient;
                 }
                 //Accumulate channel/component HRTF
-                for (niTap = 0; niTap < m_nTaps; niTap++)
+                for (niTap = 0; niTap < nHRTFTaps; niTap++)
                 {
                     ppfAccumulator[0][niChannel][niTap] += pfHRTF[0][niTap];
                     ppfAccumulator[1][niChannel][niTap] += pfHRTF[1][niTap];
@@ -134,7 +199,7 @@ namespace spaudio {
 
         // encode a source at azimuth 90deg and elevation 0
         AmbisonicEncoder myEncoder;
-        myEncoder.Configure(m_nOrder, true, nSampleRate, 0);
+        myEncoder.Configure(m_nOrder, true, m_nSampleRate, 0);
 
         PolarPosition<float> position90;
         position90.azimuth = DegreesToRadians(90.f);
@@ -144,23 +209,18 @@ namespace spaudio {
         myEncoder.Refresh();
 
         float* pfLeftEar90;
-        pfLeftEar90 = new float[m_nTaps]();
+        pfLeftEar90 = new float[nHRTFTaps]();
         for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
-            for (niTap = 0; niTap < m_nTaps; niTap++)
+            for (niTap = 0; niTap < nHRTFTaps; niTap++)
                 pfLeftEar90[niTap] += myEncoder.GetCoefficient(niChannel) * ppfAccumulator[0][niChannel][niTap];
 
         //Find the maximum value for a source encoded at 90degrees
-        for (niTap = 0; niTap < m_nTaps; niTap++)
+        for (niTap = 0; niTap < nHRTFTaps; niTap++)
         {
             float val = fabs(pfLeftEar90[niTap]);
             fMax = val > fMax ? val : fMax;
         }
 
-        // Optimisation filters to pre-process the FIR filters with basic/max-rE gains
-        bool bShelfConfig = m_shelfFilters.Configure(nOrder, b3D, nBlockSize, nSampleRate);
-        if (!bShelfConfig)
-            return false;
-
         //Normalize to pre-defined value
         float fUpperSample = 1.f;
         float fScaler = fUpperSample / fMax;
@@ -169,21 +229,32 @@ namespace spaudio {
         {
             for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
             {
-                for (niTap = 0; niTap < m_nTaps; niTap++)
+                for (niTap = 0; niTap < nHRTFTaps; niTap++)
                 {
                     ppfAccumulator[niEar][niChannel][niTap] *= fScaler;
                 }
             }
         }
 
-        // Convert frequency domain filters
-        for (niEar = 0; niEar < 2; niEar++)
+        // Store the filters for each channel and ear. When assuming a symmetric head only the left ear filters are used
+        unsigned nEars = m_useSymHead ? 1u : 2u;
+        filters.assign(m_nChannelCount * nEars * nTaps, 0.f);
+        for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
         {
-            for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
+            for (niEar = 0; niEar < nEars; niEar++)
             {
-                memcpy(m_pfScratchBufferA.data(), ppfAccumulator[niEar][niChannel], m_nTaps * sizeof(float));
-                memset(&m_pfScratchBufferA[m_nTaps], 0, (m_nFFTSize - m_nTaps) * sizeof(float));
-                kiss_fftr(m_pFFT_cfg.get(), m_pfScratchBufferA.data(), m_ppcpFilters[niEar][niChannel].get());
+                const float* pfFilter = ppfAccumulator[niEar][niChannel];
+                float* pfOut = &filters[(niChannel * nEars + niEar) * nTaps];
+                if (m_combineShelfFilters)
+                {
+                    // Convolve the HRTF with the shelf filter response so the shelf filtering is applied with the HRTF
+                    const std::vector<float>& shelfResponse = shelfResponses[niChannel];
+                    for (niTap = 0; niTap < nHRTFTaps; niTap++)
+                        for (unsigned niShelfTap = 0; niShelfTap < shelfResponse.size(); niShelfTap++)
+                            pfOut[niTap + niShelfTap] += pfFilter[niTap] * shelfResponse[niShelfTap];
+                }
+                else
+                    std::copy(pfFilter, pfFilter + nHRTFTaps, pfOut);
             }
         }
 
@@ -203,8 +274,7 @@ namespace spaudio {
 
     void AmbisonicBinauralizer::Reset()
     {
-        memset(m_pfOverlap[0].data(), 0, m_nOverlapLength * sizeof(float));
-        memset(m_pfOverlap[1].data(), 0, m_nOverlapLength * sizeof(float));
+        m_convolver.Reset();
     }
 
     void AmbisonicBinauralizer::Refresh()
@@ -220,13 +290,13 @@ namespace spaudio {
     void AmbisonicBinauralizer::Process(const BFormat* pBFSrc,
         float** ppfDst, unsigned int nSamples)
     {
-        unsigned niEar = 0;
-        unsigned niChannel = 0;
-        unsigned ni = 0;
-        kiss_fft_cpx cpTemp;
-
-        m_BFSrcTmp = *pBFSrc;
-        m_shelfFilters.Process(&m_BFSrcTmp, nSamples);
+        const BFormat* pBFIn = pBFSrc;
+        if (!m_combineShelfFilters)
+        {
+            m_BFSrcTmp = *pBFSrc;
+            m_shelfFilters.Process(&m_BFSrcTmp, nSamples);
+            pBFIn = &m_BFSrcTmp;
+        }
 
         /* If CPU load needs to be reduced then perform the convolution for each of the Ambisonics/spherical harmonic
         decompositions of the loudspeakers HRTFs for the left ear. For the left ear the results of these convolutions
@@ -238,122 +308,68 @@ namespace spaudio {
             SignalR = W x HRTF_W - Y x HRTF_Y + Z x HRTF_Z + X x HRTF_X
         where 'x' is a convolution, W/Y/Z/X are the Ambisonic signal channels and HRTF_x are the spherical harmonic
         decompositions of the virtual loudspeaker array HRTFs.
-        This has the effect of assuming a completel symmetric head. */
+        This has the effect of assuming a completel symmetric head.
+        The convolver accumulates the added channels to the first output and the subtracted channels to the second.
+        Otherwise the convolution is performed on both ears. Potentially more realistic results but requires double
+        the number of convolutions. */
+        m_convolver.Process(pBFIn->m_ppfChannels.get(), ppfDst, nSamples);
 
-        if (m_useSymHead) {
-            // Perform the convolutions for the left ear and generate the right ear from a modified accumulation of these channels
-            niEar = 0;
-            memset(m_pfScratchBufferA.data(), 0, m_nFFTSize * sizeof(float));
-            memset(m_pfScratchBufferC.data(), 0, m_nFFTSize * sizeof(float));
-            for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
-            {
-
-                memcpy(m_pfScratchBufferB.data(), m_BFSrcTmp.m_ppfChannels[niChannel], nSamples * sizeof(float));
-                memset(&m_pfScratchBufferB[nSamples], 0, (m_nFFTSize - nSamples) * sizeof(float));
-                kiss_fftr(m_pFFT_cfg.get(), m_pfScratchBufferB.data(), m_pcpScratch.get());
-                for (ni = 0; ni < m_nFFTBins; ni++)
-                {
-                    cpTemp.r = m_pcpScratch[ni].r * m_ppcpFilters[niEar][niChannel][ni].r
-                        - m_pcpScratch[ni].i * m_ppcpFilters[niEar][niChannel][ni].i;
-                    cpTemp.i = m_pcpScratch[ni].r * m_ppcpFilters[niEar][niChannel][ni].i
-                        + m_pcpScratch[ni].i * m_ppcpFilters[niEar][niChannel][ni].r;
-                    m_pcpScratch[ni] = cpTemp;
-                }
-                kiss_fftri(m_pIFFT_cfg.get(), m_pcpScratch.get(), m_pfScratchBufferB.data());
-                for (ni = 0; ni < m_nFFTSize; ni++)
-                    m_pfScratchBufferA[ni] += m_pfScratchBufferB[ni];
-                for (ni = 0; ni < m_nFFTSize; ni++) {
-                    // Subtract certain channels (such as Y) to generate right ear.
-                    if ((niChannel == 1) || (niChannel == 4) || (niChannel == 5) ||
-                        (niChannel == 9) || (niChannel == 10) || (niChannel == 11))
-                    {
-                        m_pfScratchBufferC[ni] -= m_pfScratchBufferB[ni];
-                    }
-                    else {
-                        m_pfScratchBufferC[ni] += m_pfScratchBufferB[ni];
-                    }
-                }
-            }
-            for (ni = 0; ni < m_nFFTSize; ni++) {
-                m_pfScratchBufferA[ni] *= m_fFFTScaler;
-                m_pfScratchBufferC[ni] *= m_fFFTScaler;
-            }
-            memcpy(ppfDst[0], m_pfScratchBufferA.data(), nSamples * sizeof(float));
-            memcpy(ppfDst[1], m_pfScratchBufferC.data(), nSamples * sizeof(float));
-            unsigned int nOverlapOut = std::min(nSamples, m_nOverlapLength);
-            for (ni = 0; ni < nOverlapOut; ni++) {
-                ppfDst[0][ni] += m_pfOverlap[0][ni];
-                ppfDst[1][ni] += m_pfOverlap[1][ni];
-            }
-            int nOverlapRetain = m_nOverlapLength - nOverlapOut;
-            if (nOverlapRetain > 0)
-            {
-                memcpy(m_pfOverlap[0].data(), &m_pfOverlap[0][nOverlapOut], nOverlapRetain * sizeof(float));
-                memcpy(m_pfOverlap[1].data(), &m_pfOverlap[1][nOverlapOut], nOverlapRetain * sizeof(float));
-                // clear the rest of the overlap buffer
-                memset(&m_pfOverlap[0][nOverlapRetain], 0, nOverlapOut * sizeof(float));
-                memset(&m_pfOverlap[1][nOverlapRetain], 0, nOverlapOut * sizeof(float));
-                // Add the new overlap to the old buffer
-                for (ni = 0; ni < m_nOverlapLength; ni++) {
-                    m_pfOverlap[0][ni] += m_pfScratchBufferA[nSamples + ni];
-                    m_pfOverlap[1][ni] += m_pfScratchBufferC[nSamples + ni];
-                }
-            }
-            else
+        if (m_useSymHead)
+        {
+            for (unsigned ni = 0; ni < nSamples; ni++)
             {
-                memcpy(m_pfOverlap[0].data(), &m_pfScratchBufferA[nSamples], m_nOverlapLength * sizeof(float));
-                memcpy(m_pfOverlap[1].data(), &m_pfScratchBufferC[nSamples], m_nOverlapLength * sizeof(float));
+                float fSym = ppfDst[0][ni];
+                float fAntisym = ppfDst[1][ni];
+                ppfDst[0][ni] = fSym + fAntisym;
+                ppfDst[1][ni] = fSym - fAntisym;
             }
         }
-        else
+    }
+
+    std::vector<std::vector<float>> AmbisonicBinauralizer::CalculateShelfResponses(unsigned nOrder, bool b3D, unsigned nSampleRate)
+    {
+        // The shelf filters are IIR so their impulse responses are calculated over 20 ms then truncated once the
+        // remaining energy is negligible
+        const unsigned nMaxLength = nSampleRate / 50;
+        const double truncationThreshold = 1e-10;
+
+        AmbisonicOptimFilters shelfFilters;
+        BFormat impulse;
+        if (!shelfFilters.Configure(nOrder, b3D, nMaxLength, nSampleRate) || !impulse.Configure(nOrder, b3D, nMaxLength))
+            return {};
+
+        impulse.Reset();
+        for (unsigned niChannel = 0; niChannel < impulse.GetChannelCount(); niChannel++)
+            impulse.m_ppfChannels[niChannel][0] = 1.f;
+        shelfFilters.Process(&impulse, nMaxLength);
+
+        std::vector<std::vector<float>> responses(impulse.GetChannelCount());
+        for (unsigned niChannel = 0; niChannel < impulse.GetChannelCount(); niChannel++)
         {
-            // Perform the convolution on both ears. Potentially more realistic results but requires double the number of
-            // convolutions.
-            for (niEar = 0; niEar < 2; niEar++)
+            const float* pfResponse = impulse.m_ppfChannels[niChannel];
+            double totalEnergy = 0.;
+            for (unsigned niTap = 0; niTap < nMaxLength; niTap++)
+                totalEnergy += (double)pfResponse[niTap] * pfResponse[niTap];
+
+            unsigned nLength = nMaxLength;
+            double tailEnergy = 0.;
+            while (nLength > 1)
             {
-                memset(m_pfScratchBufferA.data(), 0, m_nFFTSize * sizeof(float));
-                for (niChannel = 0; niChannel < m_nChannelCount; niChannel++)
-                {
-                    memcpy(m_pfScratchBufferB.data(), m_BFSrcTmp.m_ppfChannels[niChannel], nSamples * sizeof(float));
-                    memset(&m_pfScratchBufferB[nSamples], 0, (m_nFFTSize - nSamples) * sizeof(float));
-                    kiss_fftr(m_pFFT_cfg.get(), m_pfScratchBufferB.data(), m_pcpScratch.get());
-                    for (ni = 0; ni < m_nFFTBins; ni++)
-                    {
-                        cpTemp.r = m_pcpScratch[ni].r * m_ppcpFilters[niEar][niChannel][ni].r
-                            - m_pcpScratch[ni].i * m_ppcpFilters[niEar][niChannel][ni].i;
-                        cpTemp.i = m_pcpScratch[ni].r * m_ppcpFilters[niEar][niChannel][ni].i
-                            + m_pcpScratch[ni].i * m_ppcpFilters[niEar][niChannel][ni].r;
-                        m_pcpScratch[ni] = cpTemp;
-                    }
-                    kiss_fftri(m_pIFFT_cfg.get(), m_pcpScratch.get(), m_pfScratchBufferB.data());
-                    for (ni = 0; ni < m_nFFTSize; ni++)
-                        m_pfScratchBufferA[ni] += m_pfScratchBufferB[ni];
-                }
-                for (ni = 0; ni < m_nFFTSize; ni++)
-                    m_pfScratchBufferA[ni] *= m_fFFTScaler;
-                memcpy(ppfDst[niEar], m_pfScratchBufferA.data(), nSamples * sizeof(float));
-                unsigned int nOverlapOut = std::min(nSamples, m_nOverlapLength);
-                for (ni = 0; ni < nOverlapOut; ni++)
-                {
-                    ppfDst[niEar][ni] += m_pfOverlap[niEar][ni];
-                }
-                int nOverlapRetain = m_nOverlapLength - nOverlapOut;
-                if (nOverlapRetain > 0)
-                {
-                    memcpy(m_pfOverlap[niEar].data(), &m_pfOverlap[niEar][nOverlapOut], nOverlapRetain * sizeof(float));
-                    // clear the rest of the overlap buffer
-                    memset(&m_pfOverlap[niEar][nOverlapRetain], 0, nOverlapOut * sizeof(float));
-                    // Add the new overlap to the old buffer
-                    for (ni = 0; ni < m_nOverlapLength; ni++) {
-                        m_pfOverlap[niEar][ni] += m_pfScratchBufferA[nSamples + ni];
-                    }
-                }
-                else
-                {
-                    memcpy(m_pfOverlap[niEar].data(), &m_pfScratchBufferA[nSamples], m_nOverlapLength * sizeof(float));
-                }
+                tailEnergy += (double)pfResponse[nLength - 1] * pfResponse[nLength - 1];
+                if (tailEnergy > truncationThreshold * totalEnergy)
+                    break;
+                nLength--;
             }
+            responses[niChannel].assign(pfResponse, pfResponse + nLength);
         }
+
+        return responses;
+    }
+
+    bool AmbisonicBinauralizer::IsAntisymmetricChannel(unsigned nChannel)
+    {
+        return (nChannel == 1) || (nChannel == 4) || (nChannel == 5) ||
+            (nChannel == 9) || (nChannel == 10) || (nChannel == 11);
     }
 
     void AmbisonicBinauralizer::ArrangeSpeakers()
@@ -416,28 +432,8 @@ namespace spaudio {
 
     void AmbisonicBinauralizer::AllocateBuffers()
     {
-        //Allocate scratch buffers
-        m_pfScratchBufferA.resize(m_nFFTSize);
-        m_pfScratchBufferB.resize(m_nFFTSize);
-        m_pfScratchBufferC.resize(m_nFFTSize);
-
-        //Allocate overlap-add buffers
-        m_pfOverlap[0].resize(m_nOverlapLength);
-        m_pfOverlap[1].resize(m_nOverlapLength);
-
-        //Allocate FFT and iFFT for new size
-        m_pFFT_cfg.reset(kiss_fftr_alloc(m_nFFTSize, 0, 0, 0));
-        m_pIFFT_cfg.reset(kiss_fftr_alloc(m_nFFTSize, 1, 0, 0));
-
-        //Allocate the FFTBins for each channel, for each ear
-        for (unsigned niEar = 0; niEar < 2; niEar++)
-        {
-            m_ppcpFilters[niEar].resize(m_nChannelCount);
-            for (unsigned niChannel = 0; niChannel < m_nChannelCount; niChannel++)
-                m_ppcpFilters[niEar][niChannel].reset(new kiss_fft_cpx[m_nFFTBins]);
-        }
-
-        m_pcpScratch.reset(new kiss_fft_cpx[m_nFFTBins]);
+        //Partition the filters to match the block size
+        m_convolver.Configure(m_nChannelCount, 2, m_nTaps, m_nBlockSize);
     }
 
 } // namespace spaudio
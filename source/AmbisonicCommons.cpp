@@ -13,6 +13,7 @@
 
 
 #include "AmbisonicCommons.h"
+#include <assert.h>
 
 namespace spaudio {
 
@@ -185,4 +186,98 @@ namespace spaudio {
     template float FuMaToSn3dFactor(int order, int degree);
     template double FuMaToSn3dFactor(int order, int degree);
 
+    unsigned OrderToRotationBlockPosition(unsigned order)
+    {
+        return order * (2 * order - 1) * (2 * order + 1) / 3;
+    }
+
+    namespace {
+        /** The term P of Ivanic and Ruedenberg's recursion (corrected in their 1998 errata).
+         * @param pR1   The order 1 block.
+         * @param pPrev The block of order l-1.
+         * @param i     Degree used to index the order 1 block.
+         * @param l     Order of the block being calculated.
+         * @param a     Row degree in the block of order l-1.
+         * @param b     Column degree in the block of order l.
+         */
+        template<typename T>
+        T rotationP(const T* pR1, const T* pPrev, int i, int l, int a, int b)
+        {
+            auto r1 = [pR1](int m, int n) { return pR1[(m + 1) * 3 + n + 1]; };
+            auto prev = [pPrev, l](int m, int n) { return pPrev[(m + l - 1) * (2 * l - 1) + n + l - 1]; };
+
+            if (b == l)
+                return r1(i, 1) * prev(a, l - 1) - r1(i, -1) * prev(a, -l + 1);
+            else if (b == -l)
+                return r1(i, 1) * prev(a, -l + 1) + r1(i, -1) * prev(a, l - 1);
+            else
+                return r1(i, 0) * prev(a, b);
+        }
+    }
+
+    template<typename T>
+    void ShRotationMatrixBlocks(const std::vector<std::vector<T>>& rotMat, unsigned nOrder, std::vector<T>& blocks)
+    {
+        assert(rotMat.size() == 3 && rotMat[0].size() == 3);
+        blocks.resize(OrderToRotationBlockPosition(nOrder + 1));
+
+        blocks[0] = static_cast<T>(1);
+        if (nOrder == 0)
+            return;
+
+        // The order 1 components Y, Z and X are proportional to the Cartesian coordinates y, z and x
+        const int acnToCartesian[3] = { 1, 2, 0 };
+        T* pR1 = &blocks[OrderToRotationBlockPosition(1)];
+        for (int m = 0; m < 3; ++m)
+            for (int n = 0; n < 3; ++n)
+                pR1[m * 3 + n] = rotMat[acnToCartesian[m]][acnToCartesian[n]];
+
+        for (int l = 2; l <= (int)nOrder; ++l)
+        {
+            const T* pPrev = &blocks[OrderToRotationBlockPosition(l - 1)];
+            T* pBlock = &blocks[OrderToRotationBlockPosition(l)];
+            for (int m = -l; m <= l; ++m)
+            {
+                const int absM = std::abs(m);
+                const T d = m == 0 ? static_cast<T>(1) : static_cast<T>(0);
+                for (int n = -l; n <= l; ++n)
+                {
+                    const T denom = std::abs(n) < l ? static_cast<T>((l + n) * (l - n)) : static_cast<T>((2 * l) * (2 * l - 1));
+                    const T u = std::sqrt(static_cast<T>((l + m) * (l - m)) / denom);
+                    const T v = static_cast<T>(0.5) * std::sqrt((static_cast<T>(1) + d) * static_cast<T>((l + absM - 1) * (l + absM)) / denom) * (static_cast<T>(1) - static_cast<T>(2) * d);
+                    const T w = static_cast<T>(-0.5) * std::sqrt(static_cast<T>((l - absM - 1) * (l - absM)) / denom) * (static_cast<T>(1) - d);
+
+                    T val = static_cast<T>(0);
+                    if (u != static_cast<T>(0))
+                        val += u * rotationP(pR1, pPrev, 0, l, m, n);
+                    if (v != static_cast<T>(0))
+                    {
+                        T V;
+                        if (m == 0)
+                            V = rotationP(pR1, pPrev, 1, l, 1, n) + rotationP(pR1, pPrev, -1, l, -1, n);
+                        else if (m > 0)
+                            V = rotationP(pR1, pPrev, 1, l, m - 1, n) * (m == 1 ? std::sqrt(static_cast<T>(2)) : static_cast<T>(1))
+                                - (m == 1 ? static_cast<T>(0) : rotationP(pR1, pPrev, -1, l, -m + 1, n));
+                        else
+                            V = (m == -1 ? static_cast<T>(0) : rotationP(pR1, pPrev, 1, l, m + 1, n))
+                                + rotationP(pR1, pPrev, -1, l, -m - 1, n) * (m == -1 ? std::sqrt(static_cast<T>(2)) : static_cast<T>(1));
+                        val += v * V;
+                    }
+                    if (w != static_cast<T>(0))
+                    {
+                        T W;
+                        if (m > 0)
+                            W = rotationP(pR1, pPrev, 1, l, m + 1, n) + rotationP(pR1, pPrev, -1, l, -m - 1, n);
+                        else
+                            W = rotationP(pR1, pPrev, 1, l, m - 1, n) - rotationP(pR1, pPrev, -1, l, -m + 1, n);
+                        val += w * W;
+                    }
+                    pBlock[(m + l) * (2 * l + 1) + n + l] = val;
+                }
+            }
+        }
+    }
+    template void ShRotationMatrixBlocks(const std::vector<std::vector<float>>& rotMat, unsigned nOrder, std::vector<float>& blocks);
+    template void ShRotationMatrixBlocks(const std::vector<std::vector<double>>& rotMat, unsigned nOrder, std::vector<double>& blocks);
+
 } // namespace spaudio
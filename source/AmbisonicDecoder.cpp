@@ -16,6 +16,7 @@
 
 #include "AmbisonicDecoder.h"
 #include "AmbisonicDecoderPresets.h"
+#include "dsp/SimdKernels.h"
 #include <iostream>
 #include <assert.h>
 
@@ -77,29 +78,24 @@ namespace spaudio {
 
         m_shelfFilters.Refresh();
         m_pBFSrcTmp.Refresh();
+
+        UpdateDecodeMatrix();
     }
 
     void AmbisonicDecoder::Process(BFormat* pBFSrc, unsigned nSamples, float** ppfDst)
     {
         // If a preset is not loaded then use optimisation shelf filters
+        const BFormat* pBFDecode = pBFSrc;
         if (!m_bPresetLoaded)
         {
             // Process a copy of the input to avoid overwriting it
             m_pBFSrcTmp = *pBFSrc;
             m_shelfFilters.Process(&m_pBFSrcTmp, nSamples);
-
-            for (unsigned niSpeaker = 0; niSpeaker < m_nSpeakers; niSpeaker++)
-            {
-                m_pAmbSpeakers[niSpeaker].Process(&m_pBFSrcTmp, nSamples, ppfDst[niSpeaker]);
-            }
-        }
-        else
-        {
-            for (unsigned niSpeaker = 0; niSpeaker < m_nSpeakers; niSpeaker++)
-            {
-                m_pAmbSpeakers[niSpeaker].Process(pBFSrc, nSamples, ppfDst[niSpeaker]);
-            }
+            pBFDecode = &m_pBFSrcTmp;
         }
+
+        // Decode to all of the speakers in one pass over the input
+        simd::MatrixMultiply(m_decMat.data(), m_nSpeakers, m_nChannelCount, pBFDecode->m_ppfChannels.get(), ppfDst, nSamples);
     }
 
     Amblib_SpeakerSetUps AmbisonicDecoder::GetSpeakerSetUp()
@@ -140,6 +136,8 @@ namespace spaudio {
     void AmbisonicDecoder::SetCoefficient(unsigned nSpeaker, unsigned nChannel, float fCoeff)
     {
         m_pAmbSpeakers[nSpeaker].SetCoefficient(nChannel, fCoeff);
+        if (nChannel < m_pAmbSpeakers[nSpeaker].GetChannelCount())
+            m_decMat[nSpeaker * m_nChannelCount + nChannel] = fCoeff;
     }
 
     bool AmbisonicDecoder::GetPresetLoaded()
@@ -757,4 +755,16 @@ namespace spaudio {
         }
     }
 
+    void AmbisonicDecoder::UpdateDecodeMatrix()
+    {
+        m_decMat.assign(m_nSpeakers * m_nChannelCount, 0.f);
+        for (unsigned iSpeaker = 0; iSpeaker < m_nSpeakers; ++iSpeaker)
+        {
+            // Some layouts configure the speakers at a lower order than the decoder
+            unsigned nSpeakerCh = std::min(m_pAmbSpeakers[iSpeaker].GetChannelCount(), m_nChannelCount);
+            for (unsigned iCoeff = 0; iCoeff < nSpeakerCh; ++iCoeff)
+                m_decMat[iSpeaker * m_nChannelCount + iCoeff] = m_pAmbSpeakers[iSpeaker].GetCoefficient(iCoeff);
+        }
+    }
+
 } // namespace spaudio
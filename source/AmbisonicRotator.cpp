@@ -15,19 +15,62 @@
 
 #include "AmbisonicRotator.h"
 #include <assert.h>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "Tools.h"
+#include "dsp/SimdKernels.h"
 
 namespace spaudio {
 
+    // Number of samples processed at a time by each order block
+    static const unsigned int kChunkSize = 64;
+    // Maximum number of pending head tracker samples. The oldest is dropped when a new one is added to a full queue
+    static const size_t kMaxTrackerSamples = 64;
+
+    namespace {
+        /** Spherical linear interpolation between two unit quaternions along the shortest path.
+         *  @param a    Quaternion at t = 0.
+         *  @param b    Quaternion at t = 1.
+         *  @param t    Interpolation position between 0 and 1.
+         *  @return     The interpolated quaternion.
+         */
+        RotationQuaternion slerp(const RotationQuaternion& a, const RotationQuaternion& b, double t)
+        {
+            double cosTheta = (double)a.w * b.w + (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+            // q and -q are the same rotation so use the one closest to a
+            double sign = cosTheta < 0. ? -1. : 1.;
+            cosTheta *= sign;
+
+            double wa = 1. - t;
+            double wb = t;
+            // Use linear interpolation when the angle is too small for the sine to be accurate
+            if (cosTheta < 0.9995)
+            {
+                double theta = std::acos(cosTheta);
+                double sinTheta = std::sin(theta);
+                wa = std::sin((1. - t) * theta) / sinTheta;
+                wb = std::sin(t * theta) / sinTheta;
+            }
+            wb *= sign;
+
+            double w = wa * a.w + wb * b.w;
+            double x = wa * a.x + wb * b.x;
+            double y = wa * a.y + wb * b.y;
+            double z = wa * a.z + wb * b.z;
+            double norm = std::sqrt(w * w + x * x + y * y + z * z);
+            return RotationQuaternion{ (float)(w / norm), (float)(x / norm), (float)(y / norm), (float)(z / norm) };
+        }
+
+        bool operator!=(const RotationQuaternion& a, const RotationQuaternion& b)
+        {
+            return a.w != b.w || a.x != b.x || a.y != b.y || a.z != b.z;
+        }
+    }
+
     AmbisonicRotator::AmbisonicRotator()
     {
-        m_sqrt3_2 = 0.5f * std::sqrt(3.f);
-        m_sqrt6_4 = 0.25f * std::sqrt(6.f);
-        m_sqrt10_4 = 0.25f * std::sqrt(10.f);
-        m_sqrt15_4 = 0.25f * std::sqrt(15.f);
-        m_sqrt15_2 = 0.5f * std::sqrt(15.f);
     }
 
     AmbisonicRotator::~AmbisonicRotator()
@@ -44,16 +87,23 @@ namespace spaudio {
         if (fadeTimeMilliSec < 0.f || !b3D)
             return false;
 
-        m_tempBuffer.Configure(nOrder, b3D, nBlockSize);
+        m_targetMatrix.resize(3, std::vector<double>(3, 0.));
+        m_targetMatrixTmp.resize(3, std::vector<double>(3, 0.));
+        m_yawMatrix.resize(3, std::vector<double>(3, 0.));
+        m_pitchMatrix.resize(3, std::vector<double>(3, 0.));
+        m_rollMatrix.resize(3, std::vector<double>(3, 0.));
 
-        auto nAmbiCh = GetChannelCount();
-        m_targetMatrix.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
-        m_targetMatrixTmp.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
-        m_currentMatrix.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
-        m_deltaMatrix.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
-        m_yawMatrix.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
-        m_pitchMatrix.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
-        m_rollMatrix.resize(nAmbiCh, std::vector<float>(nAmbiCh, 0.f));
+        unsigned nBlockCoeffs = OrderToRotationBlockPosition(nOrder + 1);
+        m_rotationBlocks.assign(nBlockCoeffs, 0.);
+        m_targetBlocks.assign(nBlockCoeffs, 0.f);
+        m_currentBlocks.assign(nBlockCoeffs, 0.f);
+        m_deltaBlocks.assign(nBlockCoeffs, 0.f);
+        m_chunkInput.assign((2 * nOrder + 1) * kChunkSize, 0.f);
+
+        m_trackerSamples.clear();
+        m_trackerSamples.reserve(kMaxTrackerSamples);
+        m_hasTrackerOrientation = false;
+        m_sampleTime = 0;
 
         m_fadingTimeMilliSec = fadeTimeMilliSec;
         m_fadingSamples = (unsigned)std::round(0.001f * m_fadingTimeMilliSec * (float)sampleRate);
@@ -65,8 +115,10 @@ namespace spaudio {
 
     void AmbisonicRotator::Reset()
     {
-        updateTargetRotationMatrix();
-        m_currentMatrix = m_targetMatrix;
+        // In head-tracking mode the target is already the latest tracker orientation
+        if (m_trackerInterval == 0 || !m_hasTrackerOrientation)
+            updateTargetRotationMatrix();
+        m_currentBlocks = m_targetBlocks;
         m_fadingCounter = m_fadingSamples;
     }
 
@@ -81,15 +133,16 @@ namespace spaudio {
         {
             m_orientation = orientation;
 
+            // The orientation is applied when head-tracking mode is disabled
+            if (m_trackerInterval > 0)
+                return;
+
             updateTargetRotationMatrix();
 
             // Update the coefficient step size to go from the current matrix to the new target.
             // If the fading time is set to zero then m_deltaMatrix is all zeros
-            for (unsigned i = 0; i < m_nChannelCount; ++i)
-                for (unsigned j = 0; j < m_nChannelCount; ++j)
-                {
-                    m_deltaMatrix[i][j] = m_fadingSamples == 0 ? 0.f : (m_targetMatrix[i][j] - m_currentMatrix[i][j]) / (float)m_fadingSamples;
-                }
+            for (size_t i = 0; i < m_targetBlocks.size(); ++i)
+                m_deltaBlocks[i] = m_fadingSamples == 0 ? 0.f : (m_targetBlocks[i] - m_currentBlocks[i]) / (float)m_fadingSamples;
 
             // Restart the cross-fading
             m_fadingCounter = 0;
@@ -110,228 +163,246 @@ namespace spaudio {
         return m_orientation;
     }
 
-    void AmbisonicRotator::Process(BFormat* pBFSrcDst, unsigned nSamples)
+    void AmbisonicRotator::SetTrackerUpdateInterval(unsigned nSamples)
     {
-        // Make a copy of the input to use during the matrix multiplication
-        m_tempBuffer = *pBFSrcDst;
+        if (m_trackerInterval == nSamples)
+            return;
 
-        // Clear the output buffer
-        pBFSrcDst->Reset();
+        bool wasTracking = m_trackerInterval > 0;
+        m_trackerInterval = nSamples;
+        m_trackerSamples.clear();
+        m_hasTrackerOrientation = false;
 
-        // The number of samples to fade, which might not be a full frame
-        unsigned nFadeSamp = std::min(nSamples, m_fadingSamples - m_fadingCounter);
+        // Finish any cross-fade so that tracking starts from a fixed orientation
+        m_currentBlocks = m_targetBlocks;
+        m_fadingCounter = m_fadingSamples;
 
-        if (m_fadingCounter < m_fadingSamples)
+        // Fade back to the orientation set by SetOrientation()
+        if (wasTracking && nSamples == 0)
         {
-            for (unsigned iOut = 0; iOut < m_nChannelCount; ++iOut)
-                for (unsigned iIn = 0; iIn < m_nChannelCount; ++iIn)
-                    if (std::abs(m_currentMatrix[iOut][iIn]) > 1e-6f && std::abs(m_targetMatrix[iOut][iIn]) > 1e-6f)
-                        for (unsigned iSamp = 0; iSamp < nFadeSamp; ++iSamp)
-                        {
-                            pBFSrcDst->m_ppfChannels[iOut][iSamp] += m_currentMatrix[iOut][iIn] * m_tempBuffer.m_ppfChannels[iIn][iSamp];
-                            m_currentMatrix[iOut][iIn] += m_deltaMatrix[iOut][iIn];
-                        }
-            m_fadingCounter += nFadeSamp;
+            updateTargetRotationMatrix();
+            for (size_t i = 0; i < m_targetBlocks.size(); ++i)
+                m_deltaBlocks[i] = m_fadingSamples == 0 ? 0.f : (m_targetBlocks[i] - m_currentBlocks[i]) / (float)m_fadingSamples;
+            m_fadingCounter = 0;
         }
+    }
 
-        // Process any remaining signal after cross-fading
-        for (unsigned iOut = 0; iOut < m_nChannelCount; ++iOut)
-            for (unsigned iIn = 0; iIn < m_nChannelCount; ++iIn)
-                if (std::abs(m_targetMatrix[iOut][iIn]) > 1e-6f)
-                    for (unsigned iSamp = nFadeSamp; iSamp < nSamples; ++iSamp)
-                    {
-                        pBFSrcDst->m_ppfChannels[iOut][iSamp] += m_targetMatrix[iOut][iIn] * m_tempBuffer.m_ppfChannels[iIn][iSamp];
-                    }
+    unsigned AmbisonicRotator::GetTrackerUpdateInterval() const
+    {
+        return m_trackerInterval;
+    }
+
+    void AmbisonicRotator::AddTrackerOrientation(const RotationQuaternion& orientation, unsigned nOffset)
+    {
+        if (m_trackerInterval == 0)
+            return;
+
+        double norm = std::sqrt((double)orientation.w * orientation.w + (double)orientation.x * orientation.x
+            + (double)orientation.y * orientation.y + (double)orientation.z * orientation.z);
+        if (norm == 0.)
+            return;
+
+        TrackerSample sample;
+        sample.time = m_sampleTime + nOffset;
+        sample.orientation = RotationQuaternion{ (float)(orientation.w / norm), (float)(orientation.x / norm),
+            (float)(orientation.y / norm), (float)(orientation.z / norm) };
+
+        // Keep the samples in time order. A sample at the same time as an existing one replaces it
+        auto it = std::lower_bound(m_trackerSamples.begin(), m_trackerSamples.end(), sample.time,
+            [](const TrackerSample& s, uint64_t time) { return s.time < time; });
+        if (it != m_trackerSamples.end() && it->time == sample.time)
+        {
+            *it = sample;
+            return;
+        }
+        if (m_trackerSamples.size() == kMaxTrackerSamples)
+        {
+            // The new sample would be the oldest so it is the one dropped
+            if (it == m_trackerSamples.begin())
+                return;
+            auto iInsert = it - m_trackerSamples.begin() - 1;
+            m_trackerSamples.erase(m_trackerSamples.begin());
+            it = m_trackerSamples.begin() + iInsert;
+        }
+        m_trackerSamples.insert(it, sample);
     }
 
-    void AmbisonicRotator::getYawMatrix(float yaw, std::vector<std::vector<float>>& yawMat)
+    void AmbisonicRotator::Process(BFormat* pBFSrcDst, unsigned nSamples)
     {
-        yawMat[0][0] = 1.f;
-        if (m_nOrder > 0)
+        if (m_trackerInterval > 0)
+        {
+            processTracking(pBFSrcDst, nSamples);
+            m_sampleTime += nSamples;
+            return;
+        }
+
+        // The number of samples to fade, which might not be a full frame
+        unsigned nFadeSamp = std::min(nSamples, m_fadingSamples - m_fadingCounter);
+
+        for (unsigned iStart = 0; iStart < nSamples; iStart += kChunkSize)
         {
-            float cosYaw = std::cos(yaw);
-            float sinYaw = std::sin(yaw);
-            yawMat[1][1] = cosYaw;
-            yawMat[1][3] = -sinYaw;
-            yawMat[2][2] = 1.f;
-            yawMat[3][1] = sinYaw;
-            yawMat[3][3] = cosYaw;
-
-            if (m_nOrder > 1)
+            unsigned nChunk = std::min(kChunkSize, nSamples - iStart);
+            // Split the chunk where the cross-fade ends
+            unsigned nChunkFade = iStart < nFadeSamp ? std::min(nChunk, nFadeSamp - iStart) : 0;
+            for (unsigned iOrder = 0; iOrder <= m_nOrder; ++iOrder)
             {
-                float cos2Yaw = std::cos(2.f * yaw);
-                float sin2Yaw = std::sin(2.f * yaw);
-                yawMat[4][4] = cos2Yaw;
-                yawMat[4][8] = -sin2Yaw;
-                yawMat[5][5] = cosYaw;
-                yawMat[5][7] = -sinYaw;
-                yawMat[6][6] = 1.f;
-                yawMat[7][5] = sinYaw;
-                yawMat[7][7] = cosYaw;
-                yawMat[8][4] = sin2Yaw;
-                yawMat[8][8] = cos2Yaw;
-
-                if (m_nOrder > 2)
-                {
-                    assert(m_nOrder <= 3);
-
-                    float cos3Yaw = std::cos(3.f * yaw);
-                    float sin3Yaw = std::sin(3.f * yaw);
-                    yawMat[9][9] = cos3Yaw;
-                    yawMat[9][15] = -sin3Yaw;
-                    yawMat[10][10] = cos2Yaw;
-                    yawMat[10][14] = -sin2Yaw;
-                    yawMat[11][11] = cosYaw;
-                    yawMat[11][13] = -sinYaw;
-                    yawMat[12][12] = 1.f;
-                    yawMat[13][11] = sinYaw;
-                    yawMat[13][13] = cosYaw;
-                    yawMat[14][10] = sin2Yaw;
-                    yawMat[14][14] = cos2Yaw;
-                    yawMat[15][9] = sin3Yaw;
-                    yawMat[15][15] = cos3Yaw;
-                }
+                if (nChunkFade > 0)
+                    processBlock(pBFSrcDst, iOrder, iStart, nChunkFade, true);
+                if (nChunkFade < nChunk)
+                    processBlock(pBFSrcDst, iOrder, iStart + nChunkFade, nChunk - nChunkFade, false);
             }
         }
+        m_fadingCounter += nFadeSamp;
+        m_sampleTime += nSamples;
     }
 
-    void AmbisonicRotator::getPitchMatrix(float pitch, std::vector<std::vector<float>>& pitchMat)
+    void AmbisonicRotator::processTracking(BFormat* pBFSrcDst, unsigned nSamples)
     {
-        pitchMat[0][0] = 1.f;
-        if (m_nOrder > 0)
+        for (unsigned iSub = 0; iSub < nSamples; iSub += m_trackerInterval)
         {
-            float cosPitch = std::cos(pitch);
-            float sinPitch = std::sin(pitch);
-            pitchMat[1][1] = 1.f;
-            pitchMat[2][2] = cosPitch;
-            pitchMat[2][3] = sinPitch;
-            pitchMat[3][2] = -sinPitch;
-            pitchMat[3][3] = cosPitch;
-
-            if (m_nOrder > 1)
+            unsigned nSub = std::min(m_trackerInterval, nSamples - iSub);
+
+            // Cross-fade to the orientation at the end of the sub-block if it has changed
+            RotationQuaternion orientation;
+            bool bFade = getTrackerOrientation(m_sampleTime + iSub + nSub, orientation)
+                && (!m_hasTrackerOrientation || orientation != m_trackerOrientation);
+            if (bFade)
             {
-                float cos2Pitch = std::cos(2.f * pitch);
-                float sin2Pitch = std::sin(2.f * pitch);
-                float cosPitchSq = cosPitch * cosPitch;
-                float sinPitchSq = sinPitch * sinPitch;
-                pitchMat[4][4] = cosPitch;
-                pitchMat[4][5] = -sinPitch;
-                pitchMat[5][4] = sinPitch;
-                pitchMat[5][5] = cosPitch;
-                pitchMat[6][6] = 1.f - 1.5f * sinPitchSq;
-                pitchMat[6][7] = m_sqrt3_2 * sin2Pitch;
-                pitchMat[6][8] = m_sqrt3_2 * sinPitchSq;
-                pitchMat[7][6] = -m_sqrt3_2 * sin2Pitch;
-                pitchMat[7][7] = cos2Pitch;
-                pitchMat[7][8] = 0.5f * sin2Pitch;
-                pitchMat[8][6] = m_sqrt3_2 * sinPitchSq;
-                pitchMat[8][7] = -0.5f * sin2Pitch;
-                pitchMat[8][8] = 0.5f * (1.f + cosPitchSq);
-
-                if (m_nOrder > 2)
-                {
-                    assert(m_nOrder <= 3);
-
-                    float sinPitchCu = sinPitchSq * sinPitch;
-                    pitchMat[9][9] = 0.25f * (3.f * cosPitchSq + 1.f);
-                    pitchMat[9][10] = -m_sqrt6_4 * sin2Pitch;
-                    pitchMat[9][11] = m_sqrt15_4 * sinPitchSq;
-                    pitchMat[10][9] = m_sqrt6_4 * sin2Pitch;
-                    pitchMat[10][10] = cos2Pitch;
-                    pitchMat[10][11] = -m_sqrt10_4 * sin2Pitch;
-                    pitchMat[11][9] = m_sqrt15_4 * sinPitchSq;
-                    pitchMat[11][10] = m_sqrt10_4 * sin2Pitch;
-                    pitchMat[11][11] = 1.f - 0.25f * 5.f * sinPitchSq;
-
-                    pitchMat[12][12] = 0.5f * cosPitch * (5.f * cosPitchSq - 3.f);
-                    pitchMat[12][13] = -m_sqrt6_4 * sinPitch * (5.f * sinPitchSq - 4.f);
-                    pitchMat[12][14] = -m_sqrt15_2 * cosPitch * (cosPitchSq - 1.f);
-                    pitchMat[12][15] = m_sqrt10_4 * sinPitchCu;
-                    pitchMat[13][12] = m_sqrt6_4 * sinPitch * (5.f * sinPitchSq - 4.f);
-                    pitchMat[13][13] = 0.25f * cosPitch * (15.f * cosPitchSq - 11.f);
-                    pitchMat[13][14] = -m_sqrt10_4 * sinPitch * (3.f * sinPitchSq - 2.f);
-                    pitchMat[13][15] = -m_sqrt15_4 * cosPitch * (cosPitchSq - 1.f);
-                    pitchMat[14][12] = -m_sqrt15_2 * cosPitch * (cosPitchSq - 1.f);
-                    pitchMat[14][13] = m_sqrt10_4 * sinPitch * (3.f * sinPitchSq - 2.f);
-                    pitchMat[14][14] = 0.5f * cosPitch * (3.f * cosPitchSq - 1.f);
-                    pitchMat[14][15] = -m_sqrt6_4 * sinPitch * (sinPitchSq - 2.f);
-                    pitchMat[15][12] = -m_sqrt10_4 * sinPitchCu;
-                    pitchMat[15][13] = -m_sqrt15_4 * cosPitch * (cosPitchSq - 1.f);
-                    pitchMat[15][14] = m_sqrt6_4 * sinPitch * (sinPitchSq - 2.f);
-                    pitchMat[15][15] = 0.25f * cosPitch * (cosPitchSq + 3.f);
-                }
+                m_trackerOrientation = orientation;
+                m_hasTrackerOrientation = true;
+
+                // The sound field is rotated by the inverse of the head orientation
+                const double w = orientation.w, x = orientation.x, y = orientation.y, z = orientation.z;
+                m_targetMatrix[0][0] = 1. - 2. * (y * y + z * z);
+                m_targetMatrix[0][1] = 2. * (x * y + w * z);
+                m_targetMatrix[0][2] = 2. * (x * z - w * y);
+                m_targetMatrix[1][0] = 2. * (x * y - w * z);
+                m_targetMatrix[1][1] = 1. - 2. * (x * x + z * z);
+                m_targetMatrix[1][2] = 2. * (y * z + w * x);
+                m_targetMatrix[2][0] = 2. * (x * z + w * y);
+                m_targetMatrix[2][1] = 2. * (y * z - w * x);
+                m_targetMatrix[2][2] = 1. - 2. * (x * x + y * y);
+                updateTargetBlocks();
+
+                for (size_t i = 0; i < m_targetBlocks.size(); ++i)
+                    m_deltaBlocks[i] = (m_targetBlocks[i] - m_currentBlocks[i]) / (float)nSub;
             }
+
+            for (unsigned iStart = iSub; iStart < iSub + nSub; iStart += kChunkSize)
+            {
+                unsigned nChunk = std::min(kChunkSize, iSub + nSub - iStart);
+                for (unsigned iOrder = 0; iOrder <= m_nOrder; ++iOrder)
+                    processBlock(pBFSrcDst, iOrder, iStart, nChunk, bFade);
+            }
+
+            // Avoid the accumulation of rounding errors in the cross-fades
+            if (bFade)
+                m_currentBlocks = m_targetBlocks;
         }
+
+        // Remove the samples that are no longer needed, keeping the latest one before the next block
+        uint64_t endTime = m_sampleTime + nSamples;
+        auto it = std::upper_bound(m_trackerSamples.begin(), m_trackerSamples.end(), endTime,
+            [](uint64_t time, const TrackerSample& s) { return time < s.time; });
+        if (it - m_trackerSamples.begin() > 1)
+            m_trackerSamples.erase(m_trackerSamples.begin(), it - 1);
     }
 
-    void AmbisonicRotator::getRollMatrix(float roll, std::vector<std::vector<float>>& rollMat)
+    bool AmbisonicRotator::getTrackerOrientation(uint64_t time, RotationQuaternion& orientation)
     {
-        rollMat[0][0] = 1.f;
-        if (m_nOrder > 0)
+        auto next = std::upper_bound(m_trackerSamples.begin(), m_trackerSamples.end(), time,
+            [](uint64_t t, const TrackerSample& s) { return t < s.time; });
+        if (next == m_trackerSamples.begin())
+            return false;
+
+        auto prev = next - 1;
+        if (next == m_trackerSamples.end())
+            orientation = prev->orientation;
+        else
+            orientation = slerp(prev->orientation, next->orientation, (double)(time - prev->time) / (double)(next->time - prev->time));
+
+        return true;
+    }
+
+    void AmbisonicRotator::processBlock(BFormat* pBFSrcDst, unsigned nOrder, unsigned iStart, unsigned nSamples, bool bFade)
+    {
+        const unsigned nCh = 2 * nOrder + 1;
+        const unsigned iFirstCh = nOrder * nOrder;
+        const unsigned iBlock = OrderToRotationBlockPosition(nOrder);
+        float* pCurrent = &m_currentBlocks[iBlock];
+        const float* pTarget = &m_targetBlocks[iBlock];
+        const float* pDelta = &m_deltaBlocks[iBlock];
+
+        // Copy the input so the output can be written to the same channels
+        for (unsigned iIn = 0; iIn < nCh; ++iIn)
+            memcpy(&m_chunkInput[iIn * kChunkSize], pBFSrcDst->m_ppfChannels[iFirstCh + iIn] + iStart, nSamples * sizeof(float));
+
+        for (unsigned iOut = 0; iOut < nCh; ++iOut)
         {
-            float cosRoll = std::cos(roll);
-            float sinRoll = std::sin(roll);
-            rollMat[1][1] = cosRoll;
-            rollMat[1][2] = sinRoll;
-            rollMat[2][1] = -sinRoll;
-            rollMat[2][2] = cosRoll;
-            rollMat[3][3] = 1.f;
-
-            if (m_nOrder > 1)
+            float* pOut = pBFSrcDst->m_ppfChannels[iFirstCh + iOut] + iStart;
+            memset(pOut, 0, nSamples * sizeof(float));
+            for (unsigned iIn = 0; iIn < nCh; ++iIn)
             {
-                float cos2Roll = std::cos(2.f * roll);
-                float sin2Roll = std::sin(2.f * roll);
-                float cosRollSq = cosRoll * cosRoll;
-                float sinRollSq = sinRoll * sinRoll;
-                rollMat[4][4] = cosRoll;
-                rollMat[4][7] = sinRoll;
-                rollMat[5][5] = cos2Roll;
-                rollMat[5][6] = m_sqrt3_2 * sin2Roll;
-                rollMat[5][8] = 0.5f * sin2Roll;
-                rollMat[6][5] = -m_sqrt3_2 * sin2Roll;
-                rollMat[6][6] = 1.f - 1.5f * sinRollSq;
-                rollMat[6][8] = -m_sqrt3_2 * sinRollSq;
-                rollMat[7][4] = -sinRoll;
-                rollMat[7][7] = cosRoll;
-                rollMat[8][5] = -0.5f * sin2Roll;
-                rollMat[8][6] = -m_sqrt3_2 * sinRollSq;
-                rollMat[8][8] = 0.5f * (cosRollSq + 1.f);
-
-                if (m_nOrder > 2)
+                const unsigned iCoeff = iOut * nCh + iIn;
+                const float* pIn = &m_chunkInput[iIn * kChunkSize];
+                if (bFade)
                 {
-                    assert(m_nOrder <= 3);
-                    float sinRollCu = sinRollSq * sinRoll;
-
-                    rollMat[9][9] = 0.25f * cosRoll * (cosRollSq + 3.f);
-                    rollMat[9][11] = m_sqrt15_4 * cosRoll * (cosRollSq - 1.f);
-                    rollMat[9][12] = -m_sqrt10_4 * sinRollCu;
-                    rollMat[9][14] = -m_sqrt6_4 * sinRoll * (sinRollSq - 2.f);
-                    rollMat[10][10] = cos2Roll;
-                    rollMat[10][13] = m_sqrt10_4 * sin2Roll;
-                    rollMat[10][15] = m_sqrt6_4 * sin2Roll;
-                    rollMat[11][9] = m_sqrt15_4 * cosRoll * (cosRollSq - 1.f);
-                    rollMat[11][11] = 0.25f * cosRoll * (15.f * cosRollSq - 11.f);
-                    rollMat[11][12] = -m_sqrt6_4 * sinRoll * (5.f * sinRollSq - 4.f);
-                    rollMat[11][14] = -m_sqrt10_4 * sinRoll * (3.f * sinRollSq - 2.f);
-                    rollMat[12][9] = m_sqrt10_4 * sinRollCu;
-                    rollMat[12][11] = m_sqrt6_4 * sinRoll * (5.f * sinRollSq - 4.f);
-                    rollMat[12][12] = 0.5f * cosRoll * (5.f * cosRollSq - 3.f);
-                    rollMat[12][14] = m_sqrt15_2 * cosRoll * (cosRollSq - 1.f);
-                    rollMat[13][10] = -m_sqrt10_4 * sin2Roll;
-                    rollMat[13][13] = 1.f - 1.25f * sinRollSq;
-                    rollMat[13][15] = -m_sqrt15_4 * sinRollSq;
-                    rollMat[14][9] = m_sqrt6_4 * sinRoll * (sinRollSq - 2.f);
-                    rollMat[14][11] = m_sqrt10_4 * sinRoll * (3.f * sinRollSq - 2.f);
-                    rollMat[14][12] = m_sqrt15_2 * cosRoll * (cosRollSq - 1.f);
-                    rollMat[14][14] = 0.5f * cosRoll * (3.f * cosRollSq - 1.f);
-                    rollMat[15][10] = -m_sqrt6_4 * sin2Roll;
-                    rollMat[15][13] = -m_sqrt15_4 * sinRollSq;
-                    rollMat[15][15] = 0.25f * (3.f * cosRollSq + 1);
+                    // Coefficients that stay close to zero throughout the fade are skipped
+                    if (std::abs(pCurrent[iCoeff]) > 1e-6f || std::abs(pTarget[iCoeff]) > 1e-6f)
+                        simd::MultiplyAccumulateRamp(pIn, pCurrent[iCoeff], pDelta[iCoeff], pOut, nSamples);
+                    pCurrent[iCoeff] += (float)nSamples * pDelta[iCoeff];
                 }
+                else if (std::abs(pTarget[iCoeff]) > 1e-6f)
+                    simd::MultiplyAccumulate(pIn, pTarget[iCoeff], pOut, nSamples);
             }
         }
     }
 
+    void AmbisonicRotator::getYawMatrix(double yaw, std::vector<std::vector<double>>& yawMat)
+    {
+        double cosYaw = std::cos(yaw);
+        double sinYaw = std::sin(yaw);
+        yawMat[0][0] = cosYaw;
+        yawMat[0][1] = sinYaw;
+        yawMat[0][2] = 0.;
+        yawMat[1][0] = -sinYaw;
+        yawMat[1][1] = cosYaw;
+        yawMat[1][2] = 0.;
+        yawMat[2][0] = 0.;
+        yawMat[2][1] = 0.;
+        yawMat[2][2] = 1.;
+    }
+
+    void AmbisonicRotator::getPitchMatrix(double pitch, std::vector<std::vector<double>>& pitchMat)
+    {
+        double cosPitch = std::cos(pitch);
+        double sinPitch = std::sin(pitch);
+        pitchMat[0][0] = cosPitch;
+        pitchMat[0][1] = 0.;
+        pitchMat[0][2] = -sinPitch;
+        pitchMat[1][0] = 0.;
+        pitchMat[1][1] = 1.;
+        pitchMat[1][2] = 0.;
+        pitchMat[2][0] = sinPitch;
+        pitchMat[2][1] = 0.;
+        pitchMat[2][2] = cosPitch;
+    }
+
+    void AmbisonicRotator::getRollMatrix(double roll, std::vector<std::vector<double>>& rollMat)
+    {
+        double cosRoll = std::cos(roll);
+        double sinRoll = std::sin(roll);
+        rollMat[0][0] = 1.;
+        rollMat[0][1] = 0.;
+        rollMat[0][2] = 0.;
+        rollMat[1][0] = 0.;
+        rollMat[1][1] = cosRoll;
+        rollMat[1][2] = sinRoll;
+        rollMat[2][0] = 0.;
+        rollMat[2][1] = -sinRoll;
+        rollMat[2][2] = cosRoll;
+    }
+
     void AmbisonicRotator::updateTargetRotationMatrix()
     {
         // Calculate the yaw matrix using the inverse
@@ -386,6 +457,16 @@ namespace spaudio {
             multiplyMat(m_rollMatrix, m_targetMatrixTmp, m_targetMatrix);
             break;
         }
+
+        updateTargetBlocks();
+    }
+
+    void AmbisonicRotator::updateTargetBlocks()
+    {
+        // Expand the 3x3 rotation to the spherical harmonic rotation of each order
+        ShRotationMatrixBlocks(m_targetMatrix, m_nOrder, m_rotationBlocks);
+        for (size_t i = 0; i < m_rotationBlocks.size(); ++i)
+            m_targetBlocks[i] = (float)m_rotationBlocks[i];
     }
 
 } // namespace spaudio
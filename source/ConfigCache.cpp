@@ -0,0 +1,330 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A persistent cache of data precomputed at configuration                 #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      ConfigCache.cpp                                          #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#include "config.h"
+#include "ConfigCache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+namespace spaudio {
+
+    namespace {
+        const char kMagic[4] = { 'S', 'P', 'A', 'C' };
+        // Increase when the file format or the data stored by any class changes
+        const uint32_t kFormatVersion = 1;
+        // Written in native byte order to detect files from machines with a different byte order
+        const uint32_t kByteOrderMark = 0x01020304;
+
+        const uint64_t kFnvOffset = 14695981039346656037ull;
+        const uint64_t kFnvPrime = 1099511628211ull;
+
+        uint64_t fnv1a(uint64_t hash, const void* pData, size_t nBytes)
+        {
+            const unsigned char* p = (const unsigned char*)pData;
+            for (size_t i = 0; i < nBytes; ++i)
+            {
+                hash ^= p[i];
+                hash *= kFnvPrime;
+            }
+            return hash;
+        }
+
+        template<typename T>
+        void write(std::vector<char>& buffer, const T& value)
+        {
+            const char* p = (const char*)&value;
+            buffer.insert(buffer.end(), p, p + sizeof(T));
+        }
+
+        // Reads from a buffer, failing once the end is passed
+        class Reader
+        {
+        public:
+            Reader(const std::vector<char>& buffer, size_t nBytes) : m_buffer(buffer), m_nBytes(nBytes) {}
+
+            bool read(void* pData, size_t nBytes)
+            {
+                if (nBytes > m_nBytes - m_pos)
+                    return false;
+                std::memcpy(pData, m_buffer.data() + m_pos, nBytes);
+                m_pos += nBytes;
+                return true;
+            }
+            template<typename T>
+            bool read(T& value)
+            {
+                return read(&value, sizeof(T));
+            }
+            bool isAtEnd() const
+            {
+                return m_pos == m_nBytes;
+            }
+
+        private:
+            const std::vector<char>& m_buffer;
+            size_t m_nBytes;
+            size_t m_pos = 0;
+        };
+
+        // A table shared between the ConfigCache objects with the same key
+        struct SharedTable
+        {
+            std::weak_ptr<const void> table;
+            std::type_index type = typeid(void);
+            size_t nBytes = 0;
+        };
+
+        // The tables shared in the process, identified by the key and the name of the table. The registry only holds
+        // weak references so a table is freed when the last object using it is destroyed
+        struct SharedTableRegistry
+        {
+            std::mutex mutex;
+            std::map<std::pair<uint64_t, std::string>, SharedTable> tables;
+
+            // Remove the tables that are no longer in use. The mutex must be locked
+            void removeExpired()
+            {
+                for (auto it = tables.begin(); it != tables.end();)
+                    it = it->second.table.expired() ? tables.erase(it) : std::next(it);
+            }
+        };
+
+        SharedTableRegistry& sharedTableRegistry()
+        {
+            static SharedTableRegistry registry;
+            return registry;
+        }
+    }
+
+    ConfigCache::ConfigCache() : m_key(kFnvOffset)
+    {
+        // Entries from other versions of the library or FFT implementations are never reused
+        AddToKey(std::string(SPAUDIO_VERSION));
+        AddToKey(kFormatVersion);
+#ifdef HAVE_FFTW
+        AddToKey(std::string("fftw"));
+#endif
+    }
+
+    ConfigCache::~ConfigCache()
+    {
+    }
+
+    void ConfigCache::AddToKey(const void* pData, size_t nBytes)
+    {
+        m_key = fnv1a(m_key, pData, nBytes);
+    }
+
+    void ConfigCache::AddToKey(const std::string& str)
+    {
+        // Include the length so that consecutive strings cannot be confused
+        AddToKey((unsigned int)str.size());
+        AddToKey(str.data(), str.size());
+    }
+
+    void ConfigCache::AddToKey(unsigned int value)
+    {
+        AddToKey(&value, sizeof(value));
+    }
+
+    void ConfigCache::AddToKey(double value)
+    {
+        AddToKey(&value, sizeof(value));
+    }
+
+    bool ConfigCache::AddFileToKey(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (file.bad())
+            return false;
+        AddToKey(std::string(contents.begin(), contents.end()));
+        return true;
+    }
+
+    uint64_t ConfigCache::GetKey() const
+    {
+        return m_key;
+    }
+
+    std::string ConfigCache::GetFilePath(const std::string& directory) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "spaudio-%016llx.bin", (unsigned long long)m_key);
+        if (directory.empty())
+            return name;
+        char last = directory.back();
+        return (last == '/' || last == '\\') ? directory + name : directory + "/" + name;
+    }
+
+    bool ConfigCache::Load(const std::string& directory)
+    {
+        m_arrays.clear();
+        m_isModified = false;
+
+        std::ifstream file(GetFilePath(directory), std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        std::streamoff fileSize = file.tellg();
+        if (fileSize < (std::streamoff)sizeof(uint64_t))
+            return false;
+        std::vector<char> buffer((size_t)fileSize);
+        file.seekg(0);
+        if (!file.read(buffer.data(), fileSize))
+            return false;
+
+        // The checksum of the contents is stored at the end of the file
+        size_t nContentBytes = buffer.size() - sizeof(uint64_t);
+        uint64_t checksum = 0;
+        std::memcpy(&checksum, buffer.data() + nContentBytes, sizeof(checksum));
+        if (checksum != fnv1a(kFnvOffset, buffer.data(), nContentBytes))
+            return false;
+
+        Reader reader(buffer, nContentBytes);
+        char magic[4];
+        uint32_t formatVersion = 0, byteOrderMark = 0, nArrays = 0;
+        uint64_t key = 0;
+        if (!reader.read(magic) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0
+            || !reader.read(formatVersion) || formatVersion != kFormatVersion
+            || !reader.read(byteOrderMark) || byteOrderMark != kByteOrderMark
+            || !reader.read(key) || key != m_key
+            || !reader.read(nArrays))
+            return false;
+
+        std::map<std::string, Array> arrays;
+        for (uint32_t iArray = 0; iArray < nArrays; ++iArray)
+        {
+            uint32_t nNameBytes = 0;
+            uint64_t nBytes = 0;
+            Array array;
+            if (!reader.read(nNameBytes) || nNameBytes > nContentBytes)
+                return false;
+            std::string name(nNameBytes, '\0');
+            if (!reader.read(&name[0], nNameBytes) || !reader.read(array.type) || !reader.read(nBytes) || nBytes > nContentBytes)
+                return false;
+            array.bytes.resize((size_t)nBytes);
+            if (!reader.read(array.bytes.data(), array.bytes.size()))
+                return false;
+            arrays[name] = std::move(array);
+        }
+        if (!reader.isAtEnd())
+            return false;
+
+        m_arrays = std::move(arrays);
+        return true;
+    }
+
+    bool ConfigCache::Save(const std::string& directory)
+    {
+        std::vector<char> buffer;
+        buffer.insert(buffer.end(), kMagic, kMagic + sizeof(kMagic));
+        write(buffer, kFormatVersion);
+        write(buffer, kByteOrderMark);
+        write(buffer, m_key);
+        write(buffer, (uint32_t)m_arrays.size());
+        for (auto& namedArray : m_arrays)
+        {
+            write(buffer, (uint32_t)namedArray.first.size());
+            buffer.insert(buffer.end(), namedArray.first.begin(), namedArray.first.end());
+            write(buffer, namedArray.second.type);
+            write(buffer, (uint64_t)namedArray.second.bytes.size());
+            buffer.insert(buffer.end(), namedArray.second.bytes.begin(), namedArray.second.bytes.end());
+        }
+        write(buffer, fnv1a(kFnvOffset, buffer.data(), buffer.size()));
+
+        // Each save uses a different temporary file so that renderers configured at the same time do not interfere
+        static std::atomic<unsigned int> saveCount(0);
+        std::string path = GetFilePath(directory);
+        std::string tempPath = path + "." + std::to_string((uintptr_t)this) + "." + std::to_string(saveCount++) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file || !file.write(buffer.data(), buffer.size()) || !file.flush())
+            {
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            // Renaming fails on some platforms if the entry exists, in which case it was saved by someone else
+            std::remove(tempPath.c_str());
+            std::ifstream existing(path, std::ios::binary);
+            if (!existing)
+                return false;
+        }
+
+        m_isModified = false;
+        return true;
+    }
+
+    bool ConfigCache::IsModified() const
+    {
+        return m_isModified;
+    }
+
+    SharedTableStatistics ConfigCache::GetSharedTableStatistics()
+    {
+        SharedTableRegistry& registry = sharedTableRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.removeExpired();
+
+        SharedTableStatistics statistics;
+        statistics.nTables = registry.tables.size();
+        for (auto& sharedTable : registry.tables)
+            statistics.nBytes += sharedTable.second.nBytes;
+        return statistics;
+    }
+
+    std::shared_ptr<const void> ConfigCache::FindShared(const std::string& name, std::type_index type) const
+    {
+        SharedTableRegistry& registry = sharedTableRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.tables.find(std::make_pair(m_key, name));
+        if (it == registry.tables.end() || it->second.type != type)
+            return nullptr;
+        return it->second.table.lock();
+    }
+
+    std::shared_ptr<const void> ConfigCache::InsertShared(const std::string& name, std::type_index type, std::shared_ptr<const void> table, size_t nBytes)
+    {
+        SharedTableRegistry& registry = sharedTableRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.removeExpired();
+
+        // If another object configured at the same time shared its table first then use that one
+        SharedTable& sharedTable = registry.tables[std::make_pair(m_key, name)];
+        if (sharedTable.type == type)
+            if (auto existing = sharedTable.table.lock())
+                return existing;
+
+        sharedTable.table = table;
+        sharedTable.type = type;
+        sharedTable.nBytes = nBytes;
+        return table;
+    }
+
+    const std::vector<char>* ConfigCache::Find(const std::string& name, uint32_t type) const
+    {
+        auto it = m_arrays.find(name);
+        if (it == m_arrays.end() || it->second.type != type)
+            return nullptr;
+        return &it->second.bytes;
+    }
+
+} // namespace spaudio
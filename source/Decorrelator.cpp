@@ -11,53 +11,23 @@
 /*############################################################################*/
 
 #include "Decorrelator.h"
+#include "ConfigCache.h"
+#include "FFT.h"
 
+#include <cstring>
 #include<random>
 
 namespace spaudio {
 
     Decorrelator::Decorrelator()
     {
-        m_pfScratchBufferA = nullptr;
-        m_pFFT_decor_cfg = nullptr;
-        m_pIFFT_decor_cfg = nullptr;
-        m_ppcpDecorFilters = nullptr;
-        m_pcpScratch = nullptr;
-        m_pfOverlap = nullptr;
     }
 
     Decorrelator::~Decorrelator()
     {
-        if (m_pfScratchBufferA)
-            delete[] m_pfScratchBufferA;
-        if (m_pFFT_decor_cfg)
-            kiss_fftr_free(m_pFFT_decor_cfg);
-        if (m_pIFFT_decor_cfg)
-            kiss_fftr_free(m_pIFFT_decor_cfg);
-        if (m_ppcpDecorFilters)
-        {
-            for (unsigned i = 0; i < m_nCh; i++)
-                if (m_ppcpDecorFilters[i])
-                    delete[] m_ppcpDecorFilters[i];
-            delete[] m_ppcpDecorFilters;
-        }
-        if (m_pcpScratch)
-            delete[] m_pcpScratch;
-        if (m_pfOverlap) {
-            for (unsigned i = 0; i < m_nCh; i++)
-                if (m_pfOverlap[i])
-                    delete[] m_pfOverlap[i];
-            delete[] m_pfOverlap;
-        }
-        if (m_ppfDirectDelay) {
-            for (unsigned i = 0; i < m_nCh; i++)
-                if (m_ppfDirectDelay[i])
-                    delete[] m_ppfDirectDelay[i];
-            delete[] m_ppfDirectDelay;
-        }
     }
 
-    bool Decorrelator::Configure(Layout layout, unsigned int nBlockSize)
+    bool Decorrelator::Configure(Layout layout, unsigned int nBlockSize, ConfigCache* pCache)
     {
         m_layout = layout;
 
@@ -74,47 +44,48 @@ namespace spaudio {
         // Length of the delay lines used to compensate the direct signal
         m_nDelayLineLength = m_nDecorrelationFilterSamples + m_nBlockSize;
 
-        //What will the overlap size be?
-        m_nOverlapLength = m_nBlockSize < m_nTaps ? m_nBlockSize - 1 : m_nTaps - 1;
-        //How large does the FFT need to be
-        m_nFFTSize = 1;
-        while (m_nFFTSize < (m_nBlockSize + m_nTaps + m_nOverlapLength))
-            m_nFFTSize <<= 1;
-        //How many bins is that
-        m_nFFTBins = m_nFFTSize / 2 + 1;
-        //What do we need to scale the result of the iFFT by
-        m_fFFTScaler = 1.f / m_nFFTSize;
-
         //Allocate buffers
-        m_pfOverlap = new float* [m_nCh];
-        m_ppfDirectDelay = new float* [m_nCh];
-        for (unsigned i = 0; i < m_nCh; i++)
-        {
-            m_pfOverlap[i] = new float[m_nOverlapLength];
-            m_ppfDirectDelay[i] = new float[m_nDelayLineLength];
-        }
+        m_ppfDirectDelay.assign(m_nCh, std::vector<float>(m_nDelayLineLength));
 
-        m_pfScratchBufferA = new float[m_nFFTSize];
-        m_ppcpDecorFilters = new kiss_fft_cpx * [m_nCh];
-        for (unsigned i = 0; i < m_nCh; i++)
-            m_ppcpDecorFilters[i] = new kiss_fft_cpx[m_nFFTBins];
-
-        m_pcpScratch = new kiss_fft_cpx[m_nFFTBins];
+        // Each diffuse channel is filtered by its own decorrelation filter
+        if (!m_convolver.Configure(m_nCh, m_nCh, m_nTaps, m_nBlockSize))
+            return false;
 
         Reset();
 
-        //Allocate FFT and iFFT for new size
-        m_pFFT_decor_cfg = kiss_fftr_alloc(m_nFFTSize, 0, 0, 0);
-        m_pIFFT_decor_cfg = kiss_fftr_alloc(m_nFFTSize, 1, 0, 0);
+        // Use the filters of another decorrelator with the same configuration if there is one
+        if (pCache && m_convolver.SetFilters(pCache->GetShared<FrequencyDomainConvolver::FilterSet>("Decorrelator.filters")))
+            return true;
+
+        // Get the decorrelation filter bank, which only depends on the layout
+        std::vector<std::vector<float>> decorrelationFilters;
+        std::vector<float> cachedFilters;
+        if (pCache && pCache->Get("Decorrelator.filters", cachedFilters) && cachedFilters.size() == m_nCh * m_nDecorrelationFilterSamples)
+        {
+            const unsigned int nSamples = m_nDecorrelationFilterSamples;
+            decorrelationFilters.resize(m_nCh);
+            for (unsigned i_m = 0; i_m < m_nCh; i_m++)
+                decorrelationFilters[i_m].assign(cachedFilters.begin() + i_m * nSamples, cachedFilters.begin() + (i_m + 1) * nSamples);
+        }
+        else
+        {
+            decorrelationFilters = CalculateDecorrelationFilterBank();
+            if (pCache)
+            {
+                cachedFilters.clear();
+                for (auto& filter : decorrelationFilters)
+                    cachedFilters.insert(cachedFilters.end(), filter.begin(), filter.end());
+                pCache->Set("Decorrelator.filters", cachedFilters.data(), cachedFilters.size());
+            }
+        }
 
-        // Get the decorrelation filter bank
-        decorrelationFilters = CalculateDecorrelationFilterBank();
+        for (unsigned i_m = 0; i_m < m_nCh; i_m++)
+            m_convolver.SetFilter(i_m, i_m, decorrelationFilters[i_m].data(), m_nTaps);
 
-        for (unsigned i_m = 0; i_m < m_nCh; i_m++) {
-            // Convert the impulse responses to the frequency domain
-            memcpy(m_pfScratchBufferA, &decorrelationFilters[i_m][0], m_nTaps * sizeof(float));
-            memset(&m_pfScratchBufferA[m_nTaps], 0, (m_nFFTSize - m_nTaps) * sizeof(float));
-            kiss_fftr(m_pFFT_decor_cfg, m_pfScratchBufferA, m_ppcpDecorFilters[i_m]);
+        if (pCache)
+        {
+            auto filters = m_convolver.GetFilters();
+            m_convolver.SetFilters(pCache->Share("Decorrelator.filters", filters, filters->GetMemoryUsage()));
         }
 
         return true;
@@ -122,55 +93,30 @@ namespace spaudio {
 
     void Decorrelator::Reset()
     {
-        for (unsigned i = 0; i < m_nCh; i++)
-        {
-            memset(m_pfOverlap[i], 0, m_nOverlapLength * sizeof(float));
-            memset(m_ppfDirectDelay[i], 0, m_nDelayLineLength * sizeof(float));
-        }
+        for (auto& delayLine : m_ppfDirectDelay)
+            std::fill(delayLine.begin(), delayLine.end(), 0.f);
+        m_convolver.Reset();
     }
 
     void Decorrelator::Process(float** ppInDirect, float** ppInDiffuse, unsigned int nSamples)
     {
-        kiss_fft_cpx cpTemp;
-
         // get the read position that is static across all samples
         m_nReadPos = m_nWritePos - m_nDelay;
         if (m_nReadPos < 0)
             m_nReadPos += m_nDelayLineLength;
 
-        memset(m_pfScratchBufferA, 0, m_nFFTSize * sizeof(float));
         for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
         {
             // delay the direct input
             // Write to the delay line
-            WriteToDelayLine(m_ppfDirectDelay[iCh], &ppInDirect[iCh][0], m_nWritePos, nSamples);
+            WriteToDelayLine(m_ppfDirectDelay[iCh].data(), &ppInDirect[iCh][0], m_nWritePos, nSamples);
             // Read from the delay line
-            ReadFromDelayLine(m_ppfDirectDelay[iCh], &ppInDirect[iCh][0], m_nReadPos, nSamples);
-
-            // Apply the decorrelation filters
-            memcpy(m_pfScratchBufferA, &ppInDiffuse[iCh][0], m_nBlockSize * sizeof(float));
-            memset(&m_pfScratchBufferA[m_nBlockSize], 0, (m_nFFTSize - m_nBlockSize) * sizeof(float));
-            kiss_fftr(m_pFFT_decor_cfg, m_pfScratchBufferA, m_pcpScratch);
-            // Perform the convolution in the frequency domain
-            for (unsigned ni = 0; ni < m_nFFTBins; ni++)
-            {
-                cpTemp.r = m_pcpScratch[ni].r * m_ppcpDecorFilters[iCh][ni].r
-                    - m_pcpScratch[ni].i * m_ppcpDecorFilters[iCh][ni].i;
-                cpTemp.i = m_pcpScratch[ni].r * m_ppcpDecorFilters[iCh][ni].i
-                    + m_pcpScratch[ni].i * m_ppcpDecorFilters[iCh][ni].r;
-                m_pcpScratch[ni] = cpTemp;
-            }
-            // Convert from frequency domain back to time domain
-            kiss_fftri(m_pIFFT_decor_cfg, m_pcpScratch, m_pfScratchBufferA);
-            for (unsigned ni = 0; ni < m_nFFTSize; ni++)
-                m_pfScratchBufferA[ni] *= m_fFFTScaler;
-            memcpy(&ppInDiffuse[iCh][0], m_pfScratchBufferA, m_nBlockSize * sizeof(float));
-            for (unsigned ni = 0; ni < m_nOverlapLength; ni++)
-            {
-                ppInDiffuse[iCh][ni] += m_pfOverlap[iCh][ni];
-            }
-            memcpy(m_pfOverlap[iCh], &m_pfScratchBufferA[m_nBlockSize], m_nOverlapLength * sizeof(float));
+            ReadFromDelayLine(m_ppfDirectDelay[iCh].data(), &ppInDirect[iCh][0], m_nReadPos, nSamples);
         }
+
+        // Apply the decorrelation filters
+        m_convolver.Process(ppInDiffuse, ppInDiffuse, nSamples);
+
         // Advance the read/write positions
         m_nWritePos += nSamples;
         if (m_nWritePos >= (int)m_nDelayLineLength)
@@ -230,24 +176,25 @@ namespace spaudio {
 
 
         // Calculate the frequency domain data
-        std::vector<kiss_fft_cpx> x(N / 2 + 1, { 1.,0. });
+        std::vector<float> x(N + 2, 0.f);
+        x[0] = 1.f;
+        x[N] = 1.f;
         // The first and last elements in the frequency domain data are 1 (phase = 0) so
         // only loop over the points between
         for (int i = 1; i < N / 2; ++i)
         {
             double phaseAngle = 2. * M_PI * r[i - 1];
-            x[i].r = cosf((float)phaseAngle);
-            x[i].i = sinf((float)phaseAngle);
+            x[2 * i] = cosf((float)phaseAngle);
+            x[2 * i + 1] = sinf((float)phaseAngle);
         }
         // Calculate the time domain data
         std::vector<float> decorrelationFilter(m_nDecorrelationFilterSamples);
-        kiss_fftr_cfg ifft_cfg = kiss_fftr_alloc(m_nDecorrelationFilterSamples, 1, 0, 0);
-        kiss_fftri(ifft_cfg, &x[0], &decorrelationFilter[0]);
+        FFT ifft;
+        ifft.Configure(m_nDecorrelationFilterSamples);
+        ifft.Inverse(&x[0], &decorrelationFilter[0]);
         for (auto& sample : decorrelationFilter)
             sample /= (float)m_nDecorrelationFilterSamples;
 
-        kiss_fftr_free(ifft_cfg);
-
         return decorrelationFilter;
     }
 
@@ -11,7 +11,9 @@
 /*############################################################################*/
 
 #include "GainInterp.h"
+#include "dsp/SimdKernels.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <cstddef>
 #include <cmath>
@@ -19,7 +21,7 @@
 namespace spaudio {
 
     template<typename T>
-    GainInterp<T>::GainInterp(unsigned int nCh) : m_currentGainVec(nCh), m_targetGainVec(nCh), m_targetGainVecTmp(nCh), m_deltaGainVec(nCh)
+    GainInterp<T>::GainInterp(unsigned int nCh) : m_targetGainVec(nCh), m_targetGainVecTmp(nCh), m_startGainVec(nCh), m_deltaGainVec(nCh)
     {
 
     }
@@ -46,10 +48,13 @@ namespace spaudio {
         {
             if (interpTimeInSamples > 0)
             {
+                // Start the new interpolation from the gains reached so far
+                for (unsigned int i = 0; i < (unsigned int)m_startGainVec.size(); ++i)
+                    m_startGainVec[i] = GetCurrentGain(i);
                 m_targetGainVec = newGainVec;
 
                 for (size_t i = 0; i < m_targetGainVec.size(); ++i)
-                    m_deltaGainVec[i] = (m_targetGainVec[i] - m_currentGainVec[i]) / static_cast<T>(interpTimeInSamples);
+                    m_deltaGainVec[i] = (static_cast<float>(m_targetGainVec[i]) - m_startGainVec[i]) / static_cast<float>(interpTimeInSamples);
 
                 m_interpDurInSamples = interpTimeInSamples;
                 // Reset the interpolation counter to start interpolation
@@ -59,9 +64,10 @@ namespace spaudio {
             {
                 // If smoothing time is zero samples then set current and target vectors to the current value and do not interpolate
                 m_targetGainVec = newGainVec;
-                m_currentGainVec = newGainVec;
+                for (size_t i = 0; i < m_targetGainVec.size(); ++i)
+                    m_startGainVec[i] = static_cast<float>(m_targetGainVec[i]);
                 for (auto& g : m_deltaGainVec)
-                    g = static_cast<T>(0.);
+                    g = 0.f;
                 m_interpDurInSamples = interpTimeInSamples;
                 m_iInterpCount = m_interpDurInSamples;
             }
@@ -84,11 +90,7 @@ namespace spaudio {
         if (m_iInterpCount < m_interpDurInSamples)
         {
             for (unsigned int iCh = 0; iCh < nCh; ++iCh)
-                for (unsigned int i = 0; i < nInterpSamples; ++i)
-                {
-                    ppOut[iCh][i + nOffset] = pIn[i] * static_cast<float>(m_currentGainVec[iCh]);
-                    m_currentGainVec[iCh] += m_deltaGainVec[iCh];
-                }
+                simd::MultiplyRamp(pIn, GetCurrentGain(iCh), m_deltaGainVec[iCh], ppOut[iCh] + nOffset, nInterpSamples);
 
             m_iInterpCount += nInterpSamples;
         }
@@ -99,8 +101,7 @@ namespace spaudio {
             if (std::abs(gain - 1.f) <= 1e-5f) // If gain is almost 1 then don't process this channel
                 continue;
 
-            for (unsigned int i = nInterpSamples; i < nSamples; ++i)
-                ppOut[iCh][i + nOffset] = pIn[i] * gain;
+            simd::Multiply(pIn + nInterpSamples, gain, ppOut[iCh] + nOffset + nInterpSamples, nSamples - nInterpSamples);
         }
     }
 
@@ -116,27 +117,23 @@ namespace spaudio {
         unsigned int nCh = (unsigned int)m_targetGainVec.size();
         // The number of samples to interpolate over in this block
         unsigned int nInterpSamples = std::min(nSamples, m_interpDurInSamples - m_iInterpCount);
+        const float fGain = static_cast<float>(gain);
 
         if (m_iInterpCount < m_interpDurInSamples)
         {
             for (unsigned int iCh = 0; iCh < nCh; ++iCh)
-                for (unsigned int i = 0; i < nInterpSamples; ++i)
-                {
-                    ppOut[iCh][i + nOffset] += pIn[i] * static_cast<float>(m_currentGainVec[iCh] * gain);
-                    m_currentGainVec[iCh] += m_deltaGainVec[iCh];
-                }
+                simd::MultiplyAccumulateRamp(pIn, GetCurrentGain(iCh) * fGain, m_deltaGainVec[iCh] * fGain, ppOut[iCh] + nOffset, nInterpSamples);
 
             m_iInterpCount += nInterpSamples;
         }
 
         for (unsigned int iCh = 0; iCh < nCh; ++iCh)
         {
-            float gain = static_cast<float>(m_targetGainVec[iCh]);
-            if (std::abs(gain) < 1e-5f)
+            float targetGain = static_cast<float>(m_targetGainVec[iCh]) * fGain;
+            if (std::abs(targetGain) < 1e-5f)
                 continue;
 
-            for (unsigned int i = nInterpSamples; i < nSamples; ++i)
-                ppOut[iCh][i + nOffset] += pIn[i] * gain;
+            simd::MultiplyAccumulate(pIn + nInterpSamples, targetGain, ppOut[iCh] + nOffset + nInterpSamples, nSamples - nInterpSamples);
         }
     }
 
@@ -144,10 +141,19 @@ namespace spaudio {
     void GainInterp<T>::Reset()
     {
         m_iInterpCount = m_interpDurInSamples;
-        m_currentGainVec = m_targetGainVec;
+        for (size_t i = 0; i < m_targetGainVec.size(); ++i)
+            m_startGainVec[i] = static_cast<float>(m_targetGainVec[i]);
         m_isFirstCall = true;
     }
 
+    template<typename T>
+    float GainInterp<T>::GetCurrentGain(unsigned int iCh) const
+    {
+        if (m_iInterpCount >= m_interpDurInSamples)
+            return static_cast<float>(m_targetGainVec[iCh]);
+        return m_startGainVec[iCh] + m_deltaGainVec[iCh] * static_cast<float>(m_iInterpCount);
+    }
+
     template class GainInterp<float>;
     template class GainInterp<double>;
 
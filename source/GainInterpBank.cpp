@@ -0,0 +1,156 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  Apply interpolated gain vectors to many mono inputs and mix them        #*/
+/*#                                                                          #*/
+/*#  Filename:      GainInterpBank.cpp                                       #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#include "GainInterpBank.h"
+#include "dsp/SimdKernels.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+namespace spaudio {
+
+    // The number of samples of each output channel accumulated at once
+    static const unsigned int kMixBlockSize = 128;
+    // Gains below this are not applied once the interpolation is complete
+    static const float kMinGain = 1e-5f;
+
+    GainInterpBank::GainInterpBank()
+    {
+    }
+
+    GainInterpBank::~GainInterpBank()
+    {
+    }
+
+    void GainInterpBank::Configure(unsigned int nSources, unsigned int nCh)
+    {
+        m_nSources = nSources;
+        m_nCh = nCh;
+        m_currentGains.assign((size_t)nSources * nCh, 0.f);
+        m_targetGains.assign((size_t)nSources * nCh, 0.f);
+        m_deltaGains.assign((size_t)nSources * nCh, 0.f);
+        m_interpRemaining.assign(nSources, 0);
+        m_isFirstCall.assign(nSources, 1);
+    }
+
+    void GainInterpBank::SetGainVector(unsigned int iSource, const std::vector<double>& newGainVec, unsigned int interpTimeInSamples)
+    {
+        assert(iSource < m_nSources);
+        assert(newGainVec.size() == m_nCh); //Number of channels must match!
+
+        float* pCurrent = &m_currentGains[(size_t)iSource * m_nCh];
+        float* pTarget = &m_targetGains[(size_t)iSource * m_nCh];
+        float* pDelta = &m_deltaGains[(size_t)iSource * m_nCh];
+
+        bool isNewTarget = false;
+        for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
+            isNewTarget |= pTarget[iCh] != static_cast<float>(newGainVec[iCh]);
+        if (!isNewTarget)
+            return;
+
+        for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
+        {
+            pTarget[iCh] = static_cast<float>(newGainVec[iCh]);
+            if (interpTimeInSamples > 0)
+                pDelta[iCh] = (pTarget[iCh] - pCurrent[iCh]) / static_cast<float>(interpTimeInSamples);
+            else
+            {
+                // If smoothing time is zero samples then jump straight to the target
+                pCurrent[iCh] = pTarget[iCh];
+                pDelta[iCh] = 0.f;
+            }
+        }
+        m_interpRemaining[iSource] = interpTimeInSamples;
+    }
+
+    void GainInterpBank::ProcessAccumul(const unsigned int* pSourceInds, const float* const* ppIn, unsigned int nSources, float** ppOut, unsigned int nSamples, unsigned int nOffset)
+    {
+        for (unsigned int i = 0; i < nSources; ++i)
+        {
+            unsigned int iSource = pSourceInds[i];
+            assert(iSource < m_nSources);
+            if (m_isFirstCall[iSource])
+            {
+                std::copy(&m_targetGains[(size_t)iSource * m_nCh], &m_targetGains[(size_t)(iSource + 1) * m_nCh], &m_currentGains[(size_t)iSource * m_nCh]);
+                m_interpRemaining[iSource] = 0;
+                m_isFirstCall[iSource] = 0;
+            }
+        }
+
+        // Accumulate all of the sources for a block of an output channel before adding it to the output
+        // so the output is only read and written once
+        alignas(16) float accum[kMixBlockSize];
+        for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
+        {
+            for (unsigned int iBlockStart = 0; iBlockStart < nSamples; iBlockStart += kMixBlockSize)
+            {
+                unsigned int nBlock = std::min(kMixBlockSize, nSamples - iBlockStart);
+                bool isSilent = true;
+                std::fill(accum, accum + nBlock, 0.f);
+
+                for (unsigned int i = 0; i < nSources; ++i)
+                {
+                    unsigned int iSource = pSourceInds[i];
+                    size_t iGain = (size_t)iSource * m_nCh + iCh;
+                    const float* pIn = ppIn[i] + iBlockStart;
+
+                    // Samples in this block that are still being interpolated
+                    unsigned int nInterp = std::min(nSamples, m_interpRemaining[iSource]);
+                    unsigned int nRamp = nInterp > iBlockStart ? std::min(nBlock, nInterp - iBlockStart) : 0;
+                    if (nRamp > 0 && (m_deltaGains[iGain] != 0.f || std::abs(m_currentGains[iGain]) >= kMinGain))
+                    {
+                        float gainStart = m_currentGains[iGain] + m_deltaGains[iGain] * (float)iBlockStart;
+                        simd::MultiplyAccumulateRamp(pIn, gainStart, m_deltaGains[iGain], accum, nRamp);
+                        isSilent = false;
+                    }
+
+                    float target = m_targetGains[iGain];
+                    if (nRamp < nBlock && std::abs(target) >= kMinGain)
+                    {
+                        simd::MultiplyAccumulate(pIn + nRamp, target, accum + nRamp, nBlock - nRamp);
+                        isSilent = false;
+                    }
+                }
+
+                if (!isSilent)
+                    simd::MultiplyAccumulate(accum, 1.f, ppOut[iCh] + nOffset + iBlockStart, nBlock);
+            }
+        }
+
+        // Move the interpolation on by the number of samples processed
+        for (unsigned int i = 0; i < nSources; ++i)
+        {
+            unsigned int iSource = pSourceInds[i];
+            unsigned int nInterp = std::min(nSamples, m_interpRemaining[iSource]);
+            if (nInterp == 0)
+                continue;
+            m_interpRemaining[iSource] -= nInterp;
+            for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
+            {
+                size_t iGain = (size_t)iSource * m_nCh + iCh;
+                if (m_interpRemaining[iSource] == 0)
+                    m_currentGains[iGain] = m_targetGains[iGain];
+                else
+                    m_currentGains[iGain] += m_deltaGains[iGain] * (float)nInterp;
+            }
+        }
+    }
+
+    void GainInterpBank::Reset()
+    {
+        m_currentGains = m_targetGains;
+        std::fill(m_interpRemaining.begin(), m_interpRemaining.end(), 0);
+        std::fill(m_isFirstCall.begin(), m_isFirstCall.end(), 1);
+    }
+
+} // namespace spaudio
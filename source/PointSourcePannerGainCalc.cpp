@@ -16,6 +16,7 @@
 
 #include "LoudspeakerLayoutHulls.h"
 
+#include<algorithm>
 #include<cmath>
 #include<string>
 #include <map>
@@ -163,6 +164,7 @@ namespace spaudio {
         }
         // Loop through all facets to find those that contain a virtual speaker. If they do, add their
         // indices to a list and then create a virtualNgon for the corresponding set
+        std::vector<std::vector<std::vector<CartesianPosition<double>>>> ngonVertices;
         for (size_t iVirt = 0; iVirt < virtualSpkInd.size(); ++iVirt)
         {
             std::set<unsigned int> virtualNgonVertInds;
@@ -189,8 +191,35 @@ namespace spaudio {
                 ngonPositions.push_back(positions[ngonInds[i]]);
             }
             m_regions.virtualNgons.push_back(VirtualNgon(ngonInds, ngonPositions, positions[virtualSpkInd[iVirt]]));
+
+            // The Ngon is covered by the triplets made of each adjacent pair of vertices and the centre
+            std::vector<unsigned int> vertOrder = getNgonVectexOrder(ngonPositions, positions[virtualSpkInd[iVirt]]);
+            std::vector<std::vector<CartesianPosition<double>>> ngonTriplets;
+            for (size_t i = 0; i < vertOrder.size(); ++i)
+                ngonTriplets.push_back({ PolarToCartesian(ngonPositions[vertOrder[i]]),
+                    PolarToCartesian(ngonPositions[vertOrder[(i + 1) % vertOrder.size()]]),
+                    PolarToCartesian(positions[virtualSpkInd[iVirt]]) });
+            ngonVertices.push_back(ngonTriplets);
         }
 
+        // The vertices of every region in the order they are checked
+        std::vector<std::vector<std::vector<CartesianPosition<double>>>> regionVertices = ngonVertices;
+        for (auto& triplet : m_regions.triplets)
+        {
+            std::vector<CartesianPosition<double>> vertices;
+            for (auto& position : triplet.m_polarPositions)
+                vertices.push_back(PolarToCartesian(position));
+            regionVertices.push_back({ vertices });
+        }
+        for (auto& quad : m_regions.quadRegions)
+        {
+            std::vector<CartesianPosition<double>> vertices;
+            for (auto& position : quad.m_polarPositions)
+                vertices.push_back(PolarToCartesian(position));
+            regionVertices.push_back({ vertices });
+        }
+        BuildRegionLookup(regionVertices);
+
         for (size_t iNgon = 0; iNgon < m_regions.virtualNgons.size(); ++iNgon)
         {
             auto nVerts = m_regions.virtualNgons[iNgon].m_polarPositions.size();
@@ -216,34 +245,86 @@ namespace spaudio {
         {
             assert(gains.size() == 2);
             CalculateGainsFromRegions(position, m_gainsTmp);
+            DownmixGains(m_gainsTmp.data(), gains.data());
+        }
+        else if (m_downmixOutput == DownmixOutput::Downmix_2_3_0)
+        {
+            assert(gains.size() == 5);
+            CalculateGainsFromRegions(position, m_gainsTmp);
+            DownmixGains(m_gainsTmp.data(), gains.data());
+        }
+        else
+        {
+            CalculateGainsFromRegions(position, gains);
+        }
+    }
+
+    void PointSourcePannerGainCalc::CalculateGains(const CartesianPosition<double>* directions, size_t nDirections, double* gains) const
+    {
+        CalculateGainsBatch(directions, nDirections, gains);
+    }
+
+    void PointSourcePannerGainCalc::CalculateGains(const CartesianPosition<double>* directions, size_t nDirections, float* gains) const
+    {
+        CalculateGainsBatch(directions, nDirections, gains);
+    }
+
+    template<typename T>
+    void PointSourcePannerGainCalc::CalculateGainsBatch(const CartesianPosition<double>* directions, size_t nDirections, T* gains) const
+    {
+        const unsigned int nInternal = (unsigned int)m_internalLayout.getNumChannels();
+        const unsigned int nOut = (unsigned int)m_outputLayout.getNumChannels();
 
+        std::vector<double> internalGains(std::min<size_t>(kBatchSize, nDirections) * nInternal, 0.);
+        std::vector<double> outGains(nOut, 0.);
+        for (size_t iStart = 0; iStart < nDirections; iStart += kBatchSize)
+        {
+            unsigned int nBatch = (unsigned int)std::min<size_t>(kBatchSize, nDirections - iStart);
+            CalculateGainsFromRegions(directions + iStart, nBatch, internalGains.data());
+
+            for (unsigned int i = 0; i < nBatch; ++i)
+            {
+                const double* dirGains = &internalGains[i * nInternal];
+                if (m_downmixOutput != DownmixOutput::None)
+                {
+                    DownmixGains(dirGains, outGains.data());
+                    dirGains = outGains.data();
+                }
+                T* pOut = gains + (iStart + i) * nOut;
+                for (unsigned int iCh = 0; iCh < nOut; ++iCh)
+                    pOut[iCh] = (T)dirGains[iCh];
+            }
+        }
+    }
+
+    void PointSourcePannerGainCalc::DownmixGains(const double* internalGains, double* gains) const
+    {
+        if (m_downmixOutput == DownmixOutput::Downmix_0_2_0)
+        {
             gains[0] = 0.;
             gains[1] = 0.;
             // See Rec. ITU-R BS.2127-0 6.1.2.4 (page 2.5) for downmix method
             double stereoDownmix[2][5] = { {1.,0.,1. / sqrt(3.),1. / sqrt(2.),0.}, {0.,1.,1. / sqrt(3.),0.,1. / sqrt(2.)} };
             for (int i = 0; i < 2; ++i)
                 for (int j = 0; j < 5; ++j)
-                    gains[i] += stereoDownmix[i][j] * m_gainsTmp[j];
-            double a_front;
+                    gains[i] += stereoDownmix[i][j] * internalGains[j];
+            double a_front = 0.;
             int i = 0;
             for (i = 0; i < 3; ++i)
-                a_front = std::max(a_front, m_gainsTmp[i]);
-            double a_rear;
+                a_front = std::max(a_front, internalGains[i]);
+            double a_rear = 0.;
             for (i = 3; i < 5; ++i)
-                a_rear = std::max(a_rear, m_gainsTmp[i]);
+                a_rear = std::max(a_rear, internalGains[i]);
             double r = a_rear / (a_front + a_rear);
-            double gainNormalisation = std::pow(0.5, r / 2.) / norm(gains);
+            double gainNormalisation = std::pow(0.5, r / 2.) / norm(gains, 2);
 
             gains[0] *= gainNormalisation;
             gains[1] *= gainNormalisation;
         }
         else if (m_downmixOutput == DownmixOutput::Downmix_2_3_0)
         {
-            assert(gains.size() == 5);
-            CalculateGainsFromRegions(position, m_gainsTmp);
-
-            for (auto& g : gains)
-                g = 0.;
+            for (int i = 0; i < 5; ++i)
+                gains[i] = 0.;
 
             // See IAMF v1.0.0 sec. 7.6.2 for downmix matrix
             double p = std::sqrt(0.5);
@@ -264,14 +345,10 @@ namespace spaudio {
             for (int i = 0; i < 5; ++i)
                 for (int j = 0; j < 11; ++j)
                     if (downmixMatrix[i][j] != 0.)
-                        gains[i] += downmixMatrix[i][j] * m_gainsTmp[j];
+                        gains[i] += downmixMatrix[i][j] * internalGains[j];
 
-            for (auto& g : gains)
-                g *= gainNormalisation;
-        }
-        else
-        {
-            CalculateGainsFromRegions(position, gains);
+            for (int i = 0; i < 5; ++i)
+                gains[i] *= gainNormalisation;
         }
     }
 
@@ -282,8 +359,6 @@ namespace spaudio {
 
     void PointSourcePannerGainCalc::CalculateGainsFromRegions(CartesianPosition<double> position, std::vector<double>& gains)
     {
-        double tol = 1e-6;
-
         assert(gains.capacity() >= m_internalLayout.getNumChannels()); // Gains vector length must match the number of channels
         gains.resize(m_internalLayout.getNumChannels());
         for (auto& g : gains)
@@ -295,52 +370,250 @@ namespace spaudio {
         m_directionUnitVec[1] = position.y / vecNorm;
         m_directionUnitVec[2] = position.z / vecNorm;
 
-        for (double& g : m_nGonGains)
-            g = 0.;
-        for (double& g : m_tripletGains)
-            g = 0.;
-        for (double& g : m_quadGains)
-            g = 0.;
+        // Only the regions that can contain the direction are checked, in the same order as they would be if checking
+        // all of them, until one is found that is not zero gain
+        unsigned int iBin = GetCubeMapBin(m_directionUnitVec);
+        for (unsigned int i = m_binRegionStart[iBin]; i < m_binRegionStart[iBin + 1]; ++i)
+            if (CalculateRegionGains(m_binRegions[i], gains))
+                return;
+    }
 
-        // Loop through all of the regions until one is found that is not zero gain
-        for (size_t iNgon = 0; iNgon < m_regions.virtualNgons.size(); ++iNgon)
+    bool PointSourcePannerGainCalc::CalculateRegionGains(unsigned int iRegion, std::vector<double>& gains)
+    {
+        double tol = 1e-6;
+
+        const unsigned int nNgons = (unsigned int)m_regions.virtualNgons.size();
+        const unsigned int nTriplets = (unsigned int)m_regions.triplets.size();
+
+        RegionHandler* pRegion = nullptr;
+        std::vector<double>* pRegionGains = nullptr;
+        if (iRegion < nNgons)
         {
-            m_regions.virtualNgons[iNgon].CalculateGains(m_directionUnitVec, m_nGonGains);
-            if (norm(m_nGonGains) > tol) // if the gains are not zero then map them to the output gains
-            {
-                std::vector<unsigned int>& nGonInds = m_regions.virtualNgons[iNgon].m_channelInds;
-                for (size_t iGain = 0; iGain < m_nGonGains.size(); ++iGain)
-                    gains[m_downmixMapping[nGonInds[iGain]]] += m_nGonGains[iGain];
+            m_regions.virtualNgons[iRegion].CalculateGains(m_directionUnitVec, m_nGonGains);
+            pRegion = &m_regions.virtualNgons[iRegion];
+            pRegionGains = &m_nGonGains;
+        }
+        else if (iRegion < nNgons + nTriplets)
+        {
+            m_regions.triplets[iRegion - nNgons].CalculateGains(m_directionUnitVec, m_tripletGains);
+            pRegion = &m_regions.triplets[iRegion - nNgons];
+            pRegionGains = &m_tripletGains;
+        }
+        else
+        {
+            m_regions.quadRegions[iRegion - nNgons - nTriplets].CalculateGains(m_directionUnitVec, m_quadGains);
+            pRegion = &m_regions.quadRegions[iRegion - nNgons - nTriplets];
+            pRegionGains = &m_quadGains;
+        }
 
-                return;
-            }
+        if (norm(*pRegionGains) <= tol)
+            return false;
+
+        // The gains are not zero so map them to the output gains
+        for (size_t iGain = 0; iGain < pRegionGains->size(); ++iGain)
+            gains[m_downmixMapping[pRegion->m_channelInds[iGain]]] += (*pRegionGains)[iGain];
+        return true;
+    }
+
+    void PointSourcePannerGainCalc::CalculateGainsFromRegions(const CartesianPosition<double>* directions, unsigned int nDirections, double* gains) const
+    {
+        const double tol = 1e-6;
+        const unsigned int nInternal = (unsigned int)m_internalLayout.getNumChannels();
+        const unsigned int nNgons = (unsigned int)m_regions.virtualNgons.size();
+        const unsigned int nTriplets = (unsigned int)m_regions.triplets.size();
+        const unsigned int nBins = (unsigned int)m_binRegionStart.size() - 1;
+
+        std::fill(gains, gains + (size_t)nDirections * nInternal, 0.);
+
+        // The unit vectors of the directions and the cube map bin of each one
+        std::vector<double> unitVecs(3 * (size_t)nDirections);
+        std::vector<unsigned int> dirBin(nDirections);
+        std::vector<double> unitVec(3, 0.);
+        std::vector<unsigned int> binStart(nBins + 1, 0);
+        for (unsigned int i = 0; i < nDirections; ++i)
+        {
+            double vecNorm = norm(directions[i]);
+            unitVec[0] = unitVecs[3 * i] = directions[i].x / vecNorm;
+            unitVec[1] = unitVecs[3 * i + 1] = directions[i].y / vecNorm;
+            unitVec[2] = unitVecs[3 * i + 2] = directions[i].z / vecNorm;
+            dirBin[i] = GetCubeMapBin(unitVec);
+            binStart[dirBin[i] + 1]++;
         }
-        // Loop through the triplets Ngons
-        for (size_t iTriplet = 0; iTriplet < m_regions.triplets.size(); ++iTriplet)
+        // Group the directions with the same candidate regions together
+        for (unsigned int iBin = 0; iBin < nBins; ++iBin)
+            binStart[iBin + 1] += binStart[iBin];
+        std::vector<unsigned int> sortedDirs(nDirections);
         {
-            m_regions.triplets[iTriplet].CalculateGains(m_directionUnitVec, m_tripletGains);
-            if (norm(m_tripletGains) > tol) // if the gains are not zero then map them to the output gains
-            {
-                std::vector<unsigned int>& tripletInds = m_regions.triplets[iTriplet].m_channelInds;
-                for (size_t iGain = 0; iGain < m_tripletGains.size(); ++iGain)
-                    gains[m_downmixMapping[tripletInds[iGain]]] += m_tripletGains[iGain];
+            std::vector<unsigned int> binPos(binStart.begin(), binStart.end() - 1);
+            for (unsigned int i = 0; i < nDirections; ++i)
+                sortedDirs[binPos[dirBin[i]]++] = i;
+        }
 
-                return;
+        // Directions of the group that have not been found in a region yet and their components
+        std::vector<unsigned int> pending(nDirections);
+        std::vector<double> pendingVecs(3 * (size_t)nDirections);
+        std::vector<double> tripletGains(3 * (size_t)nDirections);
+        std::vector<double> regionGains(nInternal, 0.);
+
+        // Adds the gains of a region to the output for a direction if they are not zero
+        auto addRegionGains = [&](const RegionHandler& region, const double* rGains, unsigned int iDir) {
+            if (norm(rGains, (int)region.m_channelInds.size()) <= tol)
+                return false;
+            for (size_t iGain = 0; iGain < region.m_channelInds.size(); ++iGain)
+                gains[(size_t)iDir * nInternal + m_downmixMapping[region.m_channelInds[iGain]]] += rGains[iGain];
+            return true;
+        };
+
+        for (unsigned int iBin = 0; iBin < nBins; ++iBin)
+        {
+            unsigned int nPending = binStart[iBin + 1] - binStart[iBin];
+            std::copy(sortedDirs.begin() + binStart[iBin], sortedDirs.begin() + binStart[iBin + 1], pending.begin());
+
+            // Check the candidate regions in order, removing the directions from the group as they are found
+            for (unsigned int iCand = m_binRegionStart[iBin]; iCand < m_binRegionStart[iBin + 1] && nPending > 0; ++iCand)
+            {
+                unsigned int iRegion = m_binRegions[iCand];
+                unsigned int nRemaining = 0;
+                if (iRegion >= nNgons && iRegion < nNgons + nTriplets)
+                {
+                    // Triplet gains are calculated for all of the directions at once
+                    const Triplet& triplet = m_regions.triplets[iRegion - nNgons];
+                    const double* pPendingVecs[3] = { &pendingVecs[0], &pendingVecs[nPending], &pendingVecs[2 * nPending] };
+                    double* pTripletGains[3] = { &tripletGains[0], &tripletGains[nPending], &tripletGains[2 * nPending] };
+                    for (unsigned int k = 0; k < nPending; ++k)
+                        for (int iAxis = 0; iAxis < 3; ++iAxis)
+                            pendingVecs[iAxis * nPending + k] = unitVecs[3 * pending[k] + iAxis];
+                    triplet.CalculateGains(pPendingVecs, nPending, pTripletGains);
+                    for (unsigned int k = 0; k < nPending; ++k)
+                    {
+                        double g[3] = { pTripletGains[0][k], pTripletGains[1][k], pTripletGains[2][k] };
+                        if (!addRegionGains(triplet, g, pending[k]))
+                            pending[nRemaining++] = pending[k];
+                    }
+                }
+                else
+                {
+                    for (unsigned int k = 0; k < nPending; ++k)
+                    {
+                        const RegionHandler* pRegion = nullptr;
+                        if (iRegion < nNgons)
+                        {
+                            m_regions.virtualNgons[iRegion].CalculateGains(&unitVecs[3 * pending[k]], regionGains.data());
+                            pRegion = &m_regions.virtualNgons[iRegion];
+                        }
+                        else
+                        {
+                            m_regions.quadRegions[iRegion - nNgons - nTriplets].CalculateGains(&unitVecs[3 * pending[k]], regionGains.data());
+                            pRegion = &m_regions.quadRegions[iRegion - nNgons - nTriplets];
+                        }
+                        if (!addRegionGains(*pRegion, regionGains.data(), pending[k]))
+                            pending[nRemaining++] = pending[k];
+                    }
+                }
+                nPending = nRemaining;
             }
         }
-        // Loop through the triplets Ngons
-        for (size_t iQuad = 0; iQuad < m_regions.quadRegions.size(); ++iQuad)
+    }
+
+    void PointSourcePannerGainCalc::BuildRegionLookup(const std::vector<std::vector<std::vector<CartesianPosition<double>>>>& regionVertices)
+    {
+        // Allow for the tolerance used by the regions when checking if a direction is inside them
+        const double margin = 1e-3;
+
+        auto normalise = [](CartesianPosition<double> v) {
+            double vecNorm = norm(v);
+            return CartesianPosition<double>{ v.x / vecNorm, v.y / vecNorm, v.z / vecNorm };
+        };
+        auto angleBetween = [](const CartesianPosition<double>& a, const CartesianPosition<double>& b) {
+            return std::acos(std::max(-1., std::min(1., a.x * b.x + a.y * b.y + a.z * b.z)));
+        };
+
+        // The spherical cap bounding each part of each region. A radius of 0 or more than 90 degrees means the cap
+        // cannot be bounded so the region is added to every bin
+        struct Cap
         {
-            m_regions.quadRegions[iQuad].CalculateGains(m_directionUnitVec, m_quadGains);
-            if (norm(m_quadGains) > tol) // if the gains are not zero then map them to the output gains
+            CartesianPosition<double> centre;
+            double radius;
+        };
+        std::vector<std::vector<Cap>> regionCaps(regionVertices.size());
+        for (size_t iRegion = 0; iRegion < regionVertices.size(); ++iRegion)
+        {
+            for (auto& vertices : regionVertices[iRegion])
             {
-                std::vector<unsigned int>& quadInds = m_regions.quadRegions[iQuad].m_channelInds;
-                for (unsigned int iGain = 0; iGain < m_quadGains.size(); ++iGain)
-                    gains[m_downmixMapping[quadInds[iGain]]] += m_quadGains[iGain];
-
-                return;
+                CartesianPosition<double> sum{ 0., 0., 0. };
+                for (auto& v : vertices)
+                {
+                    sum.x += v.x;
+                    sum.y += v.y;
+                    sum.z += v.z;
+                }
+                Cap cap{ sum, 0. };
+                if (norm(sum) > 1e-3)
+                {
+                    cap.centre = normalise(sum);
+                    for (auto& v : vertices)
+                        cap.radius = std::max(cap.radius, angleBetween(cap.centre, normalise(v)));
+                }
+                regionCaps[iRegion].push_back(cap);
             }
         }
+
+        // Each face of the cube is split into bins and each bin is bounded by the cap of its corners
+        const unsigned int N = kNumCubeMapBins;
+        m_binRegionStart.assign(1, 0);
+        m_binRegions.clear();
+        for (unsigned int iFace = 0; iFace < 6; ++iFace)
+        {
+            unsigned int iAxis = iFace / 2;
+            double sign = iFace % 2 == 0 ? 1. : -1.;
+            auto facePoint = [&](double u, double v) {
+                double p[3];
+                p[iAxis] = sign;
+                p[(iAxis + 1) % 3] = u;
+                p[(iAxis + 2) % 3] = v;
+                return normalise(CartesianPosition<double>{ p[0], p[1], p[2] });
+            };
+            for (unsigned int iU = 0; iU < N; ++iU)
+                for (unsigned int iV = 0; iV < N; ++iV)
+                {
+                    double u0 = -1. + 2. * iU / N, u1 = -1. + 2. * (iU + 1) / N;
+                    double v0 = -1. + 2. * iV / N, v1 = -1. + 2. * (iV + 1) / N;
+                    CartesianPosition<double> binCentre = facePoint(0.5 * (u0 + u1), 0.5 * (v0 + v1));
+                    double binRadius = std::max(std::max(angleBetween(binCentre, facePoint(u0, v0)), angleBetween(binCentre, facePoint(u1, v0))),
+                        std::max(angleBetween(binCentre, facePoint(u0, v1)), angleBetween(binCentre, facePoint(u1, v1))));
+
+                    for (unsigned int iRegion = 0; iRegion < (unsigned int)regionCaps.size(); ++iRegion)
+                    {
+                        bool canOverlap = false;
+                        for (auto& cap : regionCaps[iRegion])
+                            canOverlap |= cap.radius <= 0. || cap.radius >= 0.5 * M_PI
+                                || angleBetween(binCentre, cap.centre) <= binRadius + cap.radius + margin;
+                        if (canOverlap)
+                            m_binRegions.push_back(iRegion);
+                    }
+                    m_binRegionStart.push_back((unsigned int)m_binRegions.size());
+                }
+        }
+    }
+
+    unsigned int PointSourcePannerGainCalc::GetCubeMapBin(const std::vector<double>& directionUnitVec)
+    {
+        // The face is that of the axis with the largest component
+        unsigned int iAxis = 0;
+        for (unsigned int i = 1; i < 3; ++i)
+            if (std::abs(directionUnitVec[i]) > std::abs(directionUnitVec[iAxis]))
+                iAxis = i;
+        double axisValue = directionUnitVec[iAxis];
+        unsigned int iFace = 2 * iAxis + (axisValue < 0. ? 1 : 0);
+
+        // Project onto the face and find the bin
+        const unsigned int N = kNumCubeMapBins;
+        double scale = 1. / std::abs(axisValue);
+        double u = directionUnitVec[(iAxis + 1) % 3] * scale;
+        double v = directionUnitVec[(iAxis + 2) % 3] * scale;
+        unsigned int iU = std::min(N - 1, (unsigned int)std::max(0., std::floor(0.5 * (u + 1.) * N)));
+        unsigned int iV = std::min(N - 1, (unsigned int)std::max(0., std::floor(0.5 * (v + 1.) * N)));
+        return (iFace * N + iU) * N + iV;
     }
 
     std::vector<Channel> PointSourcePannerGainCalc::CalculateExtraSpeakersLayout(const Layout& layout)
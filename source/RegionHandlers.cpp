@@ -38,8 +38,13 @@ namespace spaudio {
     {
         assert(gains.capacity() >= 3);
         gains.resize(3, 0.);
-        for (auto& g : gains)
-            g = 0.;
+        CalculateGains(directionUnitVec.data(), gains.data());
+    }
+
+    void Triplet::CalculateGains(const double* directionUnitVec, double* gains) const
+    {
+        for (int i = 0; i < 3; ++i)
+            gains[i] = 0.;
 
         for (int i = 0; i < 3; ++i)
             for (int j = 0; j < 3; ++j)
@@ -55,12 +60,38 @@ namespace spaudio {
             }
 
         // Normalise
-        double vecNorm = norm(gains);
+        double vecNorm = norm(gains, 3);
 
         for (int i = 0; i < 3; ++i)
             gains[i] /= vecNorm;
     }
 
+    void Triplet::CalculateGains(const double* const* directionUnitVecs, unsigned int nDirections, double* const* gains) const
+    {
+        const double* x = directionUnitVecs[0];
+        const double* y = directionUnitVecs[1];
+        const double* z = directionUnitVecs[2];
+        double* g0 = gains[0];
+        double* g1 = gains[1];
+        double* g2 = gains[2];
+        const double m00 = m_inverseDirections[0][0], m01 = m_inverseDirections[0][1], m02 = m_inverseDirections[0][2];
+        const double m10 = m_inverseDirections[1][0], m11 = m_inverseDirections[1][1], m12 = m_inverseDirections[1][2];
+        const double m20 = m_inverseDirections[2][0], m21 = m_inverseDirections[2][1], m22 = m_inverseDirections[2][2];
+
+        // The same operations as for a single direction, written without branches so that they can be vectorised
+        for (unsigned int i = 0; i < nDirections; ++i)
+        {
+            double a = ((0. + x[i] * m00) + y[i] * m10) + z[i] * m20;
+            double b = ((0. + x[i] * m01) + y[i] * m11) + z[i] * m21;
+            double c = ((0. + x[i] * m02) + y[i] * m12) + z[i] * m22;
+            bool inside = a >= -m_tol && b >= -m_tol && c >= -m_tol;
+            double vecNorm = std::sqrt(((0. + a * a) + b * b) + c * c);
+            g0[i] = inside ? a / vecNorm : 0.;
+            g1[i] = inside ? b / vecNorm : 0.;
+            g2[i] = inside ? c / vecNorm : 0.;
+        }
+    }
+
     //=======================================================================================
     VirtualNgon::VirtualNgon(std::vector<unsigned int> chanInds, std::vector<PolarPosition<double>> polPos, PolarPosition<double> centrePosition)
         : RegionHandler(chanInds, polPos)
@@ -84,27 +115,32 @@ namespace spaudio {
             tripletPositions[2] = centrePosition;
             m_triplets.push_back(Triplet(channelIndSubset, tripletPositions));
         }
-        m_tripletGains.resize(3, 0.);
     }
 
     void VirtualNgon::CalculateGains(const std::vector<double>& directionUnitVec, std::vector<double>& gains)
     {
         assert(gains.capacity() >= m_nCh);
         gains.resize(m_nCh, 0.);
-        for (auto& g : gains)
-            g = 0.;
+        CalculateGains(directionUnitVec.data(), gains.data());
+    }
+
+    void VirtualNgon::CalculateGains(const double* directionUnitVec, double* gains) const
+    {
+        for (unsigned int i = 0; i < m_nCh; ++i)
+            gains[i] = 0.;
 
         unsigned int nTriplets = (unsigned int)m_triplets.size();
+        double tripletGains[3] = { 0. };
 
         unsigned int iTriplet = 0;
         // All gains must be above this value for the triplet to be valid
         // Select a very small negative number to account for rounding errors
         for (iTriplet = 0; iTriplet < nTriplets; ++iTriplet)
         {
-            m_triplets[iTriplet].CalculateGains(directionUnitVec, m_tripletGains);
-            double gainSum = std::accumulate(m_tripletGains.begin(), m_tripletGains.end(), 0.);
+            m_triplets[iTriplet].CalculateGains(directionUnitVec, tripletGains);
+            double gainSum = std::accumulate(tripletGains, tripletGains + 3, 0.);
             // All gains must be positive (within tolerance) and the sum should be greater than 0
-            if (m_tripletGains[0] > -m_tol && m_tripletGains[1] > -m_tol && m_tripletGains[2] > -m_tol
+            if (tripletGains[0] > -m_tol && tripletGains[1] > -m_tol && tripletGains[2] > -m_tol
                 && gainSum > m_tol)
             {
                 break;
@@ -114,13 +150,13 @@ namespace spaudio {
         if (iTriplet == nTriplets)
             return;
 
-        std::vector<unsigned int>& tripletInds = m_triplets[iTriplet].m_channelInds;
+        const std::vector<unsigned int>& tripletInds = m_triplets[iTriplet].m_channelInds;
         for (int i = 0; i < 2; ++i)
-            gains[tripletInds[i]] += m_tripletGains[i];
+            gains[tripletInds[i]] += tripletGains[i];
         for (unsigned int i = 0; i < m_nCh; ++i)
-            gains[i] += m_downmixCoefficient * m_tripletGains[2];
+            gains[i] += m_downmixCoefficient * tripletGains[2];
 
-        double gainNorm = 1. / norm(gains);
+        double gainNorm = 1. / norm(gains, (int)m_nCh);
         for (unsigned int i = 0; i < m_nCh; ++i)
             gains[i] *= gainNorm;
     }
@@ -154,17 +190,17 @@ namespace spaudio {
         m_polynomialXProdX = CalculatePolyXProdTerms(m_quadVertices);
         // For the Y terms rotate the order in which the vertices are sent
         m_polynomialXProdY = CalculatePolyXProdTerms({ m_quadVertices[1],m_quadVertices[2],m_quadVertices[3],m_quadVertices[0] });
-
-        m_gainsTmp.resize(4);
-        m_gP.resize(3);
     }
 
-    double QuadRegion::GetPanningValue(const std::vector<double>& directionUnitVec, std::vector<std::vector<double>>& xprodTerms)
+    double QuadRegion::GetPanningValue(const double* directionUnitVec, const std::vector<std::vector<double>>& xprodTerms) const
     {
         // Take the dot product with the direction vector to get the polynomial terms
-        double a = dotProduct(xprodTerms[0], directionUnitVec);
-        double b = dotProduct(xprodTerms[1], directionUnitVec);
-        double c = dotProduct(xprodTerms[2], directionUnitVec);
+        auto dot = [directionUnitVec](const std::vector<double>& v) {
+            return v[0] * directionUnitVec[0] + v[1] * directionUnitVec[1] + v[2] * directionUnitVec[2];
+        };
+        double a = dot(xprodTerms[0]);
+        double b = dot(xprodTerms[1]);
+        double c = dot(xprodTerms[2]);
 
         double roots[2] = { -1. };
 
@@ -196,8 +232,15 @@ namespace spaudio {
     {
         assert(gains.capacity() >= 4);
         gains.resize(4, 0.);
-        for (auto& g : gains)
-            g = 0.;
+        CalculateGains(directionUnitVec.data(), gains.data());
+    }
+
+    void QuadRegion::CalculateGains(const double* directionUnitVec, double* gains) const
+    {
+        for (int i = 0; i < 4; ++i)
+            gains[i] = 0.;
+        double gainsTmp[4];
+        double gP[3];
 
         // Calculate the gains in anti-clockwise order
         double x = GetPanningValue(directionUnitVec, m_polynomialXProdX);
@@ -206,30 +249,30 @@ namespace spaudio {
         // Check that both of the panning values are between zero and one and that gP.d > 0
         if (x > 1. + m_tol || x < -m_tol || y > 1. + m_tol || y < -m_tol)
             return; // return zero gains
-        m_gainsTmp[0] = (1. - x) * (1. - y);
-        m_gainsTmp[1] = x * (1. - y);
-        m_gainsTmp[2] = x * y;
-        m_gainsTmp[3] = (1. - x) * y;
+        gainsTmp[0] = (1. - x) * (1. - y);
+        gainsTmp[1] = x * (1. - y);
+        gainsTmp[2] = x * y;
+        gainsTmp[3] = (1. - x) * y;
 
         for (int i = 0; i < 3; ++i)
-            m_gP[i] = 0.;
+            gP[i] = 0.;
         for (int i = 0; i < 4; ++i)
         {
-            m_gP[0] += m_gainsTmp[i] * m_quadVertices[i].x;
-            m_gP[1] += m_gainsTmp[i] * m_quadVertices[i].y;
-            m_gP[2] += m_gainsTmp[i] * m_quadVertices[i].z;
+            gP[0] += gainsTmp[i] * m_quadVertices[i].x;
+            gP[1] += gainsTmp[i] * m_quadVertices[i].y;
+            gP[2] += gainsTmp[i] * m_quadVertices[i].z;
         }
-        double dirCheck = dotProduct(m_gP, directionUnitVec);
+        double dirCheck = gP[0] * directionUnitVec[0] + gP[1] * directionUnitVec[1] + gP[2] * directionUnitVec[2];
         if (dirCheck < 0.)
             return; // Return zeros
 
-        double gainNorm = 1. / norm(m_gainsTmp);
+        double gainNorm = 1. / norm(gainsTmp, 4);
         for (int i = 0; i < 4; ++i)
-            m_gainsTmp[i] *= gainNorm;
+            gainsTmp[i] *= gainNorm;
 
         // Map the gains to the order the channels were input
         for (int i = 0; i < 4; ++i)
-            gains[m_vertOrder[i]] = m_gainsTmp[i];
+            gains[m_vertOrder[i]] = gainsTmp[i];
     }
 
     std::vector<std::vector<double>> QuadRegion::CalculatePolyXProdTerms(const std::vector<CartesianPosition<double>>& quadVertices)
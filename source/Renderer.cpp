@@ -13,11 +13,226 @@
 /*############################################################################*/
 
 #include "Renderer.h"
+#include "ConfigCache.h"
+#include "SpscQueue.h"
 #include<type_traits>
 #include<iostream>
+#include<condition_variable>
+#include<deque>
+#include<mutex>
+#include<thread>
+#include<chrono>
+#include<atomic>
+#include<limits>
 
 namespace spaudio {
 
+    /** A stream queued to be rendered by a worker. */
+    struct Renderer::Job
+    {
+        TypeDefinition type = TypeDefinition::Objects;
+        // Index of the Object, DirectSpeaker or HOA channel
+        int index = 0;
+        ObjectMetadata objectMetadata;
+        DirectSpeakerMetadata directSpeakerMetadata;
+        // HOA gains
+        double gain = 1.;
+        float normConversionGain = 1.f;
+        // Copy of the input audio
+        std::vector<float> audio;
+        unsigned int nSamples = 0;
+        unsigned int nOffset = 0;
+    };
+
+    /** A worker thread with its own mixing context and a queue of jobs. */
+    struct Renderer::Worker
+    {
+        MixContext context;
+        // The jobs are kept between frames so their buffers are reused. A deque is used so that adding a job
+        // does not move those the worker is processing
+        std::deque<Job> jobs;
+        // Number of jobs queued this frame
+        size_t nQueued = 0;
+        // Number of jobs rendered this frame
+        size_t nRendered = 0;
+        bool quit = false;
+        std::mutex mutex;
+        std::condition_variable jobQueued;
+        std::condition_variable jobRendered;
+        std::thread thread;
+    };
+
+    /** Object metadata queued for the background gain calculation. */
+    struct Renderer::ObjectGainRequest
+    {
+        int iObj = 0;
+        // The frame and offset at which the metadata was added
+        uint64_t frame = 0;
+        unsigned int nOffset = 0;
+        unsigned int interpLength = 0;
+        ObjectMetadata metadata;
+    };
+
+    /** The gains calculated for an ObjectGainRequest. */
+    struct Renderer::ObjectGainResult
+    {
+        int iObj = 0;
+        uint64_t frame = 0;
+        unsigned int nOffset = 0;
+        unsigned int interpLength = 0;
+        std::vector<double> directGains;
+        std::vector<double> diffuseGains;
+    };
+
+    /** A thread calculating Object gains. The metadata is passed to it and the gains are returned through
+     *  lock-free queues so that the thread adding the Objects never waits for it.
+     */
+    struct Renderer::AsyncGainCalc
+    {
+        AsyncGainCalc(const Layout& layout, unsigned int nObjects, unsigned int nCh, unsigned int latency, const adm::ObjectGainCacheSettings& cacheSettings,
+            const adm::ExtentGainCacheSettings& extentCacheSettings)
+            : gainCalc(layout),
+            // Allow for up to 4 metadata blocks per Object per frame before the gains are due
+            nMaxPending(4 * (latency + 1)),
+            nMaxResults(nObjects * nMaxPending),
+            requests(nObjects * nMaxPending),
+            results(nObjects * nMaxPending, ObjectGainResult{ 0, 0, 0, 0, std::vector<double>(nCh), std::vector<double>(nCh) }),
+            pending(nObjects * nMaxPending, ObjectGainResult{ 0, 0, 0, 0, std::vector<double>(nCh), std::vector<double>(nCh) }),
+            pendingStart(nObjects, 0),
+            pendingCount(nObjects, 0)
+        {
+            gainCalc.ConfigureCache(cacheSettings);
+            gainCalc.ConfigureExtentCache(extentCacheSettings);
+            thread = std::thread([this]() {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true)
+                {
+                    // Wait for a request, and for space in the results queue if the results have not been collected yet
+                    requestQueued.wait(lock, [this]() { return quit || (nCalculated < nRequested && nCalculated - nCollected < nMaxResults); });
+                    if (quit)
+                        return;
+
+                    // The counters guarantee that there is a request and space for its result
+                    lock.unlock();
+                    ObjectGainRequest* request = requests.Front();
+                    ObjectGainResult* result = results.BeginPush();
+                    gainCalc.CalculateGains(request->metadata, result->directGains, result->diffuseGains);
+                    result->iObj = request->iObj;
+                    result->frame = request->frame;
+                    result->nOffset = request->nOffset;
+                    result->interpLength = request->interpLength;
+                    results.EndPush();
+                    requests.Pop();
+                    lock.lock();
+                    nCalculated++;
+                    gainsCalculated.notify_all();
+                }
+                });
+        }
+
+        ~AsyncGainCalc()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            requestQueued.notify_one();
+            thread.join();
+        }
+
+        /** Wake the thread after a request has been pushed to the request queue. */
+        void NotifyRequest()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                nRequested++;
+            }
+            requestQueued.notify_one();
+        }
+
+        /** Move the results that have been calculated to the pending list of their Object. The gain vectors are
+         *  swapped so that no memory is allocated.
+         */
+        void CollectResults()
+        {
+            uint64_t nPopped = 0;
+            while (ObjectGainResult* result = results.Front())
+            {
+                unsigned int iResultObj = (unsigned int)result->iObj;
+                unsigned int& start = pendingStart[iResultObj];
+                unsigned int& count = pendingCount[iResultObj];
+                // If the list is full the oldest result is discarded. It would be replaced by the newer one anyway
+                if (count == nMaxPending)
+                {
+                    start = (start + 1) % nMaxPending;
+                    count--;
+                }
+                ObjectGainResult& slot = pending[iResultObj * nMaxPending + (start + count) % nMaxPending];
+                slot.iObj = result->iObj;
+                slot.frame = result->frame;
+                slot.nOffset = result->nOffset;
+                slot.interpLength = result->interpLength;
+                std::swap(slot.directGains, result->directGains);
+                std::swap(slot.diffuseGains, result->diffuseGains);
+                count++;
+                results.Pop();
+                nPopped++;
+            }
+
+            // Wake the thread in case it was waiting for space in the results queue
+            if (nPopped > 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    nCollected += nPopped;
+                }
+                requestQueued.notify_one();
+            }
+        }
+
+        /** Wait until the gains of all the requests pushed so far have been calculated. The results are collected
+         *  while waiting so that the thread does not stall on a full results queue.
+         */
+        void WaitForResults()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (nCalculated < nRequested)
+            {
+                gainsCalculated.wait(lock, [this]() { return nCalculated == nRequested || nCalculated - nCollected == nMaxResults; });
+                if (nCalculated < nRequested)
+                {
+                    lock.unlock();
+                    CollectResults();
+                    lock.lock();
+                }
+            }
+        }
+
+        adm::ObjectGainCalculator gainCalc;
+        // The maximum number of results held for each Object until they are due
+        const unsigned int nMaxPending;
+        // The capacity of the results queue
+        const uint64_t nMaxResults;
+        SpscQueue<ObjectGainRequest> requests;
+        SpscQueue<ObjectGainResult> results;
+        // Results that have been received but are not due yet, nMaxPending for each Object stored as a ring buffer
+        std::vector<ObjectGainResult> pending;
+        std::vector<unsigned int> pendingStart;
+        std::vector<unsigned int> pendingCount;
+        // The number of requests pushed, calculated and whose results have been collected, and the quit flag.
+        // They are only accessed with the mutex locked so that no notification can be missed
+        uint64_t nRequested = 0;
+        uint64_t nCalculated = 0;
+        uint64_t nCollected = 0;
+        bool quit = false;
+        std::mutex mutex;
+        // Notified when a request is pushed, results are collected or the thread must quit
+        std::condition_variable requestQueued;
+        // Notified when the gains of a request have been calculated
+        std::condition_variable gainsCalculated;
+        std::thread thread;
+    };
+
     Renderer::Renderer()
     {
         m_RenderLayout = OutputLayout::Stereo;
@@ -26,6 +241,7 @@ namespace spaudio {
 
     Renderer::~Renderer()
     {
+        StopWorkers();
         DeallocateBuffers(m_speakerOut, m_nChannelsToRender);
         DeallocateBuffers(m_speakerOutDirect, m_nChannelsToRender);
         DeallocateBuffers(m_speakerOutDiffuse, m_nChannelsToRender);
@@ -35,6 +251,9 @@ namespace spaudio {
 
     bool Renderer::Configure(OutputLayout outputTarget, unsigned int hoaOrder, unsigned int nSampleRate, unsigned int nSamples, const StreamInformation& channelInfo, std::string HRTFPath, bool useLfeBinaural, Optional<Screen> reproductionScreen, const std::vector<PolarPosition<double>>& layoutPositions)
     {
+        // The workers are restarted with the new configuration at the end
+        StopWorkers();
+
         // Set the output layout
         m_RenderLayout = outputTarget;
         // Set the order to be used for the HOA rendering
@@ -124,7 +343,6 @@ namespace spaudio {
         {
             Screen screen = reproductionScreen.value();
             m_outputLayout.setReproductionScreen(screen);
-            m_objMetaDataTmp.referenceScreen = screen;
         }
 
         // Clear the vectors containing the HOA and panning objects so that if the renderer is
@@ -151,8 +369,6 @@ namespace spaudio {
                 break;
             case TypeDefinition::Objects:
                 m_pannerTrackInd.push_back({ iCh,TypeDefinition::Objects });
-                m_gainInterpDirect.push_back(GainInterp<double>(m_nChannelsToRender));
-                m_gainInterpDiffuse.push_back(GainInterp<double>(m_nChannelsToRender));
                 m_objectMetadata.push_back(ObjectMetadata());
                 if (reproductionScreen.hasValue())
                     m_objectMetadata.back().referenceScreen = reproductionScreen.value();
@@ -168,6 +384,13 @@ namespace spaudio {
             }
         }
 
+        m_gainInterpDirect.Configure(iObj, m_nChannelsToRender);
+        m_gainInterpDiffuse.Configure(iObj, m_nChannelsToRender);
+        m_batchObjectInds.reserve(iObj);
+        m_batchObjectInputs.reserve(iObj);
+        m_isObjectInBatch.assign(iObj, 0);
+        m_objectHasGains.assign(iObj, 0);
+
         if (iHOA > 0 && iHOA != m_nAmbiChannels)
             return false; // Either the HOA stream in channelInfo is of an order that doesn't match hoaOrder or there is more than one HOA stream.
 
@@ -175,17 +398,35 @@ namespace spaudio {
         // Smooth over a single full frame of audio.
         m_gainInterpTime = nSamples;
 
-        // Set up the gain calculator
-        m_objectGainCalc = std::make_unique<adm::ObjectGainCalculator>(m_outputLayout);
-        //Set up the direct gain calculator if output is not binaural
-        m_directSpeakerGainCalc = std::make_unique<adm::DirectSpeakersGainCalc>(m_outputLayout);
+        m_frameIndex = 0;
+
+        // The read-only tables calculated for this configuration are shared with other renderers with the same
+        // configuration. They are loaded from the cache directory if they are not in use by another renderer
+        // The cache is kept so that workers started later by SetWorkerCount() share the same tables
+        m_configCache = std::make_unique<ConfigCache>();
+        m_configCachePath.clear();
+        if (AddConfigToCacheKey(*m_configCache, nSampleRate, HRTFPath))
+        {
+            if (!m_configCacheDirectory.empty())
+            {
+                m_configCache->Load(m_configCacheDirectory);
+                m_configCachePath = m_configCache->GetFilePath(m_configCacheDirectory);
+            }
+        }
+        else
+            m_configCache.reset();
+        ConfigCache* pConfigCache = m_configCache.get();
+
+        // Set up the gain calculators
+        ConfigureMixContext(m_mixContext, pConfigCache);
         // Set up the decorrelator
-        bool bDecorConfig = m_decorrelate.Configure(m_outputLayout, nSamples);
+        bool bDecorConfig = m_decorrelate.Configure(m_outputLayout, nSamples, pConfigCache);
         if (!bDecorConfig)
             return false;
 
         // AllRAD decoder for HOA signals
-        bool bHoaDecoderConfig = m_hoaDecoder.Configure(hoaOrder, nSamples, nSampleRate, m_outputLayout.getLayoutName(), m_outputLayout.hasLfe());
+        bool bHoaDecoderConfig = m_hoaDecoder.Configure(hoaOrder, nSamples, nSampleRate, m_outputLayout.getLayoutName(), m_outputLayout.hasLfe(),
+            false, pConfigCache);
         if (!bHoaDecoderConfig)
             return false;
 
@@ -205,7 +446,10 @@ namespace spaudio {
                 return false;
 
             unsigned int tailLength = 0;
-            bool bBinConf = m_hoaBinaural.Configure(hoaOrder, true, nSampleRate, nSamples, tailLength, HRTFPath);
+            // Use the low CPU mode and combine the shelf filters with the HRTFs so they are not applied separately
+            const bool lowCpuMode = true;
+            const bool combineShelfFilters = true;
+            bool bBinConf = m_hoaBinaural.Configure(hoaOrder, true, nSampleRate, nSamples, tailLength, HRTFPath, lowCpuMode, combineShelfFilters, pConfigCache);
             if (!bBinConf)
                 return false;
 
@@ -224,10 +468,9 @@ namespace spaudio {
         m_pZeros = std::make_unique<float[]>(nSamples);
         memset(m_pZeros.get(), 0, m_nSamples * sizeof(float));
 
-        // Allocate vectors used during gain calculations
-        m_directGains.resize(m_nChannelsToRender);
-        m_diffuseGains.resize(m_nChannelsToRender);
-        m_directSpeakerGains.resize(m_nChannelsToRender);
+        m_mixContext.speakerOut = m_speakerOut;
+        m_mixContext.speakerOutDirect = m_speakerOutDirect;
+        m_mixContext.speakerOutDiffuse = m_speakerOutDiffuse;
 
         // Set up the HOA gain interpolator
         m_hoaGainInterp.resize(m_nAmbiChannels, GainInterp<double>(1));
@@ -239,12 +482,27 @@ namespace spaudio {
         for (auto& outGainInterp : m_outGainInterp)
             outGainInterp.SetGainValue(1.0, 0);
 
-        return true;
+        bool bWorkersStarted = StartWorkers(pConfigCache);
+
+        // Store anything that was not found in the cache for next time. Failing to write it is not an error
+        if (!m_configCachePath.empty() && m_configCache->IsModified())
+            m_configCache->Save(m_configCacheDirectory);
+
+        return bWorkersStarted;
     }
 
 
     void Renderer::Reset()
     {
+        WaitForWorkers();
+        for (auto& worker : m_workers)
+            for (unsigned int iCh = 0; iCh < m_nChannelsToRender; ++iCh)
+            {
+                memset(worker->context.speakerOut[iCh], 0, m_nSamples * sizeof(float));
+                memset(worker->context.speakerOutDirect[iCh], 0, m_nSamples * sizeof(float));
+                memset(worker->context.speakerOutDiffuse[iCh], 0, m_nSamples * sizeof(float));
+            }
+
         m_decorrelate.Reset();
         m_hoaBinaural.Reset();
         m_hoaDecoder.Reset();
@@ -253,11 +511,11 @@ namespace spaudio {
         ClearObjectDiffuseBuffer();
         ClearHoaBuffer();
 
-        for (size_t i = 0; i < m_gainInterpDirect.size(); ++i)
-        {
-            m_gainInterpDiffuse[i].Reset();
-            m_gainInterpDirect[i].Reset();
-        }
+        // Gains that are still being calculated are applied immediately
+        for (auto pContext : GetMixContexts())
+            FlushObjectGains(*pContext);
+        m_gainInterpDirect.Reset();
+        m_gainInterpDiffuse.Reset();
 
         for (auto& dirSpkGainInterp : m_directSpeakerGainInterp)
             dirSpkGainInterp.Reset();
@@ -289,53 +547,385 @@ namespace spaudio {
 
     void Renderer::AddObject(float* pIn, unsigned int nSamples, const ObjectMetadata& metadata, unsigned int nOffset)
     {
-        // convert from cartesian to polar metadata (if required)
-        adm::toPolar(metadata, m_objMetaDataTmp);
+        int iObj = GetObjectIndex(metadata);
+        if (iObj == -1)
+            return;
+
+        if (m_workers.empty())
+        {
+            MixObject(m_mixContext, iObj, metadata, pIn, nSamples, nOffset);
+            return;
+        }
+
+        unsigned int iWorker = (unsigned int)iObj % (unsigned int)m_workers.size();
+        Job& job = GetNextJob(iWorker);
+        job.type = TypeDefinition::Objects;
+        job.index = iObj;
+        job.objectMetadata = metadata;
+        job.audio.assign(pIn, pIn + nSamples);
+        job.nSamples = nSamples;
+        job.nOffset = nOffset;
+        SubmitJob(iWorker);
+    }
+
+    void Renderer::AddObjects(float** ppIn, const ObjectMetadata* pMetadata, unsigned int nObjects, unsigned int nSamples, unsigned int nOffset)
+    {
+        // The workers already mix their Objects independently so queue them individually
+        if (!m_workers.empty())
+        {
+            for (unsigned int i = 0; i < nObjects; ++i)
+                AddObject(ppIn[i], nSamples, pMetadata[i], nOffset);
+            return;
+        }
+
+        m_batchObjectInds.clear();
+        m_batchObjectInputs.clear();
+        for (unsigned int i = 0; i < nObjects; ++i)
+        {
+            int iObj = GetObjectIndex(pMetadata[i]);
+            if (iObj == -1)
+                continue;
+
+            // If an Object appears more than once then its earlier blocks must be mixed before its gains are updated
+            if (m_isObjectInBatch[iObj])
+            {
+                MixObjectBatch(nSamples, nOffset);
+                m_batchObjectInds.clear();
+                m_batchObjectInputs.clear();
+            }
+
+            if (!UpdateObjectGains(m_mixContext, iObj, pMetadata[i], nOffset))
+                continue;
+            m_batchObjectInds.push_back((unsigned int)iObj);
+            m_batchObjectInputs.push_back(ppIn[i]);
+            m_isObjectInBatch[iObj] = 1;
+        }
+        MixObjectBatch(nSamples, nOffset);
+    }
+
+    void Renderer::MixObjectBatch(unsigned int nSamples, unsigned int nOffset)
+    {
+        unsigned int nBatch = (unsigned int)m_batchObjectInds.size();
+        m_gainInterpDirect.ProcessAccumul(m_batchObjectInds.data(), m_batchObjectInputs.data(), nBatch, m_speakerOutDirect, nSamples, nOffset);
+        m_gainInterpDiffuse.ProcessAccumul(m_batchObjectInds.data(), m_batchObjectInputs.data(), nBatch, m_speakerOutDiffuse, nSamples, nOffset);
+        for (auto iObj : m_batchObjectInds)
+            m_isObjectInBatch[iObj] = 0;
+    }
 
+    int Renderer::GetObjectIndex(const ObjectMetadata& metadata)
+    {
         // Map from the track index to the corresponding panner index
-        int nObjectInd = GetMatchingIndex(m_pannerTrackInd, m_objMetaDataTmp.trackInd, TypeDefinition::Objects);
+        int nObjectInd = GetMatchingIndex(m_pannerTrackInd, metadata.trackInd, TypeDefinition::Objects);
 
         if (nObjectInd == -1) // this track was not declared at construction. Stopping here.
         {
             std::cerr << "AdmRender Warning: Expected a track index that was declared an Object in construction. Input will not be rendered." << std::endl;
-            return;
+            return -1;
         }
 
+        return m_channelToObjMap[nObjectInd];
+    }
+
+    void Renderer::MixObject(MixContext& context, int iObj, const ObjectMetadata& metadata, const float* pIn, unsigned int nSamples, unsigned int nOffset)
+    {
+        if (!UpdateObjectGains(context, iObj, metadata, nOffset))
+            return;
+
+        unsigned int iSource = (unsigned int)iObj;
+        m_gainInterpDirect.ProcessAccumul(&iSource, &pIn, 1, context.speakerOutDirect, nSamples, nOffset);
+        m_gainInterpDiffuse.ProcessAccumul(&iSource, &pIn, 1, context.speakerOutDiffuse, nSamples, nOffset);
+    }
+
+    bool Renderer::UpdateObjectGains(MixContext& context, int iObj, const ObjectMetadata& metadata, unsigned int nOffset)
+    {
+        ObjectMetadata& objMetaDataTmp = context.objMetaDataTmp;
+
+        // convert from cartesian to polar metadata (if required)
+        adm::toPolar(metadata, objMetaDataTmp);
+
         // Check if the metadata has changed
-        int iObj = m_channelToObjMap[nObjectInd];
-        bool newMetadata = !(m_objMetaDataTmp == m_objectMetadata[iObj]);
+        bool newMetadata = !(objMetaDataTmp == m_objectMetadata[iObj]);
         if (newMetadata)
         {
+            // Queue the metadata to the background thread if there is space. If there is not then the metadata is not stored
+            // so that it is queued the next time the Object is added
+            ObjectGainRequest* request = nullptr;
+            if (context.asyncGainCalc)
+            {
+                request = context.asyncGainCalc->requests.BeginPush();
+                if (!request)
+                {
+                    ApplyDueObjectGains(context, iObj, m_frameIndex, nOffset);
+                    return m_objectHasGains[iObj] != 0;
+                }
+            }
+
             // Store the metadata
-            m_objectMetadata[iObj] = m_objMetaDataTmp;
+            m_objectMetadata[iObj] = objMetaDataTmp;
 
             if (m_RenderLayout == OutputLayout::Binaural) // Modify metadata based on EBU Tech 3396 Sec. 3.6.1.1
             {
                 // The channelLock flag is cleared
-                m_objMetaDataTmp.channelLock.reset();
+                objMetaDataTmp.channelLock.reset();
                 // Any zone entries are removed.
-                m_objMetaDataTmp.zoneExclusion.resize(0);
+                objMetaDataTmp.zoneExclusion.resize(0);
             }
 
-            // Calculate a new gain vector with this metadata
-            m_objectGainCalc->CalculateGains(m_objMetaDataTmp, m_directGains, m_diffuseGains);
-
             // Get the interpolation time
             unsigned int interpLength = 0;
-            if (m_objMetaDataTmp.jumpPosition.flag && m_objMetaDataTmp.jumpPosition.interpolationLength.hasValue())
-                interpLength = m_objMetaDataTmp.jumpPosition.interpolationLength.value(); // = start_time + interpLen
-            else if (m_objMetaDataTmp.jumpPosition.flag && !m_objMetaDataTmp.jumpPosition.interpolationLength.hasValue())
+            if (objMetaDataTmp.jumpPosition.flag && objMetaDataTmp.jumpPosition.interpolationLength.hasValue())
+                interpLength = objMetaDataTmp.jumpPosition.interpolationLength.value(); // = start_time + interpLen
+            else if (objMetaDataTmp.jumpPosition.flag && !objMetaDataTmp.jumpPosition.interpolationLength.hasValue())
                 interpLength = 0; // = start_time
             else
-                interpLength = m_objMetaDataTmp.blockLength; // = end_time
+                interpLength = objMetaDataTmp.blockLength; // = end_time
+
+            if (request)
+            {
+                request->iObj = iObj;
+                request->frame = m_frameIndex;
+                request->nOffset = nOffset;
+                request->interpLength = interpLength;
+                request->metadata = objMetaDataTmp;
+                context.asyncGainCalc->requests.EndPush();
+                context.asyncGainCalc->NotifyRequest();
+            }
+            else
+            {
+                // Calculate a new gain vector with this metadata
+                context.objectGainCalc->CalculateGains(objMetaDataTmp, context.directGains, context.diffuseGains);
 
-            // Set the gains in the interpolators
-            m_gainInterpDirect[iObj].SetGainVector(m_directGains, interpLength);
-            m_gainInterpDiffuse[iObj].SetGainVector(m_diffuseGains, interpLength);
+                // Set the gains in the interpolators
+                m_gainInterpDirect.SetGainVector((unsigned int)iObj, context.directGains, interpLength);
+                m_gainInterpDiffuse.SetGainVector((unsigned int)iObj, context.diffuseGains, interpLength);
+                m_objectHasGains[iObj] = 1;
+            }
+        }
+
+        if (context.asyncGainCalc)
+            ApplyDueObjectGains(context, iObj, m_frameIndex, nOffset);
+
+        return m_objectHasGains[iObj] != 0;
+    }
+
+    void Renderer::ApplyDueObjectGains(MixContext& context, int iObj, uint64_t frameIndex, unsigned int nOffset)
+    {
+        AsyncGainCalc& asyncGainCalc = *context.asyncGainCalc;
+        const unsigned int nMaxPending = asyncGainCalc.nMaxPending;
+
+        asyncGainCalc.CollectResults();
+
+        // Apply the most recent result that is due. A result is due once the latency has passed and the
+        // signal is at or after the offset at which its metadata was added
+        unsigned int& start = asyncGainCalc.pendingStart[iObj];
+        unsigned int& count = asyncGainCalc.pendingCount[iObj];
+        ObjectGainResult* pDue = nullptr;
+        while (count > 0)
+        {
+            ObjectGainResult& result = asyncGainCalc.pending[iObj * nMaxPending + start];
+            uint64_t dueFrame = result.frame + m_objectGainLatency;
+            if (dueFrame > frameIndex || (dueFrame == frameIndex && result.nOffset > nOffset))
+                break;
+            pDue = &result;
+            start = (start + 1) % nMaxPending;
+            count--;
+        }
+        if (pDue)
+        {
+            m_gainInterpDirect.SetGainVector((unsigned int)iObj, pDue->directGains, pDue->interpLength);
+            m_gainInterpDiffuse.SetGainVector((unsigned int)iObj, pDue->diffuseGains, pDue->interpLength);
+            m_objectHasGains[iObj] = 1;
         }
+    }
 
-        m_gainInterpDirect[iObj].ProcessAccumul(pIn, m_speakerOutDirect, nSamples, nOffset);
-        m_gainInterpDiffuse[iObj].ProcessAccumul(pIn, m_speakerOutDiffuse, nSamples, nOffset);
+    void Renderer::FlushObjectGains(MixContext& context)
+    {
+        if (!context.asyncGainCalc)
+            return;
+
+        AsyncGainCalc& asyncGainCalc = *context.asyncGainCalc;
+        asyncGainCalc.WaitForResults();
+
+        // Apply the most recent result of every Object as if it was due
+        for (unsigned int iObj = 0; iObj < (unsigned int)asyncGainCalc.pendingCount.size(); ++iObj)
+            ApplyDueObjectGains(context, (int)iObj, std::numeric_limits<uint64_t>::max() - m_objectGainLatency, 0);
+    }
+
+    void Renderer::ConfigureAsyncGainCalc(MixContext& context)
+    {
+        context.asyncGainCalc.reset();
+        if (m_objectGainLatency > 0)
+            context.asyncGainCalc = std::make_unique<AsyncGainCalc>(m_outputLayout, (unsigned int)m_objectMetadata.size(), m_nChannelsToRender, m_objectGainLatency,
+                m_objectGainCacheSettings, m_extentGainCacheSettings);
+    }
+
+    std::vector<Renderer::MixContext*> Renderer::GetMixContexts()
+    {
+        std::vector<MixContext*> contexts = { &m_mixContext };
+        for (auto& worker : m_workers)
+            contexts.push_back(&worker->context);
+        return contexts;
+    }
+
+    void Renderer::SetObjectGainLatency(unsigned int nFrames)
+    {
+        // Apply any gains still being calculated before changing the latency
+        WaitForWorkers();
+        for (auto pContext : GetMixContexts())
+            FlushObjectGains(*pContext);
+        m_objectGainLatency = nFrames;
+        // If not configured yet the background threads are started in Configure()
+        if (m_nSamples == 0)
+            return;
+        for (auto pContext : GetMixContexts())
+            ConfigureAsyncGainCalc(*pContext);
+    }
+
+    unsigned int Renderer::GetObjectGainLatency() const
+    {
+        return m_objectGainLatency;
+    }
+
+    void Renderer::SetObjectGainCache(const adm::ObjectGainCacheSettings& settings)
+    {
+        // Make sure no gains are being calculated while the caches are changed
+        WaitForObjectGains();
+        m_objectGainCacheSettings = settings;
+        // If not configured yet the caches are set up in Configure()
+        if (m_nSamples == 0)
+            return;
+        for (auto pContext : GetMixContexts())
+        {
+            pContext->objectGainCalc->ConfigureCache(settings);
+            if (pContext->asyncGainCalc)
+                pContext->asyncGainCalc->gainCalc.ConfigureCache(settings);
+        }
+    }
+
+    adm::ObjectGainCacheStatistics Renderer::GetObjectGainCacheStatistics() const
+    {
+        adm::ObjectGainCacheStatistics total;
+        auto addStatistics = [&total](const adm::ObjectGainCalculator* pGainCalc) {
+            if (!pGainCalc)
+                return;
+            auto statistics = pGainCalc->GetCacheStatistics();
+            total.hits += statistics.hits;
+            total.misses += statistics.misses;
+            total.nEntries += statistics.nEntries;
+        };
+        auto addContext = [&addStatistics](const MixContext& context) {
+            addStatistics(context.objectGainCalc.get());
+            if (context.asyncGainCalc)
+                addStatistics(&context.asyncGainCalc->gainCalc);
+        };
+        addContext(m_mixContext);
+        for (auto& worker : m_workers)
+            addContext(worker->context);
+        return total;
+    }
+
+    void Renderer::SetExtentGainCache(const adm::ExtentGainCacheSettings& settings)
+    {
+        // Make sure no gains are being calculated while the caches are changed
+        WaitForObjectGains();
+        m_extentGainCacheSettings = settings;
+        // If not configured yet the caches are set up in Configure()
+        if (m_nSamples == 0)
+            return;
+        for (auto pContext : GetMixContexts())
+        {
+            pContext->objectGainCalc->ConfigureExtentCache(settings);
+            if (pContext->asyncGainCalc)
+                pContext->asyncGainCalc->gainCalc.ConfigureExtentCache(settings);
+        }
+    }
+
+    adm::ExtentGainCacheStatistics Renderer::GetExtentGainCacheStatistics() const
+    {
+        adm::ExtentGainCacheStatistics total;
+        auto addStatistics = [&total](const adm::ObjectGainCalculator* pGainCalc) {
+            if (!pGainCalc)
+                return;
+            auto statistics = pGainCalc->GetExtentCacheStatistics();
+            total.hits += statistics.hits;
+            total.misses += statistics.misses;
+            total.nEntries += statistics.nEntries;
+        };
+        auto addContext = [&addStatistics](const MixContext& context) {
+            addStatistics(context.objectGainCalc.get());
+            if (context.asyncGainCalc)
+                addStatistics(&context.asyncGainCalc->gainCalc);
+        };
+        addContext(m_mixContext);
+        for (auto& worker : m_workers)
+            addContext(worker->context);
+        return total;
+    }
+
+    adm::DirectSpeakerGainCacheStatistics Renderer::GetDirectSpeakerGainCacheStatistics() const
+    {
+        adm::DirectSpeakerGainCacheStatistics total;
+        auto addContext = [&total](const MixContext& context) {
+            if (!context.directSpeakerGainCalc)
+                return;
+            auto statistics = context.directSpeakerGainCalc->GetCacheStatistics();
+            total.hits += statistics.hits;
+            total.misses += statistics.misses;
+        };
+        addContext(m_mixContext);
+        for (auto& worker : m_workers)
+            addContext(worker->context);
+        return total;
+    }
+
+    void Renderer::WaitForObjectGains()
+    {
+        WaitForWorkers();
+        for (auto pContext : GetMixContexts())
+            if (pContext->asyncGainCalc)
+                pContext->asyncGainCalc->WaitForResults();
+    }
+
+    void Renderer::SetConfigCacheDirectory(const std::string& directory)
+    {
+        m_configCacheDirectory = directory;
+    }
+
+    std::string Renderer::GetConfigCachePath() const
+    {
+        return m_configCachePath;
+    }
+
+    SharedTableStatistics Renderer::GetSharedTableStatistics()
+    {
+        return ConfigCache::GetSharedTableStatistics();
+    }
+
+    bool Renderer::AddConfigToCacheKey(ConfigCache& cache, unsigned int nSampleRate, const std::string& HRTFPath) const
+    {
+        cache.AddToKey((unsigned int)m_RenderLayout);
+        cache.AddToKey(m_outputLayout.getLayoutName());
+        for (auto& channel : m_outputLayout.getChannels())
+        {
+            cache.AddToKey(channel.getChannelName());
+            cache.AddToKey(channel.getPolarPosition().azimuth);
+            cache.AddToKey(channel.getPolarPosition().elevation);
+            cache.AddToKey(channel.getPolarPosition().distance);
+            cache.AddToKey((unsigned int)channel.getIsLfe());
+        }
+        cache.AddToKey(m_HoaOrder);
+        cache.AddToKey(nSampleRate);
+        cache.AddToKey(m_nSamples);
+
+        // The binaural filters depend on the contents of the HRTF file rather than its path
+        if (m_RenderLayout == OutputLayout::Binaural)
+        {
+            cache.AddToKey(HRTFPath.empty() ? 0u : 1u);
+            if (!HRTFPath.empty() && !cache.AddFileToKey(HRTFPath))
+                return false;
+        }
+
+        return true;
     }
 
     void Renderer::AddHoa(float** pHoaIn, unsigned int nSamples, const HoaMetadata& metadata, unsigned int nOffset)
@@ -352,61 +942,104 @@ namespace spaudio {
                 normConversionGain = N3dToSn3dFactor<float>(order);
             else if (compareCaseInsensitive(metadata.normalization, "FuMa"))
                 normConversionGain = FuMaToSn3dFactor<float>(order, degree);
-            m_hoaGainInterp[iHoaChWrite].SetGainValue(metadata.gain, m_gainInterpTime);
-            m_hoaAudioOut.AddStream(pHoaIn[iHoaCh], iHoaChWrite, nSamples, nOffset, normConversionGain);
-            float* ppOut[1] = { m_hoaAudioOut.GetChannelPointer(iHoaChWrite) };
-            m_hoaGainInterp[iHoaChWrite].Process(m_hoaAudioOut.GetChannelPointer(iHoaChWrite), ppOut, nSamples, nOffset);
+
+            if (m_workers.empty())
+            {
+                MixHoaChannel(iHoaChWrite, pHoaIn[iHoaCh], nSamples, nOffset, metadata.gain, normConversionGain);
+                continue;
+            }
+
+            // Each worker writes to different HOA channels so they can share the HOA buffer
+            unsigned int iWorker = iHoaChWrite % (unsigned int)m_workers.size();
+            Job& job = GetNextJob(iWorker);
+            job.type = TypeDefinition::HOA;
+            job.index = (int)iHoaChWrite;
+            job.gain = metadata.gain;
+            job.normConversionGain = normConversionGain;
+            job.audio.assign(pHoaIn[iHoaCh], pHoaIn[iHoaCh] + nSamples);
+            job.nSamples = nSamples;
+            job.nOffset = nOffset;
+            SubmitJob(iWorker);
         }
     }
 
+    void Renderer::MixHoaChannel(unsigned int iHoaCh, const float* pIn, unsigned int nSamples, unsigned int nOffset, double gain, float normConversionGain)
+    {
+        m_hoaGainInterp[iHoaCh].SetGainValue(gain, m_gainInterpTime);
+        m_hoaAudioOut.AddStream(const_cast<float*>(pIn), iHoaCh, nSamples, nOffset, normConversionGain);
+        float* ppOut[1] = { m_hoaAudioOut.GetChannelPointer(iHoaCh) };
+        m_hoaGainInterp[iHoaCh].Process(m_hoaAudioOut.GetChannelPointer(iHoaCh), ppOut, nSamples, nOffset);
+    }
+
     void Renderer::AddDirectSpeaker(float* pDirSpkIn, unsigned int nSamples, const DirectSpeakerMetadata& metadata, unsigned int nOffset)
     {
-        bool isSpeakerLFE = isLFE(metadata);
-        if (m_RenderLayout == OutputLayout::Binaural && isSpeakerLFE && !m_useLfeBinaural)
+        // Only check the label for LFE when it matters to avoid the string search
+        if (m_RenderLayout == OutputLayout::Binaural && !m_useLfeBinaural && isLFE(metadata))
             return; // Do not add LFE when rendering to binaural, according to EBU Tech 3396 Sec. 3.7.1
 
+        // Map from the track index to the corresponding panner index
+        int nObjectInd = GetMatchingIndex(m_pannerTrackInd, metadata.trackInd, TypeDefinition::DirectSpeakers);
+
+        if (nObjectInd == -1) // this track was not declared at construction. Stopping here.
+        {
+            std::cerr << "AdmRender Warning: Expected a track index that was declared an Object in construction. Input will not be rendered." << std::endl;
+            return;
+        }
+        int iDirSpk = m_channelToDirectSpeakerMap[nObjectInd];
+
+        if (m_workers.empty())
+        {
+            MixDirectSpeaker(m_mixContext, iDirSpk, metadata, pDirSpkIn, nSamples, nOffset);
+            return;
+        }
+
+        unsigned int iWorker = (unsigned int)iDirSpk % (unsigned int)m_workers.size();
+        Job& job = GetNextJob(iWorker);
+        job.type = TypeDefinition::DirectSpeakers;
+        job.index = iDirSpk;
+        job.directSpeakerMetadata = metadata;
+        job.audio.assign(pDirSpkIn, pDirSpkIn + nSamples);
+        job.nSamples = nSamples;
+        job.nOffset = nOffset;
+        SubmitJob(iWorker);
+    }
+
+    void Renderer::MixDirectSpeaker(MixContext& context, int iDirSpk, const DirectSpeakerMetadata& metadata, const float* pIn, unsigned int nSamples, unsigned int nOffset)
+    {
         if (m_RenderLayout == OutputLayout::Binaural) // Modify metadata based on EBU Tech 3396 Sec. 3.7.1
         {
-            // Keep the metadata that will only use screen locking and the point source panner in m_directSpeakerGainCalc->calculateGains()
-            m_dirSpkBinMetaDataTmp.speakerLabel = metadata.speakerLabel;
-            m_dirSpkBinMetaDataTmp.channelFrequency = metadata.channelFrequency;
-            m_dirSpkBinMetaDataTmp.polarPosition = metadata.polarPosition;
-            m_dirSpkBinMetaDataTmp.screenEdgeLock = metadata.screenEdgeLock;
-            m_dirSpkBinMetaDataTmp.trackInd = metadata.trackInd;
+            DirectSpeakerMetadata& dirSpkBinMetaDataTmp = context.dirSpkBinMetaDataTmp;
 
-            if (isSpeakerLFE && m_useLfeBinaural) // Set the direction of the LFE channel to az = 0deg, el = -30deg
+            // Keep the metadata that will only use screen locking and the point source panner in calculateGains()
+            dirSpkBinMetaDataTmp.speakerLabel = metadata.speakerLabel;
+            dirSpkBinMetaDataTmp.channelFrequency = metadata.channelFrequency;
+            dirSpkBinMetaDataTmp.polarPosition = metadata.polarPosition;
+            dirSpkBinMetaDataTmp.screenEdgeLock = metadata.screenEdgeLock;
+            dirSpkBinMetaDataTmp.trackInd = metadata.trackInd;
+
+            if (isLFE(metadata) && m_useLfeBinaural) // Set the direction of the LFE channel to az = 0deg, el = -30deg
             {
                 // The BEAR layout does not contain any LFE channels so set the LFE to B+000
-                m_dirSpkBinMetaDataTmp.speakerLabel = "B+000";
-                m_dirSpkBinMetaDataTmp.polarPosition.azimuth = 0.;
-                m_dirSpkBinMetaDataTmp.polarPosition.elevation = -30.;
+                dirSpkBinMetaDataTmp.speakerLabel = "B+000";
+                dirSpkBinMetaDataTmp.polarPosition.azimuth = 0.;
+                dirSpkBinMetaDataTmp.polarPosition.elevation = -30.;
             }
 
             // Get the gain vector to be applied to the DirectSpeaker channel
-            m_directSpeakerGainCalc->calculateGains(m_dirSpkBinMetaDataTmp, m_directSpeakerGains);
+            context.directSpeakerGainCalc->calculateGains(dirSpkBinMetaDataTmp, context.directSpeakerGains);
         }
         else
         {
             // Get the gain vector to be applied to the DirectSpeaker channel
-            m_directSpeakerGainCalc->calculateGains(metadata, m_directSpeakerGains);
+            context.directSpeakerGainCalc->calculateGains(metadata, context.directSpeakerGains);
         }
 
         // Apply the metadata gain to the gain vector
-        for (auto& g : m_directSpeakerGains)
+        for (auto& g : context.directSpeakerGains)
             g *= metadata.gain;
 
-        // Map from the track index to the corresponding panner index
-        int nObjectInd = GetMatchingIndex(m_pannerTrackInd, metadata.trackInd, TypeDefinition::DirectSpeakers);
-
-        if (nObjectInd == -1) // this track was not declared at construction. Stopping here.
-        {
-            std::cerr << "AdmRender Warning: Expected a track index that was declared an Object in construction. Input will not be rendered." << std::endl;
-            return;
-        }
-        int iDirSpk = m_channelToDirectSpeakerMap[nObjectInd];
-
-        m_directSpeakerGainInterp[iDirSpk].SetGainVector(m_directSpeakerGains, m_gainInterpTime);
-        m_directSpeakerGainInterp[iDirSpk].ProcessAccumul(pDirSpkIn, m_speakerOut, nSamples, nOffset);
+        m_directSpeakerGainInterp[iDirSpk].SetGainVector(context.directSpeakerGains, m_gainInterpTime);
+        m_directSpeakerGainInterp[iDirSpk].ProcessAccumul(pIn, context.speakerOut, nSamples, nOffset);
     }
 
     void Renderer::AddBinaural(float** pBinIn, unsigned int nSamples, unsigned int nOffset)
@@ -422,6 +1055,9 @@ namespace spaudio {
 
     void Renderer::GetRenderedAudio(float** pRender, unsigned int nSamples)
     {
+        WaitForWorkers();
+        SumWorkerBuses();
+
         // Apply diffuseness filters and compensation delay
         m_decorrelate.Process(m_speakerOutDirect, m_speakerOutDiffuse, nSamples);
 
@@ -478,6 +1114,162 @@ namespace spaudio {
         ClearObjectDirectBuffer();
         // Clear the data in the diffuse buffers
         ClearObjectDiffuseBuffer();
+
+        m_frameIndex++;
+    }
+
+    bool Renderer::SetWorkerCount(unsigned int nWorkers)
+    {
+        // Apply any gains still being calculated before the contexts are destroyed. The Objects may be rendered by
+        // different contexts afterwards so the pending gains of every context are applied
+        WaitForWorkers();
+        for (auto pContext : GetMixContexts())
+            FlushObjectGains(*pContext);
+        StopWorkers();
+        m_nWorkers = nWorkers;
+        // If not configured yet the workers are started at the end of Configure()
+        if (m_nSamples == 0)
+            return true;
+        return StartWorkers(m_configCache.get());
+    }
+
+    unsigned int Renderer::GetWorkerCount() const
+    {
+        return (unsigned int)m_workers.size();
+    }
+
+    void Renderer::ConfigureMixContext(MixContext& context, ConfigCache* pCache)
+    {
+        context.objectGainCalc = std::make_unique<adm::ObjectGainCalculator>(m_outputLayout, pCache);
+        context.objectGainCalc->ConfigureCache(m_objectGainCacheSettings);
+        context.objectGainCalc->ConfigureExtentCache(m_extentGainCacheSettings);
+        context.directSpeakerGainCalc = std::make_unique<adm::DirectSpeakersGainCalc>(m_outputLayout);
+        context.objMetaDataTmp = ObjectMetadata();
+        if (m_outputLayout.getReproductionScreen().hasValue())
+            context.objMetaDataTmp.referenceScreen = m_outputLayout.getReproductionScreen().value();
+        context.directGains.resize(m_nChannelsToRender);
+        context.diffuseGains.resize(m_nChannelsToRender);
+        context.directSpeakerGains.resize(m_nChannelsToRender);
+        ConfigureAsyncGainCalc(context);
+    }
+
+    bool Renderer::StartWorkers(ConfigCache* pCache)
+    {
+        if (m_nWorkers <= 1)
+            return true;
+
+        for (unsigned int iWorker = 0; iWorker < m_nWorkers; ++iWorker)
+        {
+            m_workers.push_back(std::make_unique<Worker>());
+            Worker* pWorker = m_workers.back().get();
+            ConfigureMixContext(pWorker->context, pCache);
+            AllocateBuffers(pWorker->context.speakerOut, m_nChannelsToRender, m_nSamples);
+            AllocateBuffers(pWorker->context.speakerOutDirect, m_nChannelsToRender, m_nSamples);
+            AllocateBuffers(pWorker->context.speakerOutDiffuse, m_nChannelsToRender, m_nSamples);
+
+            pWorker->thread = std::thread([this, pWorker]() {
+                std::unique_lock<std::mutex> lock(pWorker->mutex);
+                while (true)
+                {
+                    pWorker->jobQueued.wait(lock, [pWorker]() { return pWorker->quit || pWorker->nRendered < pWorker->nQueued; });
+                    if (pWorker->quit)
+                        return;
+
+                    // The job is filled in before it is queued and is not modified until the frame is finished
+                    Job& job = pWorker->jobs[pWorker->nRendered];
+                    lock.unlock();
+                    switch (job.type)
+                    {
+                    case TypeDefinition::Objects:
+                        MixObject(pWorker->context, job.index, job.objectMetadata, job.audio.data(), job.nSamples, job.nOffset);
+                        break;
+                    case TypeDefinition::DirectSpeakers:
+                        MixDirectSpeaker(pWorker->context, job.index, job.directSpeakerMetadata, job.audio.data(), job.nSamples, job.nOffset);
+                        break;
+                    case TypeDefinition::HOA:
+                        MixHoaChannel((unsigned int)job.index, job.audio.data(), job.nSamples, job.nOffset, job.gain, job.normConversionGain);
+                        break;
+                    default:
+                        break;
+                    }
+                    lock.lock();
+                    pWorker->nRendered++;
+                    pWorker->jobRendered.notify_one();
+                }
+                });
+        }
+
+        return true;
+    }
+
+    void Renderer::StopWorkers()
+    {
+        // Keep the streams already added this frame by rendering them and adding them to the output
+        WaitForWorkers();
+        SumWorkerBuses();
+
+        for (auto& worker : m_workers)
+        {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->quit = true;
+            }
+            worker->jobQueued.notify_one();
+            worker->thread.join();
+            DeallocateBuffers(worker->context.speakerOut, m_nChannelsToRender);
+            DeallocateBuffers(worker->context.speakerOutDirect, m_nChannelsToRender);
+            DeallocateBuffers(worker->context.speakerOutDiffuse, m_nChannelsToRender);
+        }
+        m_workers.clear();
+    }
+
+    Renderer::Job& Renderer::GetNextJob(unsigned int iWorker)
+    {
+        Worker& worker = *m_workers[iWorker];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.nQueued == worker.jobs.size())
+            worker.jobs.emplace_back();
+        return worker.jobs[worker.nQueued];
+    }
+
+    void Renderer::SubmitJob(unsigned int iWorker)
+    {
+        Worker& worker = *m_workers[iWorker];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.nQueued++;
+        }
+        worker.jobQueued.notify_one();
+    }
+
+    void Renderer::WaitForWorkers()
+    {
+        for (auto& worker : m_workers)
+        {
+            std::unique_lock<std::mutex> lock(worker->mutex);
+            worker->jobRendered.wait(lock, [&worker]() { return worker->nRendered == worker->nQueued; });
+            worker->nRendered = 0;
+            worker->nQueued = 0;
+        }
+    }
+
+    void Renderer::SumWorkerBuses()
+    {
+        // Sum the worker buses in a fixed order so that the result is deterministic
+        for (auto& worker : m_workers)
+        {
+            MixContext& context = worker->context;
+            for (unsigned int iCh = 0; iCh < m_nChannelsToRender; ++iCh)
+                for (unsigned int iSample = 0; iSample < m_nSamples; ++iSample)
+                {
+                    m_speakerOut[iCh][iSample] += context.speakerOut[iCh][iSample];
+                    m_speakerOutDirect[iCh][iSample] += context.speakerOutDirect[iCh][iSample];
+                    m_speakerOutDiffuse[iCh][iSample] += context.speakerOutDiffuse[iCh][iSample];
+                    context.speakerOut[iCh][iSample] = 0.f;
+                    context.speakerOutDirect[iCh][iSample] = 0.f;
+                    context.speakerOutDiffuse[iCh][iSample] = 0.f;
+                }
+        }
     }
 
     void Renderer::ClearHoaBuffer()
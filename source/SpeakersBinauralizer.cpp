@@ -40,17 +40,6 @@ namespace spaudio {
         m_nTaps = tailLength = p_hrtf->getHRTFLen();
         m_nBlockSize = nBlockSize;
 
-        //What will the overlap size be?
-        m_nOverlapLength = m_nBlockSize < m_nTaps ? m_nBlockSize - 1 : m_nTaps - 1;
-        //How large does the FFT need to be
-        m_nFFTSize = 1;
-        while (m_nFFTSize < (m_nBlockSize + m_nTaps + m_nOverlapLength))
-            m_nFFTSize <<= 1;
-        //How many bins is that
-        m_nFFTBins = m_nFFTSize / 2 + 1;
-        //What do we need to scale the result of the iFFT by
-        m_fFFTScaler = 1.f / m_nFFTSize;
-
         m_nSpeakers = nSpeakers;
 
         //Allocate buffers with new settings
@@ -119,16 +108,10 @@ namespace spaudio {
             }
         }
 
-        //Convert frequency domain filters
+        //Set the filters in the convolver
         for (niEar = 0; niEar < 2; niEar++)
-        {
             for (unsigned niChannel = 0; niChannel < nSpeakers; niChannel++)
-            {
-                memcpy(m_pfScratchBufferA.data(), ppfAccumulator[niEar][niChannel], m_nTaps * sizeof(float));
-                memset(&m_pfScratchBufferA[m_nTaps], 0, (m_nFFTSize - m_nTaps) * sizeof(float));
-                kiss_fftr(m_pFFT_cfg.get(), m_pfScratchBufferA.data(), m_ppcpFilters[niEar][niChannel].get());
-            }
-        }
+                m_convolver.SetFilter(niChannel, niEar, ppfAccumulator[niEar][niChannel], m_nTaps);
 
         for (niEar = 0; niEar < 2; niEar++)
             delete[] pfHRTF[niEar];
@@ -146,50 +129,14 @@ namespace spaudio {
 
     void SpeakersBinauralizer::Process(float** pBFSrc, float** ppfDst)
     {
-        kiss_fft_cpx cpTemp;
-
-        for (unsigned niEar = 0; niEar < 2; niEar++)
-        {
-            memset(m_pfScratchBufferA.data(), 0, m_nFFTSize * sizeof(float));
-            for (unsigned niChannel = 0; niChannel < m_nSpeakers; niChannel++)
-            {
-                memcpy(m_pfScratchBufferB.data(), pBFSrc[niChannel], m_nBlockSize * sizeof(float));
-                memset(&m_pfScratchBufferB[m_nBlockSize], 0, (m_nFFTSize - m_nBlockSize) * sizeof(float));
-                kiss_fftr(m_pFFT_cfg.get(), m_pfScratchBufferB.data(), m_pcpScratch.get());
-                for (unsigned ni = 0; ni < m_nFFTBins; ni++)
-                {
-                    cpTemp.r = m_pcpScratch[ni].r * m_ppcpFilters[niEar][niChannel][ni].r
-                        - m_pcpScratch[ni].i * m_ppcpFilters[niEar][niChannel][ni].i;
-                    cpTemp.i = m_pcpScratch[ni].r * m_ppcpFilters[niEar][niChannel][ni].i
-                        + m_pcpScratch[ni].i * m_ppcpFilters[niEar][niChannel][ni].r;
-                    m_pcpScratch[ni] = cpTemp;
-                }
-                kiss_fftri(m_pIFFT_cfg.get(), m_pcpScratch.get(), m_pfScratchBufferB.data());
-                for (unsigned ni = 0; ni < m_nFFTSize; ni++)
-                    m_pfScratchBufferA[ni] += m_pfScratchBufferB[ni];
-            }
-
-            for (unsigned ni = 0; ni < m_nFFTSize; ni++)
-                m_pfScratchBufferA[ni] *= m_fFFTScaler;
-            memcpy(ppfDst[niEar], m_pfScratchBufferA.data(), m_nBlockSize * sizeof(float));
-            for (unsigned ni = 0; ni < m_nOverlapLength; ni++)
-                ppfDst[niEar][ni] += m_pfOverlap[niEar][ni];
-            memcpy(m_pfOverlap[niEar].data(), &m_pfScratchBufferA[m_nBlockSize], m_nOverlapLength * sizeof(float));
-        }
+        m_convolver.Process(pBFSrc, ppfDst, m_nBlockSize);
     }
 
 
     void SpeakersBinauralizer::AllocateBuffers()
     {
-        AmbisonicBinauralizer::AllocateBuffers();
-
-        //Allocate the FFTBins for each channel, for each ear
-        for (unsigned niEar = 0; niEar < 2; niEar++)
-        {
-            m_ppcpFilters[niEar].resize(m_nSpeakers);
-            for (unsigned niChannel = 0; niChannel < m_nSpeakers; niChannel++)
-                m_ppcpFilters[niEar][niChannel].reset(new kiss_fft_cpx[m_nFFTBins]);
-        }
+        //Partition the filters to match the block size
+        m_convolver.Configure(m_nSpeakers, 2, m_nTaps, m_nBlockSize);
     }
 
 } // namespace spaudio
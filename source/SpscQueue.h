@@ -0,0 +1,94 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A lock-free single-producer single-consumer queue                       #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      SpscQueue.h                                              #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace spaudio {
+
+    /** A fixed capacity queue passing elements from one thread to another without locks or memory allocation.
+     *  All the elements are constructed up front and are written in place so that any memory they own is reused.
+     *  Only one thread may call BeginPush()/EndPush() and only one thread may call Front()/Pop().
+     */
+    template<typename T>
+    class SpscQueue
+    {
+    public:
+        /** Construct the queue.
+         * @param capacity	The maximum number of elements in the queue.
+         * @param init		The value to which all the elements are initialised.
+         */
+        SpscQueue(size_t capacity, const T& init = T()) : m_elements(capacity + 1, init)
+        {
+        }
+
+        /** Get the next free element. EndPush() must be called once it has been written.
+         * @return Pointer to the element, or nullptr if the queue is full.
+         */
+        T* BeginPush()
+        {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (Next(tail) == m_head.load(std::memory_order_acquire))
+                return nullptr;
+            return &m_elements[tail];
+        }
+
+        /** Make the element returned by BeginPush() available to the consumer. */
+        void EndPush()
+        {
+            m_tail.store(Next(m_tail.load(std::memory_order_relaxed)), std::memory_order_release);
+        }
+
+        /** Get the oldest element in the queue.
+         * @return Pointer to the element, or nullptr if the queue is empty.
+         */
+        T* Front()
+        {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+                return nullptr;
+            return &m_elements[head];
+        }
+
+        /** Remove the element returned by Front() from the queue. */
+        void Pop()
+        {
+            m_head.store(Next(m_head.load(std::memory_order_relaxed)), std::memory_order_release);
+        }
+
+        /** Check if the queue is empty. Can be called from any thread.
+         * @return True if there are no elements in the queue.
+         */
+        bool IsEmpty() const
+        {
+            return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        // One more element than the capacity so that a full queue can be distinguished from an empty one
+        std::vector<T> m_elements;
+        // Index of the oldest element. Only written by the consumer
+        std::atomic<size_t> m_head{ 0 };
+        // Index of the next element to be written. Only written by the producer
+        std::atomic<size_t> m_tail{ 0 };
+
+        size_t Next(size_t i) const
+        {
+            return i + 1 == m_elements.size() ? 0 : i + 1;
+        }
+    };
+
+} // namespace spaudio
@@ -66,6 +66,11 @@ namespace spaudio {
             if (!m_hasBottomRow)
                 for (unsigned int i = 0; i < Nz; ++i)
                     m_zs[i] = (double)i / ((double)Nz - 1.);
+
+            m_wx.resize(m_xs.size());
+            m_wy.resize(m_ys.size());
+            m_wz.resize(m_zs.size());
+            m_isZUsed.resize(m_zs.size());
         }
 
         AllocentricExtent::~AllocentricExtent()
@@ -110,62 +115,66 @@ namespace spaudio {
             int dim = countDimensions(m_layout, excluded);
             auto mu = calculateMu(dim, xo, yo, zo, sx, sy, sz);
 
+            // The gains at each grid point only depend on which loudspeakers are excluded
+            const GridGains& gridGains = getGridGains(excluded);
+
+            // The weights are separable so only need calculating along each axis of the grid
+            size_t nPoints = std::max({ m_xs.size(), m_ys.size(), m_zs.size() });
+            for (size_t i = 0; i < nPoints; ++i)
+            {
+                size_t iX = std::min(i, m_xs.size() - 1);
+                size_t iY = std::min(i, m_ys.size() - 1);
+                size_t iZ = std::min(i, m_zs.size() - 1);
+                std::tie(m_wx[iX], m_wy[iY], m_wz[iZ]) = calculateWeights(m_xs[iX], m_ys[iY], m_zs[iZ], xo, yo, zo, sx, sy, sz);
+            }
+
+            // Count the z grid coordinates that are used
+            unsigned int nZ = 0;
+            for (size_t iZ = iZStart; iZ < m_zs.size(); ++iZ)
+            {
+                // if there is a non-excluded bottom row and the grid point is below 0
+                m_isZUsed[iZ] = (m_zs[iZ] < 0. && hasBottomRow) || m_zs[iZ] >= 0.;
+                if (m_isZUsed[iZ])
+                    nZ++;
+            }
+
+            // The sum over the grid of (w * g)^p for each axis is separable as well. The x-axis terms only depend on
+            // the x coordinate so the sum is the sum along the x-axis multiplied by the number of (y, z) points, and
+            // likewise for the other axes
             for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
             {
                 m_fx[iLdspk] = 0.;
                 m_fy[iLdspk] = 0.;
                 m_fz[iLdspk] = 0.;
             }
+            for (size_t iX = 0; iX < m_xs.size(); ++iX)
+                accumulatePoweredGains(m_wx[iX], &gridGains.gx[iX * nLdspk], p, m_fx.data(), nLdspk);
+            for (size_t iY = 0; iY < m_ys.size(); ++iY)
+                accumulatePoweredGains(m_wy[iY], &gridGains.gy[iY * nLdspk], p, m_fy.data(), nLdspk);
+            for (size_t iZ = iZStart; iZ < m_zs.size(); ++iZ)
+                if (m_isZUsed[iZ])
+                    accumulatePoweredGains(m_wz[iZ], &gridGains.gz[iZ * nLdspk], p, m_fz.data(), nLdspk);
+            for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+            {
+                m_fx[iLdspk] *= (double)(m_ys.size() * nZ);
+                m_fy[iLdspk] *= (double)(m_xs.size() * nZ);
+                m_fz[iLdspk] *= (double)(m_xs.size() * m_ys.size());
+            }
 
-            double b_floor = 0., b_ceil = 0., b_left = 0., b_right = 0., b_front = 0., b_back = 0.;
+            // Compute the intermediate boundary gains at each boundary
+            size_t iXEnd = m_xs.size() - 1;
+            size_t iYEnd = m_ys.size() - 1;
+            size_t iZEnd = m_zs.size() - 1;
+            for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+            {
+                m_bFloor[iLdspk] = dim == 4 ? std::pow(gridGains.gz[iZStart * nLdspk + iLdspk] * m_wz[iZStart], p) : 0.;
+                m_bCeil[iLdspk] = dim >= 3 ? std::pow(gridGains.gz[iZEnd * nLdspk + iLdspk] * m_wz[iZEnd], p) : 0.;
+                m_bLeft[iLdspk] = std::pow(gridGains.gx[iLdspk] * m_wx[0], p);
+                m_bRight[iLdspk] = std::pow(gridGains.gx[iXEnd * nLdspk + iLdspk] * m_wx[iXEnd], p);
+                m_bBack[iLdspk] = dim > 1 ? std::pow(gridGains.gy[iLdspk] * m_wy[0], p) : 0.;
+                m_bFront[iLdspk] = dim > 1 ? std::pow(gridGains.gy[iYEnd * nLdspk + iLdspk] * m_wy[iYEnd], p) : 0.;
+            }
 
-            for (size_t iX = 0; iX < m_xs.size(); ++iX)
-                for (size_t iY = 0; iY < m_ys.size(); ++iY)
-                    for (size_t iZ = iZStart; iZ < m_zs.size(); ++iZ)
-                        if ((m_zs[iZ] < 0. && hasBottomRow) || m_zs[iZ] >= 0.) // if there is a non-excluded bottom row and the grid point is below 0
-                        {
-                            auto w = calculateWeights(m_xs[iX], m_ys[iY], m_zs[iZ], xo, yo, zo, sx, sy, sz);
-                            auto wx = std::get<0>(w);
-                            auto wy = std::get<1>(w);
-                            auto wz = std::get<2>(w);
-                            // Calculate the gains for the current grid position
-                            // TODO: Store the gains. Only recompute when 'excluded' changes?
-                            CartesianPosition<double> gridPosition = { m_xs[iX], m_ys[iY], m_zs[iZ] };
-                            m_alloPanner.CalculateIndividualGains(gridPosition, excluded, m_gx, m_gy, m_gz);
-
-                            for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
-                            {
-                                m_fx[iLdspk] += std::pow(wx * m_gx[iLdspk], p);
-                                m_fy[iLdspk] += std::pow(wy * m_gy[iLdspk], p);
-                                m_fz[iLdspk] += std::pow(wz * m_gz[iLdspk], p);
-                            }
-
-                            // Compute the intermediate boundary gains once at each boundary
-                            if (iZ == iZStart && iX == 0 && iY == 0) // b_floor, b_left and b_back
-                            {
-                                for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
-                                {
-                                    m_bFloor[iLdspk] = dim == 4 ? std::pow(m_gz[iLdspk] * wz, p) : 0.;
-                                    m_bLeft[iLdspk] = std::pow(m_gx[iLdspk] * wx, p);
-                                    m_bBack[iLdspk] = dim > 1 ? std::pow(m_gy[iLdspk] * wy, p) : 0.;
-                                }
-                            }
-                            else if (iZ == m_zs.size() - 1 && iX == 0 && iY == 0) // b_ceil
-                            {
-                                for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
-                                    m_bCeil[iLdspk] = dim >= 3 ? std::pow(m_gz[iLdspk] * wz, p) : 0.;
-                            }
-                            else if (iX == m_xs.size() - 1 && iZ == iZStart && iY == 0) // b_right
-                            {
-                                for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
-                                    m_bRight[iLdspk] = std::pow(m_gx[iLdspk] * wx, p);
-                            }
-                            else if (iY == m_xs.size() - 1 && iZ == iZStart && iX == 0) // b_front
-                            {
-                                for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
-                                    m_bFront[iLdspk] = dim > 1 ? std::pow(m_gy[iLdspk] * wy, p) : 0.;
-                            }
-                        }
             const double verySmall = std::pow(10., -6.5);
 
             // Compute the inside gains
@@ -205,11 +214,67 @@ namespace spaudio {
             normaliseGains(gains);
         }
 
+        const AllocentricExtent::GridGains& AllocentricExtent::getGridGains(const std::vector<bool>& excluded)
+        {
+            for (size_t i = 0; i < m_gridGainsCache.size(); ++i)
+                if (m_gridGainsCache[i].excluded == excluded)
+                {
+                    // Move to the front so the least recently used is at the back
+                    std::rotate(m_gridGainsCache.begin(), m_gridGainsCache.begin() + i, m_gridGainsCache.begin() + i + 1);
+                    return m_gridGainsCache.front();
+                }
+
+            // Not in the cache so replace the least recently used gains
+            if (m_gridGainsCache.size() < m_nMaxCachedGridGains)
+                m_gridGainsCache.emplace_back();
+            std::rotate(m_gridGainsCache.begin(), m_gridGainsCache.end() - 1, m_gridGainsCache.end());
+            GridGains& gridGains = m_gridGainsCache.front();
+
+            auto nLdspk = m_alloPanner.getNumChannels();
+            gridGains.excluded = excluded;
+            gridGains.gx.resize(m_xs.size() * nLdspk);
+            gridGains.gy.resize(m_ys.size() * nLdspk);
+            gridGains.gz.resize(m_zs.size() * nLdspk);
+            // Each axis gain only depends on the coordinate on that axis so the gains of all three axes can be
+            // calculated at the same time by stepping along the diagonal of the grid
+            size_t nPoints = std::max({ m_xs.size(), m_ys.size(), m_zs.size() });
+            for (size_t i = 0; i < nPoints; ++i)
+            {
+                size_t iX = std::min(i, m_xs.size() - 1);
+                size_t iY = std::min(i, m_ys.size() - 1);
+                size_t iZ = std::min(i, m_zs.size() - 1);
+                CartesianPosition<double> gridPosition = { m_xs[iX], m_ys[iY], m_zs[iZ] };
+                m_alloPanner.CalculateIndividualGains(gridPosition, excluded, m_gx, m_gy, m_gz);
+                std::copy(m_gx.begin(), m_gx.end(), gridGains.gx.begin() + iX * nLdspk);
+                std::copy(m_gy.begin(), m_gy.end(), gridGains.gy.begin() + iY * nLdspk);
+                std::copy(m_gz.begin(), m_gz.end(), gridGains.gz.begin() + iZ * nLdspk);
+            }
+
+            return gridGains;
+        }
+
         unsigned int AllocentricExtent::getNumChannels()
         {
             return m_alloPanner.getNumChannels();
         }
 
+        void AllocentricExtent::accumulatePoweredGains(double w, const double* g, double p, double* f, unsigned int nLdspk)
+        {
+            if (p == 6.)
+            {
+                // The exponent is 6 for all but the largest extents. Avoid pow() so the loop can be vectorised
+                for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+                {
+                    double x = w * g[iLdspk];
+                    double x2 = x * x;
+                    f[iLdspk] += x2 * x2 * x2;
+                }
+            }
+            else
+                for (unsigned int iLdspk = 0; iLdspk < nLdspk; ++iLdspk)
+                    f[iLdspk] += std::pow(w * g[iLdspk], p);
+        }
+
         double AllocentricExtent::calculateSEff(const std::vector<CartesianPosition<double>>& cartesianPositions, const std::vector<bool>& excluded, double sx, double sy, double sz)
         {
             // Find the first non-exlcuded speaker
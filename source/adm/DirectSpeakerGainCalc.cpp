@@ -13,6 +13,7 @@
 /*############################################################################*/
 
 #include "DirectSpeakerGainCalc.h"
+#include <algorithm>
 #include<string>
 #include <map>
 
@@ -27,6 +28,66 @@ namespace spaudio {
             m_nCh = (unsigned int)m_layout.getNumChannels();
             m_gainsPSP.resize(Layout::getLayoutWithoutLFE(layoutWithLFE).getNumChannels(), 0.);
             m_withinBounds.resize(m_nCh);
+
+            CompileMappingRules();
+        }
+
+        void DirectSpeakersGainCalc::CompileMappingRules()
+        {
+            const auto& channelLabels = bs2094::channelLabels;
+            const unsigned int nLabels = (unsigned int)channelLabels.size();
+            auto findLabel = [&channelLabels](const std::string& label) {
+                return (int)(std::find(channelLabels.begin(), channelLabels.end(), label) - channelLabels.begin());
+            };
+
+            m_labelChannels.resize(nLabels);
+            m_labelIsLfe.resize(nLabels);
+            for (unsigned int iLabel = 0; iLabel < nLabels; ++iLabel)
+            {
+                m_labelChannels[iLabel] = m_layout.getMatchingChannelIndex(channelLabels[iLabel]);
+                m_labelIsLfe[iLabel] = stringContains(channelLabels[iLabel], "LFE1") || stringContains(channelLabels[iLabel], "LFE2");
+            }
+            m_lfeChannel = m_layout.getMatchingChannelIndex("LFE1");
+
+            // Give each of the layouts of the ITU packs an index
+            std::vector<std::string> packLayouts;
+            for (auto& ituPack : ituPackNames)
+            {
+                auto it = std::find(packLayouts.begin(), packLayouts.end(), ituPack.second);
+                m_packLayoutIds[ituPack.first] = (unsigned int)(it - packLayouts.begin());
+                if (it == packLayouts.end())
+                    packLayouts.push_back(ituPack.second);
+            }
+
+            // The first rule in the table that applies is used so only the first one for each combination is kept
+            m_packRules.assign(packLayouts.size() * nLabels, -1);
+            for (unsigned int iPack = 0; iPack < (unsigned int)packLayouts.size(); ++iPack)
+                for (const MappingRule& rule : mappingRules)
+                {
+                    int iLabel = findLabel(rule.speakerLabel);
+                    if (iLabel == (int)nLabels || m_packRules[iPack * nLabels + iLabel] >= 0
+                        || !MappingRuleApplies(rule, packLayouts[iPack], rule.speakerLabel, m_layout))
+                        continue;
+
+                    std::vector<std::pair<unsigned int, double>> ruleGains;
+                    for (auto& gain : rule.gains)
+                        ruleGains.push_back({ (unsigned int)m_layout.getMatchingChannelIndex(gain.first), gain.second });
+                    m_packRules[iPack * nLabels + iLabel] = (int)m_ruleGains.size();
+                    m_ruleGains.push_back(ruleGains);
+                }
+        }
+
+        unsigned int DirectSpeakersGainCalc::GetNominalLabelId(const std::string& speakerLabel)
+        {
+            auto it = m_nominalLabelIds.find(speakerLabel);
+            if (it != m_nominalLabelIds.end())
+                return it->second;
+
+            const auto& channelLabels = bs2094::channelLabels;
+            const std::string& nominalLabel = GetNominalSpeakerLabel(speakerLabel);
+            unsigned int labelId = (unsigned int)(std::find(channelLabels.begin(), channelLabels.end(), nominalLabel) - channelLabels.begin());
+            m_nominalLabelIds[speakerLabel] = labelId;
+            return labelId;
         }
 
         DirectSpeakersGainCalc::~DirectSpeakersGainCalc()
@@ -111,39 +172,69 @@ namespace spaudio {
         {
             assert(gains.size() == m_nCh); // Gain vector length must match the number of channels
 
-            // is the current channel an LFE
-            bool isLfeChannel = isLFE(metadata);
+            // DirectSpeaker metadata rarely changes so reuse the gains of the track if it is the same as last time
+            auto it = m_trackGains.find(metadata.trackInd);
+            if (it != m_trackGains.end() && HasSameGains(it->second.metadata, metadata))
+            {
+                gains = it->second.gains;
+                m_cacheHits++;
+                return;
+            }
+
+            CalculateSpeakerGains(metadata, gains);
+            m_cacheMisses++;
+
+            TrackGains& trackGains = m_trackGains[metadata.trackInd];
+            trackGains.metadata = metadata;
+            trackGains.gains = gains;
+        }
+
+        DirectSpeakerGainCacheStatistics DirectSpeakersGainCalc::GetCacheStatistics() const
+        {
+            DirectSpeakerGainCacheStatistics statistics;
+            statistics.hits = m_cacheHits;
+            statistics.misses = m_cacheMisses;
+            return statistics;
+        }
+
+        bool DirectSpeakersGainCalc::HasSameGains(const DirectSpeakerMetadata& a, const DirectSpeakerMetadata& b)
+        {
+            return a.speakerLabel == b.speakerLabel && a.polarPosition == b.polarPosition
+                && a.audioPackFormatID == b.audioPackFormatID && a.channelFrequency == b.channelFrequency
+                && a.screenEdgeLock == b.screenEdgeLock;
+        }
+
+        void DirectSpeakersGainCalc::CalculateSpeakerGains(const DirectSpeakerMetadata& metadata, std::vector<double>& gains)
+        {
+            const unsigned int nLabels = (unsigned int)m_labelChannels.size();
+            unsigned int labelId = GetNominalLabelId(metadata.speakerLabel);
 
-            const std::string& nominalSpeakerLabel = GetNominalSpeakerLabel(metadata.speakerLabel);
+            // is the current channel an LFE. See Rec. ITU-R BS.2127-1 sec. 6.3
+            bool isLfeChannel = m_labelIsLfe[labelId];
+            if (metadata.channelFrequency.lowPass.hasValue() && metadata.channelFrequency.lowPass.value() <= 120.)
+                isLfeChannel = true;
 
             for (auto& g : gains)
                 g = 0.f;
 
             if (metadata.audioPackFormatID.hasValue())
             {
-                auto ituPack = ituPackNames.find(metadata.audioPackFormatID.value());
-                if (ituPack != ituPackNames.end()) // if the audioPackFormat is in the list of ITU packs
+                auto packLayout = m_packLayoutIds.find(metadata.audioPackFormatID.value());
+                if (packLayout != m_packLayoutIds.end()) // if the audioPackFormat is in the list of ITU packs
                 {
-                    const std::string& layoutName = ituPack->second;
-
-                    for (const MappingRule& rule : mappingRules)
+                    // Use the first mapping rule that applies to the pack layout, label and output layout
+                    int iRule = m_packRules[packLayout->second * nLabels + labelId];
+                    if (iRule >= 0)
                     {
-                        if (MappingRuleApplies(rule, layoutName, nominalSpeakerLabel, m_layout))
-                        {
-                            for (auto& gain : rule.gains) {
-                                int idx = m_layout.getMatchingChannelIndex(gain.first);
-                                if (idx >= 0)
-                                    gains[idx] = gain.second;
-                            }
-                            return;
-                        }
+                        for (auto& gain : m_ruleGains[iRule])
+                            gains[gain.first] = gain.second;
+                        return;
                     }
                 }
             }
 
             // Check if there are any speakers with the same label and LFE type
-            const std::string& speakerLabel = GetNominalSpeakerLabel(metadata.speakerLabel);
-            int idx = m_layout.getMatchingChannelIndex(speakerLabel);
+            int idx = m_labelChannels[labelId];
             if (idx >= 0 && (m_layout.getChannel(idx).getIsLfe() == isLfeChannel))
             {
                 gains[idx] = 1.;
@@ -164,9 +255,8 @@ namespace spaudio {
             // If the channel is LFE based on frequency metadata then send to the appropriate LFE (if any exist)
             if (isLfeChannel)
             {
-                idx = m_layout.getMatchingChannelIndex("LFE1");
-                if (idx >= 0)
-                    gains[idx] = 1.;
+                if (m_lfeChannel >= 0)
+                    gains[m_lfeChannel] = 1.;
             }
             else
             {
@@ -14,6 +14,7 @@
 
 #include "CartesianLoudspeakerLayouts.h"
 #include <limits>
+#include <cstring>
 
 namespace spaudio {
     namespace adm {
@@ -387,13 +388,13 @@ namespace spaudio {
         }
 
         //===================================================================================================================================
-        ObjectGainCalculator::ObjectGainCalculator(Layout outputLayout)
+        ObjectGainCalculator::ObjectGainCalculator(Layout outputLayout, ConfigCache* pCache)
             : m_outputLayout(outputLayout)
             , m_nCh((unsigned int)m_outputLayout.getNumChannels())
             , m_nChNoLFE((unsigned int)Layout::getLayoutWithoutLFE(outputLayout).getNumChannels())
             , m_cartPositions(positionsForLayout(outputLayout))
             , m_pspGainCalculator(Layout::getLayoutWithoutLFE(outputLayout))
-            , m_extentPanner(m_pspGainCalculator)
+            , m_extentPanner(m_pspGainCalculator, pCache)
             , m_alloGainCalculator(Layout::getLayoutWithoutLFE(outputLayout))
             , m_alloExtentPanner(Layout::getLayoutWithoutLFE(outputLayout))
             , m_screenScale(outputLayout.getReproductionScreen(), Layout::getLayoutWithoutLFE(outputLayout))
@@ -418,10 +419,8 @@ namespace spaudio {
         {
         }
 
-        void ObjectGainCalculator::CalculateGains(const ObjectMetadata& metadata, std::vector<double>& directGains, std::vector<double>& diffuseGains)
+        void ObjectGainCalculator::CalculateSpatialGains(const ObjectMetadata& metadata, std::vector<double>& gains)
         {
-            assert(directGains.size() == m_nCh && diffuseGains.size() == m_nCh); // Gain vectors must already be of the expected size
-
             if (metadata.cartesian && !m_cartesianLayout)
                 toPolar(metadata, m_objMetadata);
             else
@@ -482,25 +481,61 @@ namespace spaudio {
                 double g_tmp = 0.;
                 for (unsigned int j = 0; j < nDivergedGains; ++j)
                     g_tmp += diverged_gains[j] * m_gainsForEachPos[j][i] * m_gainsForEachPos[j][i];
-                m_gains[i] = sqrt(g_tmp);
+                gains[i] = sqrt(g_tmp);
             }
 
             // Zone exclusion downmix
             // See Rec. ITU-R BS.2127-0 sec. 7.3.12, pg 60
             if (!cartesian)
-                m_zoneExclusionHandler.handle(m_objMetadata.zoneExclusion, m_gains);
+                m_zoneExclusionHandler.handle(m_objMetadata.zoneExclusion, gains);
+        }
+
+        void ObjectGainCalculator::CalculateGains(const ObjectMetadata& metadata, std::vector<double>& directGains, std::vector<double>& diffuseGains)
+        {
+            assert(directGains.size() == m_nCh && diffuseGains.size() == m_nCh); // Gain vectors must already be of the expected size
+
+            if (m_cacheSettings.maxEntries == 0)
+                CalculateSpatialGains(metadata, m_gains);
+            else
+            {
+                GetCacheKey(metadata, m_roundedMetadata);
+                auto it = m_cache.find(m_cacheKey);
+                if (it != m_cache.end())
+                {
+                    m_gains = it->second.gains;
+                    // Move the entry to the front of the usage order
+                    m_cacheOrder.splice(m_cacheOrder.begin(), m_cacheOrder, it->second.order);
+                    m_cacheHits++;
+                }
+                else
+                {
+                    CalculateSpatialGains(m_roundedMetadata, m_gains);
+                    m_cacheMisses++;
+
+                    // Discard the least recently used entry if the cache is full
+                    if (m_cache.size() >= m_cacheSettings.maxEntries)
+                    {
+                        m_cache.erase(m_cache.find(*m_cacheOrder.back()));
+                        m_cacheOrder.pop_back();
+                    }
+                    auto inserted = m_cache.emplace(m_cacheKey, CacheEntry{ m_gains, {} }).first;
+                    m_cacheOrder.push_front(&inserted->first);
+                    inserted->second.order = m_cacheOrder.begin();
+                    m_cacheSize = m_cache.size();
+                }
+            }
 
             // Apply the overall gain to the spatialisation gains
             for (auto& g : m_gains)
-                g *= m_objMetadata.gain;
+                g *= metadata.gain;
 
             // "gains is extended by adding LFE channel gains with value 0 to produce gains_full"
             insertLFE(m_outputLayout, m_gains, directGains);
 
             // Calculate the direct and diffuse gains
             // See Rec. ITU-R BS.2127-0 sec.7.3.1 page 39
-            double directCoefficient = std::sqrt(1. - m_objMetadata.diffuse);
-            double diffuseCoefficient = std::sqrt(m_objMetadata.diffuse);
+            double directCoefficient = std::sqrt(1. - metadata.diffuse);
+            double diffuseCoefficient = std::sqrt(metadata.diffuse);
 
             diffuseGains = directGains;
             for (auto& g : directGains)
@@ -509,6 +544,142 @@ namespace spaudio {
                 g *= diffuseCoefficient;
         }
 
+        void ObjectGainCalculator::ConfigureCache(const ObjectGainCacheSettings& settings)
+        {
+            m_cacheSettings = settings;
+            m_cache.clear();
+            m_cacheOrder.clear();
+            m_cache.reserve(settings.maxEntries);
+            m_cacheHits = 0;
+            m_cacheMisses = 0;
+            m_cacheSize = 0;
+        }
+
+        ObjectGainCacheStatistics ObjectGainCalculator::GetCacheStatistics() const
+        {
+            ObjectGainCacheStatistics statistics;
+            statistics.hits = m_cacheHits;
+            statistics.misses = m_cacheMisses;
+            statistics.nEntries = m_cacheSize;
+            return statistics;
+        }
+
+        void ObjectGainCalculator::ConfigureExtentCache(const ExtentGainCacheSettings& settings)
+        {
+            m_extentPanner.ConfigureCache(settings);
+        }
+
+        ExtentGainCacheStatistics ObjectGainCalculator::GetExtentCacheStatistics() const
+        {
+            return m_extentPanner.GetCacheStatistics();
+        }
+
+        size_t ObjectGainCalculator::CacheKeyHash::operator()(const std::vector<double>& key) const
+        {
+            // FNV-1a hash of the bytes of the values
+            uint64_t hash = 14695981039346656037ull;
+            for (double value : key)
+            {
+                uint64_t bits = 0;
+                memcpy(&bits, &value, sizeof(double));
+                for (int iByte = 0; iByte < 8; ++iByte)
+                {
+                    hash ^= (bits >> (8 * iByte)) & 0xff;
+                    hash *= 1099511628211ull;
+                }
+            }
+            return (size_t)hash;
+        }
+
+        void ObjectGainCalculator::GetCacheKey(const ObjectMetadata& metadata, ObjectMetadata& roundedMetadata)
+        {
+            auto round = [](double value, double step) {
+                // Adding 0 makes sure -0 and +0 have the same key
+                return (step > 0. ? std::round(value / step) * step : value) + 0.;
+            };
+            const double angleStep = m_cacheSettings.angleStep;
+            const double linearStep = m_cacheSettings.linearStep;
+
+            roundedMetadata = metadata;
+            m_cacheKey.clear();
+
+            m_cacheKey.push_back(metadata.cartesian);
+            if (metadata.position.isPolar())
+            {
+                auto& position = roundedMetadata.position.polarPosition();
+                position.azimuth = round(position.azimuth, angleStep);
+                position.elevation = round(position.elevation, angleStep);
+                position.distance = round(position.distance, linearStep);
+                m_cacheKey.insert(m_cacheKey.end(), { 0., position.azimuth, position.elevation, position.distance });
+            }
+            else
+            {
+                auto& position = roundedMetadata.position.cartesianPosition();
+                position.x = round(position.x, linearStep);
+                position.y = round(position.y, linearStep);
+                position.z = round(position.z, linearStep);
+                m_cacheKey.insert(m_cacheKey.end(), { 1., position.x, position.y, position.z });
+            }
+
+            roundedMetadata.width = round(metadata.width, angleStep);
+            roundedMetadata.height = round(metadata.height, angleStep);
+            roundedMetadata.depth = round(metadata.depth, linearStep);
+            m_cacheKey.insert(m_cacheKey.end(), { roundedMetadata.width, roundedMetadata.height, roundedMetadata.depth });
+
+            m_cacheKey.push_back(metadata.objectDivergence.hasValue());
+            if (metadata.objectDivergence.hasValue())
+            {
+                auto& divergence = roundedMetadata.objectDivergence.value();
+                divergence.value = round(divergence.value, linearStep);
+                m_cacheKey.push_back(divergence.value);
+                m_cacheKey.push_back(divergence.azimuthRange.hasValue());
+                if (divergence.azimuthRange.hasValue())
+                {
+                    divergence.azimuthRange = round(divergence.azimuthRange.value(), angleStep);
+                    m_cacheKey.push_back(divergence.azimuthRange.value());
+                }
+                m_cacheKey.push_back(divergence.positionRange.hasValue());
+                if (divergence.positionRange.hasValue())
+                {
+                    divergence.positionRange = round(divergence.positionRange.value(), linearStep);
+                    m_cacheKey.push_back(divergence.positionRange.value());
+                }
+            }
+
+            m_cacheKey.push_back(metadata.channelLock.hasValue());
+            if (metadata.channelLock.hasValue())
+            {
+                m_cacheKey.push_back(metadata.channelLock.value().maxDistance.hasValue());
+                if (metadata.channelLock.value().maxDistance.hasValue())
+                    m_cacheKey.push_back(metadata.channelLock.value().maxDistance.value());
+            }
+
+            m_cacheKey.push_back((double)metadata.zoneExclusion.size());
+            for (auto& zone : metadata.zoneExclusion)
+                if (zone.isPolarZone())
+                {
+                    auto& polarZone = zone.polarZone();
+                    m_cacheKey.insert(m_cacheKey.end(), { 0., polarZone.minAzimuth, polarZone.maxAzimuth, polarZone.minElevation, polarZone.maxElevation });
+                }
+                else
+                {
+                    auto& cartesianZone = zone.cartesianZone();
+                    m_cacheKey.insert(m_cacheKey.end(), { 1., cartesianZone.minX, cartesianZone.maxX, cartesianZone.minY, cartesianZone.maxY, cartesianZone.minZ, cartesianZone.maxZ });
+                }
+
+            m_cacheKey.push_back(metadata.screenEdgeLock.horizontal);
+            m_cacheKey.push_back(metadata.screenEdgeLock.vertical);
+            m_cacheKey.push_back(metadata.screenRef);
+            if (metadata.screenRef)
+            {
+                // The reference screen is only used for screen scaling
+                auto& screen = metadata.referenceScreen;
+                m_cacheKey.insert(m_cacheKey.end(), { (double)screen.isCartesianScreen, screen.aspectRatio,
+                    screen.centrePolarPosition.azimuth, screen.centrePolarPosition.elevation, screen.centrePolarPosition.distance, screen.widthAzimuth,
+                    screen.centreCartesianPosition.x, screen.centreCartesianPosition.y, screen.centreCartesianPosition.z, screen.widthX });
+            }
+        }
+
         void ObjectGainCalculator::divergedPositionsAndGains(const Optional<ObjectDivergence>& objectDivergence, CartesianPosition<double> position, bool cartesian, std::vector<CartesianPosition<double>>& divergedPos, std::vector<double>& divergedGains)
         {
             assert(divergedPos.capacity() == 3 && divergedGains.capacity() == 3); // Must be able to hold up to 3 positions/gains
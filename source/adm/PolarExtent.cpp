@@ -11,13 +11,49 @@
 /*############################################################################*/
 
 #include "PolarExtent.h"
+#include "ConfigCache.h"
+
+#include <cstring>
 
 namespace spaudio {
     namespace adm {
 
         // SpreadPanner ================================================================================
-        SpreadPanner::SpreadPanner(PointSourcePannerGainCalc& psp) : m_pointSourcePannerGainCalc(psp)
+        SpreadPanner::SpreadPanner(PointSourcePannerGainCalc& psp, ConfigCache* pCache) : m_pointSourcePannerGainCalc(psp)
+        {
+            m_rotMat.resize(3, std::vector<double>(3, 0.));
+            m_positionBasisPol.resize(3, 0.);
+            m_posVec.resize(3, 0.);
+            m_positionBasis.resize(3, 0.);
+            m_closestCircle.resize(3, 0.);
+
+            m_nCh = m_pointSourcePannerGainCalc.getNumChannels();
+
+            // Use the virtual sources of another panner with the same layout if there is one
+            if (pCache)
+                m_virtualSources = pCache->GetShared<VirtualSources>("SpreadPanner.virtualSources");
+            if (!m_virtualSources || m_virtualSources->gains.size() != m_virtualSources->positions.size() * m_nCh)
+            {
+                m_virtualSources = CalculateVirtualSources(pCache);
+                if (pCache)
+                {
+                    size_t nBytes = sizeof(VirtualSources) + m_virtualSources->positions.size() * sizeof(CartesianPosition<double>)
+                        + m_virtualSources->gains.size() * sizeof(double);
+                    m_virtualSources = pCache->Share("SpreadPanner.virtualSources", m_virtualSources, nBytes);
+                }
+            }
+
+            m_nVirtualSources = (int)m_virtualSources->positions.size();
+            m_activeSources.reserve(m_nVirtualSources);
+            m_weights.reserve(m_nVirtualSources);
+            m_candidateSources.reserve(m_nVirtualSources);
+        }
+
+        std::shared_ptr<const SpreadPanner::VirtualSources> SpreadPanner::CalculateVirtualSources(ConfigCache* pCache)
         {
+            auto virtualSources = std::make_shared<VirtualSources>();
+            auto& positions = virtualSources->positions;
+
             // Set up the grid on the sphere
             // The algorithm can be found here:
             // http://web.archive.org/web/20150108040043/http://www.math.niu.edu/~rusin/known-math/95/equispace.elect
@@ -34,29 +70,29 @@ namespace spaudio {
                 if (nAz == 0)
                     nAz = 1;
                 double deltaAz = 360. / (double)(nAz);
+                virtualSources->rowElevation.push_back(el);
+                virtualSources->rowStart.push_back((unsigned int)positions.size());
                 for (int iAz = 0; iAz < nAz; ++iAz)
                 {
                     double az = iAz * deltaAz;
-                    m_virtualSourcePositions.push_back(PolarToCartesian(PolarPosition<double>{ az,el,1. }));
+                    positions.push_back(PolarToCartesian(PolarPosition<double>{ az,el,1. }));
                 }
             }
-            m_nVirtualSources = (int)m_virtualSourcePositions.size();
+            virtualSources->rowStart.push_back((unsigned int)positions.size());
 
-            m_weights.resize(m_nVirtualSources);
-            m_rotMat.resize(3, std::vector<double>(3, 0.));
-            m_positionBasisPol.resize(3, 0.);
-            m_posVec.resize(3, 0.);
-            m_positionBasis.resize(3, 0.);
-            m_closestCircle.resize(3, 0.);
+            // The panning gains only depend on the layout so they are loaded from the cache if possible
+            auto& gains = virtualSources->gains;
+            if (pCache && pCache->Get("SpreadPanner.gains", gains) && gains.size() == positions.size() * m_nCh)
+                return virtualSources;
 
-            m_nCh = m_pointSourcePannerGainCalc.getNumChannels();
-            std::vector<double> gainsTmp(m_nCh, 0.);
-            // Calculate the panning gain vector for this grid point
-            for (int i = 0; i < m_nVirtualSources; ++i)
-            {
-                m_pointSourcePannerGainCalc.CalculateGains(m_virtualSourcePositions[i], gainsTmp);
-                m_virtualSourcePanningVectors.push_back(gainsTmp);
-            }
+            // Calculate the panning gain vectors for all of the grid points
+            gains.assign(positions.size() * m_nCh, 0.);
+            m_pointSourcePannerGainCalc.CalculateGains(positions.data(), positions.size(), gains.data());
+
+            if (pCache)
+                pCache->Set("SpreadPanner.gains", gains.data(), gains.size());
+
+            return virtualSources;
         }
 
         SpreadPanner::~SpreadPanner()
@@ -69,13 +105,37 @@ namespace spaudio {
 
             assert(gains.size() == m_nCh); // output gain vector length must match the number of channels
 
+            // The gains are accumulated so must not contain those of the previous call
+            std::fill(gains.begin(), gains.end(), 0.);
+
+            // Only the virtual sources within the fade out region around the "stadium" can have non-zero weights. The
+            // stadium is inside a cap around the source direction reaching the far edge of the circular caps
+            double radius = m_circularCapAzimuth + 0.5 * m_height + m_fadeOut;
+            FindSourcesInCap(position, radius, m_candidateSources);
+
             // Calculate the weights to be applied to each of the virtual source gain vectors
-            for (int i = 0; i < m_nVirtualSources; ++i)
+            const VirtualSources& virtualSources = *m_virtualSources;
+            m_activeSources.clear();
+            m_weights.clear();
+            for (unsigned int iSource : m_candidateSources)
             {
-                m_weights[i] = CalculateWeights(m_virtualSourcePositions[i]);
-                if (m_weights[i] > 1e-4) // Weight and sum the virtual source gain vectors
-                    for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
-                        gains[iCh] += m_weights[i] * m_virtualSourcePanningVectors[i][iCh];
+                double weight = CalculateWeights(virtualSources.positions[iSource]);
+                if (weight > 1e-4)
+                {
+                    m_activeSources.push_back(iSource);
+                    m_weights.push_back(weight);
+                }
+            }
+
+            // Weight and sum the virtual source gain vectors. These are rows of a contiguous matrix so the inner loop
+            // over the channels is vectorised
+            double* pOut = gains.data();
+            for (size_t i = 0; i < m_activeSources.size(); ++i)
+            {
+                const double* pGains = &virtualSources.gains[m_activeSources[i] * m_nCh];
+                const double weight = m_weights[i];
+                for (unsigned int iCh = 0; iCh < m_nCh; ++iCh)
+                    pOut[iCh] += weight * pGains[iCh];
             }
 
             // Normalise
@@ -122,6 +182,70 @@ namespace spaudio {
             return w;
         }
 
+        void SpreadPanner::FindSourcesInCap(CartesianPosition<double> centre, double radius, std::vector<unsigned int>& sources) const
+        {
+            const VirtualSources& virtualSources = *m_virtualSources;
+            const unsigned int nRows = (unsigned int)virtualSources.rowElevation.size();
+            sources.clear();
+
+            // Widen the cap slightly so that rounding errors cannot exclude a source on its edge
+            radius += 1.;
+            if (radius >= 180.)
+            {
+                for (unsigned int i = 0; i < (unsigned int)m_nVirtualSources; ++i)
+                    sources.push_back(i);
+                return;
+            }
+
+            auto centrePolar = CartesianToPolar(centre);
+            double el0 = centrePolar.elevation;
+            bool containsPole = el0 + radius >= 90. || el0 - radius <= -90.;
+            double cosRadius = std::cos(radius * DEG2RAD);
+            double sinEl0 = std::sin(el0 * DEG2RAD);
+            double cosEl0 = std::cos(el0 * DEG2RAD);
+
+            for (unsigned int iRow = 0; iRow < nRows; ++iRow)
+            {
+                double el = virtualSources.rowElevation[iRow];
+                if (std::abs(el - el0) > radius)
+                    continue;
+                unsigned int iStart = virtualSources.rowStart[iRow];
+                unsigned int nAz = virtualSources.rowStart[iRow + 1] - iStart;
+
+                // The half-width of the azimuth range of the row that is inside the cap
+                double halfWidth = 180.;
+                if (!containsPole && std::abs(el) < 90.)
+                {
+                    double cosHalfWidth = (cosRadius - std::sin(el * DEG2RAD) * sinEl0) / (std::cos(el * DEG2RAD) * cosEl0);
+                    halfWidth = std::acos(clamp(cosHalfWidth, -1., 1.)) * RAD2DEG;
+                }
+
+                double deltaAz = 360. / (double)nAz;
+                int iAzLow = (int)std::floor((centrePolar.azimuth - halfWidth) / deltaAz);
+                int iAzHigh = (int)std::ceil((centrePolar.azimuth + halfWidth) / deltaAz);
+                if (iAzHigh - iAzLow + 1 >= (int)nAz)
+                {
+                    for (unsigned int iAz = 0; iAz < nAz; ++iAz)
+                        sources.push_back(iStart + iAz);
+                    continue;
+                }
+
+                // The range may wrap around 0 degrees so the sources are added in two parts to keep them in order
+                unsigned int iAz0 = (unsigned int)(((iAzLow % (int)nAz) + (int)nAz) % (int)nAz);
+                unsigned int iAz1 = (unsigned int)(((iAzHigh % (int)nAz) + (int)nAz) % (int)nAz);
+                if (iAz0 <= iAz1)
+                    for (unsigned int iAz = iAz0; iAz <= iAz1; ++iAz)
+                        sources.push_back(iStart + iAz);
+                else
+                {
+                    for (unsigned int iAz = 0; iAz <= iAz1; ++iAz)
+                        sources.push_back(iStart + iAz);
+                    for (unsigned int iAz = iAz0; iAz < nAz; ++iAz)
+                        sources.push_back(iStart + iAz);
+                }
+            }
+        }
+
         void SpreadPanner::ConfigureWeightingFunction(CartesianPosition<double> position, double width, double height)
         {
             m_width = width;
@@ -147,8 +271,8 @@ namespace spaudio {
 
 
         // PolarExtentHandler ==========================================================================
-        PolarExtentHandler::PolarExtentHandler(PointSourcePannerGainCalc& psp) : m_pointSourcePannerGainGalc(psp),
-            m_spreadPanner(m_pointSourcePannerGainGalc)
+        PolarExtentHandler::PolarExtentHandler(PointSourcePannerGainCalc& psp, ConfigCache* pCache) : m_pointSourcePannerGainGalc(psp),
+            m_spreadPanner(m_pointSourcePannerGainGalc, pCache)
         {
             m_nCh = m_pointSourcePannerGainGalc.getNumChannels();
             m_g_p.resize(m_nCh);
@@ -230,7 +354,10 @@ namespace spaudio {
             }
             if (p > 0.)
             {
-                m_spreadPanner.CalculateGains(position, width, height, m_g_s);
+                if (m_cacheSettings.maxEntries == 0)
+                    m_spreadPanner.CalculateGains(position, width, height, m_g_s);
+                else
+                    CalculateCachedSpreadGains(position, width, height, m_g_s);
             }
             else
             {
@@ -244,5 +371,92 @@ namespace spaudio {
                 gains[i] = std::sqrt(p * m_g_s[i] * m_g_s[i] + (1. - p) * m_g_p[i] * m_g_p[i]);
         }
 
+
+        void PolarExtentHandler::CalculateCachedSpreadGains(CartesianPosition<double> position, double width, double height, std::vector<double>& gains)
+        {
+            auto round = [](double value, double step) {
+                // Adding 0 makes sure -0 and +0 have the same key
+                return (step > 0. ? std::round(value / step) * step : value) + 0.;
+            };
+            const double angleStep = m_cacheSettings.angleStep;
+
+            CacheKey key;
+            if (angleStep > 0.)
+            {
+                // Calculate the gains for the rounded direction so that they do not depend on which direction was first
+                PolarPosition<double> polarPosition = CartesianToPolar(position);
+                polarPosition.azimuth = round(polarPosition.azimuth, angleStep);
+                polarPosition.elevation = round(polarPosition.elevation, angleStep);
+                polarPosition.distance = 1.;
+                position = PolarToCartesian(polarPosition);
+                width = round(width, angleStep);
+                height = round(height, angleStep);
+                key = { polarPosition.azimuth, polarPosition.elevation, 0., width, height };
+            }
+            else
+                key = { position.x + 0., position.y + 0., position.z + 0., width + 0., height + 0. };
+
+            auto it = m_cache.find(key);
+            if (it != m_cache.end())
+            {
+                gains = it->second.gains;
+                // Move the entry to the front of the usage order
+                m_cacheOrder.splice(m_cacheOrder.begin(), m_cacheOrder, it->second.order);
+                m_cacheHits++;
+                return;
+            }
+
+            m_spreadPanner.CalculateGains(position, width, height, gains);
+            m_cacheMisses++;
+
+            // Discard the least recently used entry if the cache is full
+            if (m_cache.size() >= m_cacheSettings.maxEntries)
+            {
+                m_cache.erase(m_cache.find(*m_cacheOrder.back()));
+                m_cacheOrder.pop_back();
+            }
+            auto inserted = m_cache.emplace(key, CacheEntry{ gains, {} }).first;
+            m_cacheOrder.push_front(&inserted->first);
+            inserted->second.order = m_cacheOrder.begin();
+            m_cacheSize = m_cache.size();
+        }
+
+        void PolarExtentHandler::ConfigureCache(const ExtentGainCacheSettings& settings)
+        {
+            m_cacheSettings = settings;
+            m_cache.clear();
+            m_cacheOrder.clear();
+            m_cache.reserve(settings.maxEntries);
+            m_cacheHits = 0;
+            m_cacheMisses = 0;
+            m_cacheSize = 0;
+        }
+
+        ExtentGainCacheStatistics PolarExtentHandler::GetCacheStatistics() const
+        {
+            ExtentGainCacheStatistics statistics;
+            statistics.hits = m_cacheHits;
+            statistics.misses = m_cacheMisses;
+            statistics.nEntries = m_cacheSize;
+            return statistics;
+        }
+
+        size_t PolarExtentHandler::CacheKeyHash::operator()(const CacheKey& key) const
+        {
+            // FNV-1a hash of the bytes of the values
+            uint64_t hash = 14695981039346656037ull;
+            for (double value : key)
+            {
+                uint64_t bits = 0;
+                memcpy(&bits, &value, sizeof(double));
+                for (int iByte = 0; iByte < 8; ++iByte)
+                {
+                    hash ^= (bits >> (8 * iByte)) & 0xff;
+                    hash *= 1099511628211ull;
+                }
+            }
+            return (size_t)hash;
+        }
+
     } // namespace adm
 } // namespace spaudio
@@ -0,0 +1,263 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A real-valued FFT with a selectable implementation                      #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      FFT.cpp                                                  #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#include "FFT.h"
+#include "config.h"
+#include "kiss_fftr.h"
+
+#ifdef HAVE_FFTW
+#include <fftw3.h>
+#endif
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace spaudio {
+
+    /** Interface implemented by each of the FFT backends. */
+    class FFTImplementation
+    {
+    public:
+        virtual ~FFTImplementation() {}
+        virtual void Forward(const float* pfIn, float* pfSpectrum) = 0;
+        virtual void Inverse(const float* pfSpectrum, float* pfOut) = 0;
+    };
+
+    namespace {
+
+        class KissFFTImplementation : public FFTImplementation
+        {
+        public:
+            KissFFTImplementation(unsigned int nSize)
+            {
+                m_pFFT_cfg = kiss_fftr_alloc(nSize, 0, 0, 0);
+                m_pIFFT_cfg = kiss_fftr_alloc(nSize, 1, 0, 0);
+            }
+
+            ~KissFFTImplementation()
+            {
+                kiss_fftr_free(m_pFFT_cfg);
+                kiss_fftr_free(m_pIFFT_cfg);
+            }
+
+            bool IsValid() const
+            {
+                return m_pFFT_cfg && m_pIFFT_cfg;
+            }
+
+            void Forward(const float* pfIn, float* pfSpectrum) override
+            {
+                kiss_fftr(m_pFFT_cfg, pfIn, reinterpret_cast<kiss_fft_cpx*>(pfSpectrum));
+            }
+
+            void Inverse(const float* pfSpectrum, float* pfOut) override
+            {
+                kiss_fftri(m_pIFFT_cfg, reinterpret_cast<const kiss_fft_cpx*>(pfSpectrum), pfOut);
+            }
+
+        private:
+            kiss_fftr_cfg m_pFFT_cfg = nullptr;
+            kiss_fftr_cfg m_pIFFT_cfg = nullptr;
+        };
+
+#ifdef HAVE_FFTW
+        /** Only fftwf_execute() is thread-safe so making and destroying plans must be serialised.
+         * @return The mutex held while the FFTW planner is used.
+         */
+        std::mutex& GetFFTWPlannerMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        class FFTWImplementation : public FFTImplementation
+        {
+        public:
+            FFTWImplementation(unsigned int nSize)
+                : m_nSize(nSize)
+            {
+                // The plans are made for internal buffers so that the caller's buffers do not need any particular
+                // alignment and the input to the inverse transform is not overwritten
+                m_pfTime = fftwf_alloc_real(nSize);
+                m_pSpectrum = fftwf_alloc_complex(nSize / 2 + 1);
+                if (m_pfTime && m_pSpectrum)
+                {
+                    std::lock_guard<std::mutex> lock(GetFFTWPlannerMutex());
+                    m_forwardPlan = fftwf_plan_dft_r2c_1d((int)nSize, m_pfTime, m_pSpectrum, FFTW_ESTIMATE);
+                    m_inversePlan = fftwf_plan_dft_c2r_1d((int)nSize, m_pSpectrum, m_pfTime, FFTW_ESTIMATE);
+                }
+            }
+
+            ~FFTWImplementation()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(GetFFTWPlannerMutex());
+                    if (m_forwardPlan)
+                        fftwf_destroy_plan(m_forwardPlan);
+                    if (m_inversePlan)
+                        fftwf_destroy_plan(m_inversePlan);
+                }
+                fftwf_free(m_pfTime);
+                fftwf_free(m_pSpectrum);
+            }
+
+            bool IsValid() const
+            {
+                return m_forwardPlan && m_inversePlan;
+            }
+
+            void Forward(const float* pfIn, float* pfSpectrum) override
+            {
+                memcpy(m_pfTime, pfIn, m_nSize * sizeof(float));
+                fftwf_execute(m_forwardPlan);
+                memcpy(pfSpectrum, m_pSpectrum, (m_nSize / 2 + 1) * sizeof(fftwf_complex));
+            }
+
+            void Inverse(const float* pfSpectrum, float* pfOut) override
+            {
+                memcpy(m_pSpectrum, pfSpectrum, (m_nSize / 2 + 1) * sizeof(fftwf_complex));
+                fftwf_execute(m_inversePlan);
+                memcpy(pfOut, m_pfTime, m_nSize * sizeof(float));
+            }
+
+        private:
+            unsigned int m_nSize = 0;
+            float* m_pfTime = nullptr;
+            fftwf_complex* m_pSpectrum = nullptr;
+            fftwf_plan m_forwardPlan = nullptr;
+            fftwf_plan m_inversePlan = nullptr;
+        };
+#endif
+
+        FFTBackend GetFastestBackend()
+        {
+#ifdef HAVE_FFTW
+            return FFTBackend::FFTW;
+#else
+            return FFTBackend::KissFFT;
+#endif
+        }
+
+        std::atomic<FFTBackend> g_defaultBackend(GetFastestBackend());
+
+    } // namespace
+
+    FFT::FFT()
+    {
+    }
+
+    FFT::~FFT()
+    {
+    }
+
+    bool FFT::Configure(unsigned int nSize, FFTBackend backend)
+    {
+        m_pImpl.reset();
+        m_nSize = 0;
+
+        if (nSize == 0 || nSize % 2 != 0 || !IsBackendAvailable(backend))
+            return false;
+
+        switch (backend)
+        {
+        case FFTBackend::KissFFT:
+        {
+            std::unique_ptr<KissFFTImplementation> pImpl(new KissFFTImplementation(nSize));
+            if (!pImpl->IsValid())
+                return false;
+            m_pImpl = std::move(pImpl);
+            break;
+        }
+#ifdef HAVE_FFTW
+        case FFTBackend::FFTW:
+        {
+            std::unique_ptr<FFTWImplementation> pImpl(new FFTWImplementation(nSize));
+            if (!pImpl->IsValid())
+                return false;
+            m_pImpl = std::move(pImpl);
+            break;
+        }
+#endif
+        default:
+            return false;
+        }
+
+        m_nSize = nSize;
+        m_backend = backend;
+
+        return true;
+    }
+
+    void FFT::Forward(const float* pfIn, float* pfSpectrum)
+    {
+        m_pImpl->Forward(pfIn, pfSpectrum);
+    }
+
+    void FFT::Inverse(const float* pfSpectrum, float* pfOut)
+    {
+        m_pImpl->Inverse(pfSpectrum, pfOut);
+    }
+
+    unsigned int FFT::GetSize() const
+    {
+        return m_nSize;
+    }
+
+    FFTBackend FFT::GetBackend() const
+    {
+        return m_backend;
+    }
+
+    FFTBackend FFT::GetDefaultBackend()
+    {
+        return g_defaultBackend.load();
+    }
+
+    bool FFT::SetDefaultBackend(FFTBackend backend)
+    {
+        if (!IsBackendAvailable(backend))
+            return false;
+        g_defaultBackend.store(backend);
+        return true;
+    }
+
+    bool FFT::IsBackendAvailable(FFTBackend backend)
+    {
+        switch (backend)
+        {
+        case FFTBackend::KissFFT:
+            return true;
+        case FFTBackend::FFTW:
+#ifdef HAVE_FFTW
+            return true;
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    const char* FFT::GetBackendName(FFTBackend backend)
+    {
+        switch (backend)
+        {
+        case FFTBackend::KissFFT:
+            return "kiss_fft";
+        case FFTBackend::FFTW:
+            return "FFTW";
+        }
+        return "unknown";
+    }
+
+} // namespace spaudio
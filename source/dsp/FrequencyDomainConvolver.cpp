@@ -0,0 +1,281 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  A uniformly partitioned multichannel convolver                          #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      FrequencyDomainConvolver.cpp                             #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#include "FrequencyDomainConvolver.h"
+#include "SimdKernels.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+
+namespace spaudio {
+
+    FrequencyDomainConvolver::FrequencyDomainConvolver()
+    {
+    }
+
+    FrequencyDomainConvolver::~FrequencyDomainConvolver()
+    {
+    }
+
+    bool FrequencyDomainConvolver::Configure(unsigned int nInputs, unsigned int nOutputs, unsigned int nMaxTaps, unsigned int nPartitionSize)
+    {
+        if (nInputs == 0 || nOutputs == 0 || nMaxTaps == 0 || nPartitionSize == 0)
+            return false;
+
+        m_nInputs = nInputs;
+        m_nOutputs = nOutputs;
+
+        m_nPartitionSize = 1;
+        while (m_nPartitionSize < nPartitionSize)
+            m_nPartitionSize <<= 1;
+        m_nPartitions = (nMaxTaps + m_nPartitionSize - 1) / m_nPartitionSize;
+
+        // Each partition is convolved using overlap-save with an FFT twice the size of the partition
+        m_nFFTSize = 2 * m_nPartitionSize;
+        m_nFFTBins = m_nFFTSize / 2 + 1;
+        m_nBinStride = (m_nFFTBins + 7) & ~7u;
+
+        if (!m_fft.Configure(m_nFFTSize))
+            return false;
+
+        const size_t nSpectrum = 2 * (size_t)m_nBinStride;
+        m_inputHistory.assign((size_t)m_nInputs * m_nFFTSize, 0.f);
+        m_fdl.assign((size_t)m_nInputs * (m_nPartitions - 1) * nSpectrum, 0.f);
+        m_inputSpectrum.assign((size_t)m_nInputs * nSpectrum, 0.f);
+        m_filters = std::make_shared<FilterSet>();
+        m_filters->nInputs = m_nInputs;
+        m_filters->nOutputs = m_nOutputs;
+        m_filters->nMaxTaps = nMaxTaps;
+        m_filters->nPartitions = m_nPartitions;
+        m_filters->nBinStride = m_nBinStride;
+        m_filters->spectra.assign((size_t)m_nInputs * m_nOutputs * m_nPartitions * nSpectrum, 0.f);
+        m_filters->routing.assign(m_nOutputs, std::vector<unsigned int>());
+        for (auto& routing : m_filters->routing)
+            routing.reserve(m_nInputs);
+        m_sharedFilters.reset();
+        m_pFilters = m_filters.get();
+        m_tailSpectrum.assign((size_t)m_nOutputs * nSpectrum, 0.f);
+        m_accum.assign(nSpectrum, 0.f);
+        m_fftSpectrum.assign(2 * m_nFFTBins, 0.f);
+        m_scratch.assign(m_nFFTSize, 0.f);
+
+        Reset();
+
+        return true;
+    }
+
+    void FrequencyDomainConvolver::SetFilter(unsigned int iInput, unsigned int iOutput, const float* pfFilter, unsigned int nTaps)
+    {
+        assert(iInput < m_nInputs && iOutput < m_nOutputs);
+        assert(nTaps <= m_nPartitions * m_nPartitionSize);
+
+        FilterSet& filters = GetWritableFilters();
+        const size_t iFilter = (size_t)iInput * m_nOutputs + iOutput;
+
+        // Fold the inverse FFT scaling into the filter spectra
+        const float fFFTScaler = 1.f / m_nFFTSize;
+        for (unsigned int iPart = 0; iPart < m_nPartitions; ++iPart)
+        {
+            unsigned int nStart = std::min(iPart * m_nPartitionSize, nTaps);
+            unsigned int nPartTaps = std::min(m_nPartitionSize, nTaps - nStart);
+            std::fill(m_scratch.begin(), m_scratch.end(), 0.f);
+            for (unsigned int i = 0; i < nPartTaps; ++i)
+                m_scratch[i] = pfFilter[nStart + i] * fFFTScaler;
+            ForwardFFT(m_scratch.data(), &filters.spectra[(iFilter * m_nPartitions + iPart) * 2 * m_nBinStride]);
+        }
+
+        auto& routing = filters.routing[iOutput];
+        if (std::find(routing.begin(), routing.end(), iInput) == routing.end())
+            routing.push_back(iInput);
+    }
+
+    void FrequencyDomainConvolver::ClearFilters()
+    {
+        if (m_pFilters == nullptr)
+            return;
+        for (auto& routing : GetWritableFilters().routing)
+            routing.clear();
+    }
+
+    std::shared_ptr<const FrequencyDomainConvolver::FilterSet> FrequencyDomainConvolver::GetFilters()
+    {
+        // From now on the filters are only read so that they can be used by other convolvers
+        if (m_filters)
+            m_sharedFilters = std::move(m_filters);
+        return m_sharedFilters;
+    }
+
+    bool FrequencyDomainConvolver::SetFilters(std::shared_ptr<const FilterSet> filters)
+    {
+        if (!filters || filters->nInputs != m_nInputs || filters->nOutputs != m_nOutputs
+            || filters->nPartitions != m_nPartitions || filters->nBinStride != m_nBinStride)
+            return false;
+
+        m_filters.reset();
+        m_sharedFilters = std::move(filters);
+        m_pFilters = m_sharedFilters.get();
+        return true;
+    }
+
+    size_t FrequencyDomainConvolver::FilterSet::GetMemoryUsage() const
+    {
+        size_t nBytes = sizeof(FilterSet) + spectra.size() * sizeof(float);
+        for (auto& inputs : routing)
+            nBytes += sizeof(inputs) + inputs.size() * sizeof(unsigned int);
+        return nBytes;
+    }
+
+    void FrequencyDomainConvolver::Reset()
+    {
+        std::fill(m_inputHistory.begin(), m_inputHistory.end(), 0.f);
+        std::fill(m_fdl.begin(), m_fdl.end(), 0.f);
+        std::fill(m_tailSpectrum.begin(), m_tailSpectrum.end(), 0.f);
+        m_nFill = 0;
+        m_iFdlHead = 0;
+    }
+
+    void FrequencyDomainConvolver::Process(const float* const* ppfIn, float** ppfOut, unsigned int nSamples)
+    {
+        // Split the block into segments that do not cross a partition boundary
+        unsigned int nOffset = 0;
+        while (nOffset < nSamples)
+        {
+            unsigned int nSegment = std::min(nSamples - nOffset, m_nPartitionSize - m_nFill);
+            ProcessSegment(ppfIn, ppfOut, nOffset, nSegment);
+            nOffset += nSegment;
+        }
+    }
+
+    unsigned int FrequencyDomainConvolver::GetPartitionSize() const
+    {
+        return m_nPartitionSize;
+    }
+
+    unsigned int FrequencyDomainConvolver::GetPartitionCount() const
+    {
+        return m_nPartitions;
+    }
+
+    void FrequencyDomainConvolver::ProcessSegment(const float* const* ppfIn, float** ppfOut, unsigned int nOffset, unsigned int nSamples)
+    {
+        const size_t nSpectrum = 2 * (size_t)m_nBinStride;
+
+        // Add the new samples to the current partition and transform the window. Samples that have not been received
+        // yet are zero so the output up to the latest sample is exact. All inputs are read before any output is
+        // written so the processing can be done in-place.
+        for (unsigned int iIn = 0; iIn < m_nInputs; ++iIn)
+        {
+            float* pfHistory = &m_inputHistory[(size_t)iIn * m_nFFTSize];
+            memcpy(&pfHistory[m_nPartitionSize + m_nFill], &ppfIn[iIn][nOffset], nSamples * sizeof(float));
+            ForwardFFT(pfHistory, &m_inputSpectrum[iIn * nSpectrum]);
+        }
+        unsigned int nReadPos = m_nPartitionSize + m_nFill;
+        m_nFill += nSamples;
+
+        for (unsigned int iOut = 0; iOut < m_nOutputs; ++iOut)
+        {
+            // Start with the contribution from the previous partitions and add that of the current partition
+            const float* pTail = &m_tailSpectrum[iOut * nSpectrum];
+            std::copy(pTail, pTail + nSpectrum, m_accum.begin());
+            float* pAccRe = m_accum.data();
+            float* pAccIm = pAccRe + m_nBinStride;
+            for (unsigned int iIn : m_pFilters->routing[iOut])
+            {
+                const float* pX = &m_inputSpectrum[iIn * nSpectrum];
+                const float* pH = GetFilterSpectrum(iIn, iOut, 0);
+                simd::ComplexMultiplyAccumulate(pX, pX + m_nBinStride, pH, pH + m_nBinStride, pAccRe, pAccIm, m_nFFTBins);
+            }
+            InverseFFT(m_accum.data(), m_scratch.data());
+            // Only the second half of the circular convolution is valid
+            memcpy(&ppfOut[iOut][nOffset], &m_scratch[nReadPos], nSamples * sizeof(float));
+        }
+
+        if (m_nFill == m_nPartitionSize)
+            AdvancePartition();
+    }
+
+    void FrequencyDomainConvolver::AdvancePartition()
+    {
+        const size_t nSpectrum = 2 * (size_t)m_nBinStride;
+        unsigned int nDelayed = m_nPartitions - 1;
+        if (nDelayed > 0)
+        {
+            // Push the spectra of the completed windows into the frequency-domain delay line
+            m_iFdlHead = (m_iFdlHead + nDelayed - 1) % nDelayed;
+            for (unsigned int iIn = 0; iIn < m_nInputs; ++iIn)
+            {
+                const float* pX = &m_inputSpectrum[iIn * nSpectrum];
+                std::copy(pX, pX + nSpectrum, &m_fdl[(iIn * nDelayed + m_iFdlHead) * nSpectrum]);
+            }
+
+            // The contribution of the delayed windows to the next output partition does not depend on any
+            // future input so it can be calculated now
+            for (unsigned int iOut = 0; iOut < m_nOutputs; ++iOut)
+            {
+                float* pTailRe = &m_tailSpectrum[iOut * nSpectrum];
+                float* pTailIm = pTailRe + m_nBinStride;
+                std::fill(pTailRe, pTailRe + nSpectrum, 0.f);
+                for (unsigned int iIn : m_pFilters->routing[iOut])
+                {
+                    for (unsigned int iPart = 1; iPart < m_nPartitions; ++iPart)
+                    {
+                        unsigned int iSlot = (m_iFdlHead + iPart - 1) % nDelayed;
+                        const float* pX = &m_fdl[(iIn * nDelayed + iSlot) * nSpectrum];
+                        const float* pH = GetFilterSpectrum(iIn, iOut, iPart);
+                        simd::ComplexMultiplyAccumulate(pX, pX + m_nBinStride, pH, pH + m_nBinStride, pTailRe, pTailIm, m_nFFTBins);
+                    }
+                }
+            }
+        }
+
+        // The current partition becomes the previous one
+        for (unsigned int iIn = 0; iIn < m_nInputs; ++iIn)
+        {
+            float* pfHistory = &m_inputHistory[(size_t)iIn * m_nFFTSize];
+            memcpy(pfHistory, &pfHistory[m_nPartitionSize], m_nPartitionSize * sizeof(float));
+            std::fill(pfHistory + m_nPartitionSize, pfHistory + m_nFFTSize, 0.f);
+        }
+        m_nFill = 0;
+    }
+
+    void FrequencyDomainConvolver::ForwardFFT(const float* pfIn, float* pSpectrum)
+    {
+        m_fft.Forward(pfIn, m_fftSpectrum.data());
+        simd::Deinterleave(m_fftSpectrum.data(), pSpectrum, pSpectrum + m_nBinStride, m_nFFTBins);
+    }
+
+    void FrequencyDomainConvolver::InverseFFT(const float* pSpectrum, float* pfOut)
+    {
+        simd::Interleave(pSpectrum, pSpectrum + m_nBinStride, m_fftSpectrum.data(), m_nFFTBins);
+        m_fft.Inverse(m_fftSpectrum.data(), pfOut);
+    }
+
+    FrequencyDomainConvolver::FilterSet& FrequencyDomainConvolver::GetWritableFilters()
+    {
+        if (!m_filters)
+        {
+            m_filters = std::make_shared<FilterSet>(*m_sharedFilters);
+            m_sharedFilters.reset();
+            m_pFilters = m_filters.get();
+        }
+        return *m_filters;
+    }
+
+    const float* FrequencyDomainConvolver::GetFilterSpectrum(unsigned int iInput, unsigned int iOutput, unsigned int iPartition) const
+    {
+        size_t iFilter = (size_t)iInput * m_nOutputs + iOutput;
+        return &m_pFilters->spectra[(iFilter * m_nPartitions + iPartition) * 2 * m_nBinStride];
+    }
+
+} // namespace spaudio
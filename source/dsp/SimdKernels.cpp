@@ -0,0 +1,264 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  Vectorised inner loops shared by the processing classes                 #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      SimdKernels.cpp                                          #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#include "SimdKernels.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SPAUDIO_USE_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define SPAUDIO_USE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace spaudio {
+    namespace simd {
+
+        namespace {
+            /** Calculate R rows of a matrix multiplication for samples iStart to iEnd - 1. See MatrixMultiply(). */
+            template<unsigned int R>
+            void matrixMultiplyRows(const float* pMatrix, unsigned int nCols, const float* const* ppIn, float* const* ppOut,
+                unsigned int iStart, unsigned int iEnd)
+            {
+                unsigned int i = iStart;
+#if defined(SPAUDIO_USE_SSE)
+                for (; i + 8 <= iEnd; i += 8)
+                {
+                    __m128 acc[R][2];
+                    for (unsigned int r = 0; r < R; ++r)
+                        acc[r][0] = acc[r][1] = _mm_setzero_ps();
+                    for (unsigned int c = 0; c < nCols; ++c)
+                    {
+                        __m128 in0 = _mm_loadu_ps(ppIn[c] + i);
+                        __m128 in1 = _mm_loadu_ps(ppIn[c] + i + 4);
+                        for (unsigned int r = 0; r < R; ++r)
+                        {
+                            __m128 g = _mm_set1_ps(pMatrix[r * nCols + c]);
+                            acc[r][0] = _mm_add_ps(acc[r][0], _mm_mul_ps(in0, g));
+                            acc[r][1] = _mm_add_ps(acc[r][1], _mm_mul_ps(in1, g));
+                        }
+                    }
+                    for (unsigned int r = 0; r < R; ++r)
+                    {
+                        _mm_storeu_ps(ppOut[r] + i, acc[r][0]);
+                        _mm_storeu_ps(ppOut[r] + i + 4, acc[r][1]);
+                    }
+                }
+#elif defined(SPAUDIO_USE_NEON)
+                for (; i + 8 <= iEnd; i += 8)
+                {
+                    float32x4_t acc[R][2];
+                    for (unsigned int r = 0; r < R; ++r)
+                        acc[r][0] = acc[r][1] = vdupq_n_f32(0.f);
+                    for (unsigned int c = 0; c < nCols; ++c)
+                    {
+                        float32x4_t in0 = vld1q_f32(ppIn[c] + i);
+                        float32x4_t in1 = vld1q_f32(ppIn[c] + i + 4);
+                        for (unsigned int r = 0; r < R; ++r)
+                        {
+                            acc[r][0] = vmlaq_n_f32(acc[r][0], in0, pMatrix[r * nCols + c]);
+                            acc[r][1] = vmlaq_n_f32(acc[r][1], in1, pMatrix[r * nCols + c]);
+                        }
+                    }
+                    for (unsigned int r = 0; r < R; ++r)
+                    {
+                        vst1q_f32(ppOut[r] + i, acc[r][0]);
+                        vst1q_f32(ppOut[r] + i + 4, acc[r][1]);
+                    }
+                }
+#endif
+                for (; i < iEnd; ++i)
+                    for (unsigned int r = 0; r < R; ++r)
+                    {
+                        float acc = 0.f;
+                        for (unsigned int c = 0; c < nCols; ++c)
+                            acc += ppIn[c][i] * pMatrix[r * nCols + c];
+                        ppOut[r][i] = acc;
+                    }
+            }
+        }
+
+        void ComplexMultiplyAccumulate(const float* pARe, const float* pAIm, const float* pBRe, const float* pBIm,
+            float* pAccRe, float* pAccIm, unsigned int n)
+        {
+            unsigned int i = 0;
+#if defined(SPAUDIO_USE_SSE)
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 aRe = _mm_loadu_ps(pARe + i);
+                __m128 aIm = _mm_loadu_ps(pAIm + i);
+                __m128 bRe = _mm_loadu_ps(pBRe + i);
+                __m128 bIm = _mm_loadu_ps(pBIm + i);
+                __m128 accRe = _mm_loadu_ps(pAccRe + i);
+                __m128 accIm = _mm_loadu_ps(pAccIm + i);
+                accRe = _mm_add_ps(accRe, _mm_sub_ps(_mm_mul_ps(aRe, bRe), _mm_mul_ps(aIm, bIm)));
+                accIm = _mm_add_ps(accIm, _mm_add_ps(_mm_mul_ps(aRe, bIm), _mm_mul_ps(aIm, bRe)));
+                _mm_storeu_ps(pAccRe + i, accRe);
+                _mm_storeu_ps(pAccIm + i, accIm);
+            }
+#elif defined(SPAUDIO_USE_NEON)
+            for (; i + 4 <= n; i += 4)
+            {
+                float32x4_t aRe = vld1q_f32(pARe + i);
+                float32x4_t aIm = vld1q_f32(pAIm + i);
+                float32x4_t bRe = vld1q_f32(pBRe + i);
+                float32x4_t bIm = vld1q_f32(pBIm + i);
+                float32x4_t accRe = vld1q_f32(pAccRe + i);
+                float32x4_t accIm = vld1q_f32(pAccIm + i);
+                accRe = vmlaq_f32(accRe, aRe, bRe);
+                accRe = vmlsq_f32(accRe, aIm, bIm);
+                accIm = vmlaq_f32(accIm, aRe, bIm);
+                accIm = vmlaq_f32(accIm, aIm, bRe);
+                vst1q_f32(pAccRe + i, accRe);
+                vst1q_f32(pAccIm + i, accIm);
+            }
+#endif
+            for (; i < n; ++i)
+            {
+                pAccRe[i] += pARe[i] * pBRe[i] - pAIm[i] * pBIm[i];
+                pAccIm[i] += pARe[i] * pBIm[i] + pAIm[i] * pBRe[i];
+            }
+        }
+
+        void Deinterleave(const float* pIn, float* pRe, float* pIm, unsigned int n)
+        {
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                pRe[i] = pIn[2 * i];
+                pIm[i] = pIn[2 * i + 1];
+            }
+        }
+
+        void Interleave(const float* pRe, const float* pIm, float* pOut, unsigned int n)
+        {
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                pOut[2 * i] = pRe[i];
+                pOut[2 * i + 1] = pIm[i];
+            }
+        }
+
+        void Multiply(const float* pIn, float gain, float* pOut, unsigned int n)
+        {
+            unsigned int i = 0;
+#if defined(SPAUDIO_USE_SSE)
+            __m128 g = _mm_set1_ps(gain);
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(pOut + i, _mm_mul_ps(_mm_loadu_ps(pIn + i), g));
+#elif defined(SPAUDIO_USE_NEON)
+            float32x4_t g = vdupq_n_f32(gain);
+            for (; i + 4 <= n; i += 4)
+                vst1q_f32(pOut + i, vmulq_f32(vld1q_f32(pIn + i), g));
+#endif
+            for (; i < n; ++i)
+                pOut[i] = pIn[i] * gain;
+        }
+
+        void MultiplyRamp(const float* pIn, float gainStart, float gainStep, float* pOut, unsigned int n)
+        {
+            // The gain is calculated from the sample index rather than accumulated to avoid drift
+            unsigned int i = 0;
+#if defined(SPAUDIO_USE_SSE)
+            __m128 g0 = _mm_set1_ps(gainStart);
+            __m128 step = _mm_set1_ps(gainStep);
+            __m128 index = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+            const __m128 four = _mm_set1_ps(4.f);
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 g = _mm_add_ps(g0, _mm_mul_ps(index, step));
+                _mm_storeu_ps(pOut + i, _mm_mul_ps(_mm_loadu_ps(pIn + i), g));
+                index = _mm_add_ps(index, four);
+            }
+#elif defined(SPAUDIO_USE_NEON)
+            float32x4_t g0 = vdupq_n_f32(gainStart);
+            float32x4_t step = vdupq_n_f32(gainStep);
+            const float indexInit[4] = { 0.f, 1.f, 2.f, 3.f };
+            float32x4_t index = vld1q_f32(indexInit);
+            const float32x4_t four = vdupq_n_f32(4.f);
+            for (; i + 4 <= n; i += 4)
+            {
+                float32x4_t g = vmlaq_f32(g0, index, step);
+                vst1q_f32(pOut + i, vmulq_f32(vld1q_f32(pIn + i), g));
+                index = vaddq_f32(index, four);
+            }
+#endif
+            for (; i < n; ++i)
+                pOut[i] = pIn[i] * (gainStart + (float)i * gainStep);
+        }
+
+        void MultiplyAccumulate(const float* pIn, float gain, float* pOut, unsigned int n)
+        {
+            unsigned int i = 0;
+#if defined(SPAUDIO_USE_SSE)
+            __m128 g = _mm_set1_ps(gain);
+            for (; i + 4 <= n; i += 4)
+                _mm_storeu_ps(pOut + i, _mm_add_ps(_mm_loadu_ps(pOut + i), _mm_mul_ps(_mm_loadu_ps(pIn + i), g)));
+#elif defined(SPAUDIO_USE_NEON)
+            float32x4_t g = vdupq_n_f32(gain);
+            for (; i + 4 <= n; i += 4)
+                vst1q_f32(pOut + i, vmlaq_f32(vld1q_f32(pOut + i), vld1q_f32(pIn + i), g));
+#endif
+            for (; i < n; ++i)
+                pOut[i] += pIn[i] * gain;
+        }
+
+        void MultiplyAccumulateRamp(const float* pIn, float gainStart, float gainStep, float* pOut, unsigned int n)
+        {
+            // The gain is calculated from the sample index rather than accumulated to avoid drift
+            unsigned int i = 0;
+#if defined(SPAUDIO_USE_SSE)
+            __m128 g0 = _mm_set1_ps(gainStart);
+            __m128 step = _mm_set1_ps(gainStep);
+            __m128 index = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+            const __m128 four = _mm_set1_ps(4.f);
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 g = _mm_add_ps(g0, _mm_mul_ps(index, step));
+                _mm_storeu_ps(pOut + i, _mm_add_ps(_mm_loadu_ps(pOut + i), _mm_mul_ps(_mm_loadu_ps(pIn + i), g)));
+                index = _mm_add_ps(index, four);
+            }
+#elif defined(SPAUDIO_USE_NEON)
+            float32x4_t g0 = vdupq_n_f32(gainStart);
+            float32x4_t step = vdupq_n_f32(gainStep);
+            const float indexInit[4] = { 0.f, 1.f, 2.f, 3.f };
+            float32x4_t index = vld1q_f32(indexInit);
+            const float32x4_t four = vdupq_n_f32(4.f);
+            for (; i + 4 <= n; i += 4)
+            {
+                float32x4_t g = vmlaq_f32(g0, index, step);
+                vst1q_f32(pOut + i, vmlaq_f32(vld1q_f32(pOut + i), vld1q_f32(pIn + i), g));
+                index = vaddq_f32(index, four);
+            }
+#endif
+            for (; i < n; ++i)
+                pOut[i] += pIn[i] * (gainStart + (float)i * gainStep);
+        }
+
+        void MatrixMultiply(const float* pMatrix, unsigned int nRows, unsigned int nCols, const float* const* ppIn, float* const* ppOut, unsigned int n)
+        {
+            // The input is processed in tiles that stay in the cache while all of the rows are calculated
+            const unsigned int nTile = 256;
+            for (unsigned int iStart = 0; iStart < n; iStart += nTile)
+            {
+                unsigned int iEnd = iStart + nTile < n ? iStart + nTile : n;
+                // Four rows of eight samples keep the accumulators in registers
+                unsigned int r = 0;
+                for (; r + 4 <= nRows; r += 4)
+                    matrixMultiplyRows<4>(pMatrix + r * nCols, nCols, ppIn, ppOut + r, iStart, iEnd);
+                for (; r < nRows; ++r)
+                    matrixMultiplyRows<1>(pMatrix + r * nCols, nCols, ppIn, ppOut + r, iStart, iEnd);
+            }
+        }
+
+    } // namespace simd
+} // namespace spaudio
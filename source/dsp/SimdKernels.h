@@ -0,0 +1,96 @@
+/*############################################################################*/
+/*#                                                                          #*/
+/*#  Vectorised inner loops shared by the processing classes                 #*/
+/*#                                                                          #*/
+/*#                                                                          #*/
+/*#  Filename:      SimdKernels.h                                            #*/
+/*#  Version:       0.1                                                      #*/
+/*#  Date:          16/10/2026                                               #*/
+/*#  Author(s):     Peter Stitt                                              #*/
+/*#  Licence:       LGPL + proprietary                                       #*/
+/*#                                                                          #*/
+/*############################################################################*/
+
+#pragma once
+
+namespace spaudio {
+    namespace simd {
+
+        /** Multiply two complex spectra stored in split (separate real and imaginary) format and add the result
+         *  to the accumulator.
+         * @param pARe      Real part of the first spectrum.
+         * @param pAIm      Imaginary part of the first spectrum.
+         * @param pBRe      Real part of the second spectrum.
+         * @param pBIm      Imaginary part of the second spectrum.
+         * @param pAccRe    Real part of the accumulator.
+         * @param pAccIm    Imaginary part of the accumulator.
+         * @param n         The number of bins.
+         */
+        void ComplexMultiplyAccumulate(const float* pARe, const float* pAIm, const float* pBRe, const float* pBIm,
+            float* pAccRe, float* pAccIm, unsigned int n);
+
+        /** Convert an interleaved complex spectrum to split format.
+         * @param pIn   Interleaved spectrum of size 2 x n.
+         * @param pRe   Output real part of size n.
+         * @param pIm   Output imaginary part of size n.
+         * @param n     The number of bins.
+         */
+        void Deinterleave(const float* pIn, float* pRe, float* pIm, unsigned int n);
+
+        /** Convert a complex spectrum in split format to interleaved format.
+         * @param pRe   Real part of size n.
+         * @param pIm   Imaginary part of size n.
+         * @param pOut  Output interleaved spectrum of size 2 x n.
+         * @param n     The number of bins.
+         */
+        void Interleave(const float* pRe, const float* pIm, float* pOut, unsigned int n);
+
+        /** Multiply a signal by a gain.
+         * @param pIn   Input signal.
+         * @param gain  Gain to apply to the input.
+         * @param pOut  Output to which the scaled input is written.
+         * @param n     The number of samples.
+         */
+        void Multiply(const float* pIn, float gain, float* pOut, unsigned int n);
+
+        /** Multiply a signal by a linear gain ramp. Sample i is multiplied by gainStart + i * gainStep.
+         * @param pIn       Input signal.
+         * @param gainStart Gain applied to the first sample.
+         * @param gainStep  Change in gain per sample.
+         * @param pOut      Output to which the scaled input is written.
+         * @param n         The number of samples.
+         */
+        void MultiplyRamp(const float* pIn, float gainStart, float gainStep, float* pOut, unsigned int n);
+
+        /** Multiply a signal by a gain and add it to the output.
+         * @param pIn   Input signal.
+         * @param gain  Gain to apply to the input.
+         * @param pOut  Output to which the scaled input is added.
+         * @param n     The number of samples.
+         */
+        void MultiplyAccumulate(const float* pIn, float gain, float* pOut, unsigned int n);
+
+        /** Multiply a signal by a linear gain ramp and add it to the output. Sample i is multiplied by
+         *  gainStart + i * gainStep.
+         * @param pIn       Input signal.
+         * @param gainStart Gain applied to the first sample.
+         * @param gainStep  Change in gain per sample.
+         * @param pOut      Output to which the scaled input is added.
+         * @param n         The number of samples.
+         */
+        void MultiplyAccumulateRamp(const float* pIn, float gainStart, float gainStep, float* pOut, unsigned int n);
+
+        /** Multiply a block of a multichannel signal by a matrix. Output channel r is the sum over the input channels c of
+         *  pMatrix[r * nCols + c] * ppIn[c]. Groups of output channels are calculated together over short runs of samples
+         *  so that each input sample is loaded once per group and each output sample is only written once.
+         * @param pMatrix   Row-major matrix of size nRows x nCols.
+         * @param nRows     The number of output channels.
+         * @param nCols     The number of input channels.
+         * @param ppIn      The input signals.
+         * @param ppOut     The output signals. These are overwritten.
+         * @param n         The number of samples.
+         */
+        void MatrixMultiply(const float* pMatrix, unsigned int nRows, unsigned int nCols, const float* const* ppIn, float* const* ppOut, unsigned int n);
+
+    } // namespace simd
+} // namespace spaudio
@@ -0,0 +1,61 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include <AllocentricExtent.h>
+
+using namespace spaudio;
+
+struct ExtentCase
+{
+	const char* layout;
+	CartesianPosition<double> position;
+	double sizeX, sizeY, sizeZ;
+	// Bit i is set if loudspeaker i is excluded
+	unsigned int excludedMask;
+	// Gains calculated by evaluating the weights at every point of the grid
+	std::vector<double> expectedGains;
+};
+
+int main()
+{
+	const ExtentCase cases[] = {
+		{ "4+5+0", { 0.2, 0.5, 0.3 }, 0.4, 0.2, 0.1, 0,
+			{ 0.0049613894267271893, 0.47489906397918175, 0.87956041703356402, 0.0023544867752214277, 0.011706147790693087, 0.0051307382517290622, 0.025509245106883134, 6.6245875969376571e-05, 0.00032936435353242335 } },
+		{ "4+5+0", { -0.8, -0.3, 0.9 }, 1.0, 0.6, 0.3, 0,
+			{ 0.0098535543334300809, 0.0078225534100526198, 0.002821708907455452, 0.020838644426711579, 0.017723618105872162, 0.42009479244457515, 0.37554011158866302, 0.61435444848356091, 0.55149250123738258 } },
+		{ "4+5+0", { 0.1, 0.9, 0.0 }, 0.1, 0.1, 0.1, 0x3,
+			{ 0, 0, 0.99947137758566507, 0.022988751456007168, 0.022988751456007168, 1.0576672020619153e-08, 1.0576672020619153e-08, 1.0577510023029712e-08, 1.0577510023029712e-08 } },
+		{ "9+10+3", { 0.4, -0.6, -0.5 }, 0.7, 0.3, 0.5, 0,
+			{ 8.2002298932935023e-08, 2.6060512617711989e-07, 4.0165375597376611e-27, 0.11625287756958091, 0.36998760536569097, 1.0034070736632479e-27, 2.2032567215712558e-27, 0.26519783641590577, 0.047820627503845484, 0.15197501566024268, 1.0459351857724306e-15, 4.1514871498436159e-15, 9.5070687474361665e-16, 1.759795762271523e-08, 6.5739831463447381e-08, 2.0922426462731633e-07, 1.9360671058883174e-08, 7.6845657557590234e-08, 1.4996670564148153e-07, 0.42215853781499635, 0.21588048752041866, 0.72736449882488952 } },
+		{ "9+10+3", { 0., 0., 0. }, 1., 1., 1., 0x8,
+			{ 0.2235664988034648, 0.2235664988033956, 0.17147433946751126, 0, 0.15678639286704846, 0.10464825944859872, 0.10464825944861413, 0.25226143156042097, 0.31666386866725538, 0.31666386866715734, 0.081989523116958521, 0.08198952311697065, 0.13481436232874727, 0.21551880630751408, 0.081989523116958465, 0.081989523116970581, 0.13481436232873079, 0.13481436232875016, 0.13481436232874716, 0.4851475309649394, 0.29879340856260461, 0.29879340856264813 } },
+		{ "0+5+0", { 0.6, 0.2, 0. }, 0.3, 0.8, 0., 0,
+			{ 6.005859479406735e-39, 0.7272013315826622, 0.034706533729106016, 0.0011994941385754883, 0.68554521446417016 } },
+	};
+
+	for (auto& c : cases)
+	{
+		Layout layout = Layout::getMatchingLayout(c.layout);
+		adm::AllocentricExtent extent(layout);
+		unsigned int nLdspk = extent.getNumChannels();
+		assert(nLdspk == c.expectedGains.size());
+
+		std::vector<bool> excluded(nLdspk, false);
+		for (unsigned int i = 0; i < nLdspk; ++i)
+			excluded[i] = ((c.excludedMask >> i) & 1) != 0;
+
+		// The separable evaluation sums in a different order so allow for rounding.
+		// Call twice to check the cached grid gains give the same result
+		std::vector<double> gains(nLdspk);
+		for (int iCall = 0; iCall < 2; ++iCall)
+		{
+			extent.handle(c.position, c.sizeX, c.sizeY, c.sizeZ, excluded, gains);
+			for (unsigned int i = 0; i < nLdspk; ++i)
+				assert(std::abs(gains[i] - c.expectedGains[i]) < 1e-9);
+		}
+	}
+
+	return 0;
+}
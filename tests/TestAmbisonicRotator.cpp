@@ -0,0 +1,114 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <AmbisonicRotator.h>
+
+using namespace spaudio;
+
+static const unsigned int nOrder = 3;
+static const unsigned int nBlockSize = 480;
+static const unsigned int nSampleRate = 48000;
+
+// The head orientation for a rotation about z by yaw, then about y by pitch and then about x by roll
+static RotationQuaternion yawPitchRollToQuaternion(float yaw, float pitch, float roll)
+{
+	double cy = std::cos(0.5 * yaw), sy = std::sin(0.5 * yaw);
+	double cp = std::cos(0.5 * pitch), sp = std::sin(0.5 * pitch);
+	double cr = std::cos(0.5 * roll), sr = std::sin(0.5 * roll);
+	return RotationQuaternion{ (float)(cy * cp * cr + sy * sp * sr), (float)(cy * cp * sr - sy * sp * cr),
+		(float)(cy * sp * cr + sy * cp * sr), (float)(sy * cp * cr - cy * sp * sr) };
+}
+
+int main()
+{
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+	// A fixed tracker orientation must give the same rotation as SetOrientation() once the first update is done
+	{
+		const unsigned int nInterval = 32;
+		RotationOrientation orientation;
+		orientation.yaw = 0.7f;
+		orientation.pitch = -0.3f;
+		orientation.roll = 1.1f;
+
+		AmbisonicRotator rotator, trackerRotator;
+		rotator.Configure(nOrder, true, nBlockSize, nSampleRate, 0.f);
+		rotator.SetOrientation(orientation);
+		trackerRotator.Configure(nOrder, true, nBlockSize, nSampleRate, 0.f);
+		trackerRotator.SetTrackerUpdateInterval(nInterval);
+		assert(trackerRotator.GetTrackerUpdateInterval() == nInterval);
+		trackerRotator.AddTrackerOrientation(yawPitchRollToQuaternion(orientation.yaw, orientation.pitch, orientation.roll));
+
+		BFormat bf, trackerBf;
+		bf.Configure(nOrder, true, nBlockSize);
+		trackerBf.Configure(nOrder, true, nBlockSize);
+		std::vector<float> in(nBlockSize), out(nBlockSize), trackerOut(nBlockSize);
+		for (unsigned int iCh = 0; iCh < bf.GetChannelCount(); ++iCh)
+		{
+			for (auto& s : in)
+				s = dist(rng);
+			bf.InsertStream(in.data(), iCh, nBlockSize);
+			trackerBf.InsertStream(in.data(), iCh, nBlockSize);
+		}
+		rotator.Process(&bf, nBlockSize);
+		trackerRotator.Process(&trackerBf, nBlockSize);
+		for (unsigned int iCh = 0; iCh < bf.GetChannelCount(); ++iCh)
+		{
+			bf.ExtractStream(out.data(), iCh, nBlockSize);
+			trackerBf.ExtractStream(trackerOut.data(), iCh, nBlockSize);
+			for (unsigned int i = nInterval; i < nBlockSize; ++i)
+				assert(std::abs(out[i] - trackerOut[i]) < 1e-5f);
+		}
+	}
+
+	// A fast turn from a 1 kHz tracker must be interpolated along the rotation so the level does not dip
+	{
+		const unsigned int nInterval = 16;
+		const unsigned int nTrackerPeriod = nSampleRate / 1000;
+		const unsigned int nTurnSamples = 2 * nBlockSize;
+		AmbisonicRotator trackerRotator;
+		trackerRotator.Configure(1, true, nBlockSize, nSampleRate, 0.f);
+		trackerRotator.SetTrackerUpdateInterval(nInterval);
+
+		BFormat bf;
+		bf.Configure(1, true, nBlockSize);
+		std::vector<float> y(nBlockSize), z(nBlockSize), x(nBlockSize, 1.f), zeros(nBlockSize, 0.f);
+		for (unsigned int iBlock = 0; iBlock < 3; ++iBlock)
+		{
+			// Turn half way round during the first two blocks
+			for (unsigned int iSamp = 0; iSamp < nBlockSize; iSamp += nTrackerPeriod)
+			{
+				float t = std::min(1.f, (float)(iBlock * nBlockSize + iSamp) / (float)nTurnSamples);
+				trackerRotator.AddTrackerOrientation(yawPitchRollToQuaternion((float)M_PI * t, 0.f, 0.f), iSamp);
+			}
+
+			// A plane wave from the front
+			bf.InsertStream(zeros.data(), 0, nBlockSize);
+			bf.InsertStream(zeros.data(), 1, nBlockSize);
+			bf.InsertStream(zeros.data(), 2, nBlockSize);
+			bf.InsertStream(x.data(), 3, nBlockSize);
+			trackerRotator.Process(&bf, nBlockSize);
+
+			std::vector<float> outY(nBlockSize), outZ(nBlockSize), outX(nBlockSize);
+			bf.ExtractStream(outY.data(), 1, nBlockSize);
+			bf.ExtractStream(outZ.data(), 2, nBlockSize);
+			bf.ExtractStream(outX.data(), 3, nBlockSize);
+			for (unsigned int i = 0; i < nBlockSize; ++i)
+			{
+				float level = std::sqrt(outY[i] * outY[i] + outZ[i] * outZ[i] + outX[i] * outX[i]);
+				assert(std::abs(level - 1.f) < 1e-2f);
+			}
+			// The turn is finished by the last block so the wave comes from behind after the first update.
+			// The previous block held the last orientation it received until then
+			if (iBlock == 2)
+				for (unsigned int i = nInterval; i < nBlockSize; ++i)
+					assert(std::abs(outX[i] + 1.f) < 1e-5f && std::abs(outY[i]) < 1e-5f);
+		}
+	}
+
+	return 0;
+}
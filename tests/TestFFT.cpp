@@ -0,0 +1,72 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <dsp/FFT.h>
+
+using namespace spaudio;
+
+// Check the forward transform against a direct DFT and that the inverse recovers the signal.
+static void testBackend(FFTBackend backend, unsigned int nSize)
+{
+	FFT fft;
+	assert(fft.Configure(nSize, backend));
+	assert(fft.GetBackend() == backend);
+	assert(fft.GetSize() == nSize);
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	std::vector<float> signal(nSize);
+	for (auto& s : signal)
+		s = dist(rng);
+
+	std::vector<float> spectrum(nSize + 2);
+	fft.Forward(signal.data(), spectrum.data());
+	for (unsigned int k = 0; k <= nSize / 2; ++k)
+	{
+		double re = 0., im = 0.;
+		for (unsigned int n = 0; n < nSize; ++n)
+		{
+			double phase = -2. * M_PI * (double)k * (double)n / (double)nSize;
+			re += signal[n] * cos(phase);
+			im += signal[n] * sin(phase);
+		}
+		assert(std::abs(spectrum[2 * k] - re) < 1e-3);
+		assert(std::abs(spectrum[2 * k + 1] - im) < 1e-3);
+	}
+
+	const std::vector<float> spectrumCopy = spectrum;
+	std::vector<float> output(nSize);
+	fft.Inverse(spectrum.data(), output.data());
+	assert(spectrum == spectrumCopy);
+	for (unsigned int n = 0; n < nSize; ++n)
+		assert(std::abs(output[n] / (float)nSize - signal[n]) < 1e-5);
+}
+
+int main()
+{
+	assert(FFT::IsBackendAvailable(FFTBackend::KissFFT));
+	assert(FFT::IsBackendAvailable(FFT::GetDefaultBackend()));
+
+	for (auto backend : { FFTBackend::KissFFT, FFTBackend::FFTW })
+	{
+		if (!FFT::IsBackendAvailable(backend))
+		{
+			FFT fft;
+			assert(!fft.Configure(64, backend));
+			assert(!FFT::SetDefaultBackend(backend));
+			continue;
+		}
+		testBackend(backend, 64);
+		testBackend(backend, 1024);
+		testBackend(backend, 96);
+	}
+
+	// Odd sizes are not supported
+	FFT fft;
+	assert(!fft.Configure(63));
+
+	return 0;
+}
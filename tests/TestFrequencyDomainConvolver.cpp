@@ -0,0 +1,133 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <dsp/FrequencyDomainConvolver.h>
+
+using namespace spaudio;
+
+// Check the partitioned convolution matches direct time-domain convolution for blocks of varying length.
+static void testConvolution(unsigned int nTaps, unsigned int nPartitionSize, const std::vector<unsigned int>& blockSizes)
+{
+	const unsigned int nInputs = 3;
+	const unsigned int nOutputs = 2;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+	// Output 1 has no filter from input 1
+	std::vector<std::vector<float>> filters(nInputs * nOutputs, std::vector<float>(nTaps));
+	for (auto& filter : filters)
+		for (auto& tap : filter)
+			tap = dist(rng);
+	std::fill(filters[1 * nOutputs + 1].begin(), filters[1 * nOutputs + 1].end(), 0.f);
+
+	FrequencyDomainConvolver convolver;
+	assert(convolver.Configure(nInputs, nOutputs, nTaps, nPartitionSize));
+	for (unsigned int iIn = 0; iIn < nInputs; ++iIn)
+		for (unsigned int iOut = 0; iOut < nOutputs; ++iOut)
+			if (!(iIn == 1 && iOut == 1))
+				convolver.SetFilter(iIn, iOut, filters[iIn * nOutputs + iOut].data(), nTaps);
+
+	unsigned int nTotal = 0;
+	for (auto n : blockSizes)
+		nTotal += n;
+	std::vector<std::vector<float>> input(nInputs, std::vector<float>(nTotal));
+	for (auto& ch : input)
+		for (auto& s : ch)
+			s = dist(rng);
+
+	// Process in-place to check that the inputs and outputs can share buffers
+	std::vector<std::vector<float>> output = input;
+	output.resize(nOutputs);
+	unsigned int nPos = 0;
+	for (auto n : blockSizes)
+	{
+		const float* ppIn[nInputs];
+		float* ppOut[nOutputs];
+		std::vector<std::vector<float>> block(nInputs, std::vector<float>(n));
+		for (unsigned int iIn = 0; iIn < nInputs; ++iIn)
+		{
+			std::copy(input[iIn].begin() + nPos, input[iIn].begin() + nPos + n, block[iIn].begin());
+			ppIn[iIn] = block[iIn].data();
+		}
+		for (unsigned int iOut = 0; iOut < nOutputs; ++iOut)
+			ppOut[iOut] = block[iOut].data();
+		convolver.Process(ppIn, ppOut, n);
+		for (unsigned int iOut = 0; iOut < nOutputs; ++iOut)
+			std::copy(block[iOut].begin(), block[iOut].end(), output[iOut].begin() + nPos);
+		nPos += n;
+	}
+
+	for (unsigned int iOut = 0; iOut < nOutputs; ++iOut)
+		for (unsigned int i = 0; i < nTotal; ++i)
+		{
+			double ref = 0.;
+			for (unsigned int iIn = 0; iIn < nInputs; ++iIn)
+				for (unsigned int j = 0; j < nTaps && j <= i; ++j)
+					ref += (double)filters[iIn * nOutputs + iOut][j] * input[iIn][i - j];
+			assert(std::abs(ref - output[iOut][i]) < 1e-3);
+		}
+}
+
+// Process a single block with one input and one output
+static std::vector<float> processBlock(FrequencyDomainConvolver& convolver, const std::vector<float>& input)
+{
+	std::vector<float> output(input.size());
+	const float* pIn = input.data();
+	float* pOut = output.data();
+	convolver.Reset();
+	convolver.Process(&pIn, &pOut, (unsigned int)input.size());
+	return output;
+}
+
+// Check that convolvers sharing filters give the same output and that changing the filters of one does not affect the other.
+static void testSharedFilters()
+{
+	const unsigned int nTaps = 200;
+	const unsigned int nPartitionSize = 64;
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	std::vector<float> filter(nTaps), input(nPartitionSize);
+	for (auto& tap : filter)
+		tap = dist(rng);
+	for (auto& s : input)
+		s = dist(rng);
+
+	FrequencyDomainConvolver convolver, sharedConvolver, otherConvolver;
+	assert(convolver.Configure(1, 1, nTaps, nPartitionSize));
+	assert(sharedConvolver.Configure(1, 1, nTaps, nPartitionSize));
+	assert(otherConvolver.Configure(1, 1, nTaps, 2 * nPartitionSize));
+	convolver.SetFilter(0, 0, filter.data(), nTaps);
+	std::vector<float> reference = processBlock(convolver, input);
+
+	auto filters = convolver.GetFilters();
+	assert(filters && filters->nMaxTaps == nTaps);
+	assert(!otherConvolver.SetFilters(filters));
+	assert(sharedConvolver.SetFilters(filters));
+	assert(processBlock(sharedConvolver, input) == reference);
+
+	// Clearing the filters of one convolver must not affect the one it shares them with
+	sharedConvolver.ClearFilters();
+	for (auto s : processBlock(sharedConvolver, input))
+		assert(s == 0.f);
+	assert(processBlock(convolver, input) == reference);
+	assert(convolver.GetFilters() == filters);
+}
+
+int main()
+{
+	// Single partition
+	testConvolution(100, 128, { 128, 128, 128, 128 });
+	// Multiple partitions with full blocks
+	testConvolution(300, 32, { 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32, 32 });
+	// Blocks shorter than, longer than and not aligned with the partitions
+	testConvolution(257, 64, { 64, 17, 47, 64, 100, 3, 61, 128, 1, 64, 90 });
+	// Partition size that is not a power of 2
+	testConvolution(200, 48, { 48, 48, 20, 48, 48, 48, 48, 48 });
+
+	testSharedFilters();
+}
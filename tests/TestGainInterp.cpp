@@ -0,0 +1,74 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <GainInterp.h>
+
+using namespace spaudio;
+
+// Check the interpolated gains against a double-precision reference, including a new target set part way
+// through an interpolation and blocks that are not aligned with the interpolation
+static void testInterpolation(bool bAccumulate)
+{
+	const unsigned int nCh = 5;
+	const std::vector<unsigned int> blockSizes = { 1, 64, 13, 100, 256, 7, 300, 512, 33 };
+	const double gain = bAccumulate ? 0.5 : 1.;
+
+	std::mt19937 rng(4);
+	std::uniform_real_distribution<double> dist(-1., 1.);
+
+	GainInterp<double> gainInterp(nCh);
+	std::vector<double> gains(nCh), refStart(nCh), refTarget(nCh);
+	for (auto& g : gains)
+		g = dist(rng);
+	gainInterp.SetGainVector(gains, 0);
+	refStart = refTarget = gains;
+	unsigned int nRefDur = 0, iRefCount = 0;
+
+	for (unsigned int iBlock = 0; iBlock < blockSizes.size(); ++iBlock)
+	{
+		// Set new targets with different interpolation times, sometimes before the previous one is complete
+		if (iBlock % 2 == 1)
+		{
+			for (unsigned int iCh = 0; iCh < nCh; ++iCh)
+			{
+				double current = iRefCount < nRefDur ? refStart[iCh] + (refTarget[iCh] - refStart[iCh]) * iRefCount / nRefDur : refTarget[iCh];
+				refStart[iCh] = current;
+				gains[iCh] = dist(rng);
+			}
+			refTarget = gains;
+			nRefDur = 200 + 150 * iBlock;
+			iRefCount = 0;
+			gainInterp.SetGainVector(gains, nRefDur);
+		}
+
+		unsigned int nSamples = blockSizes[iBlock];
+		std::vector<float> in(nSamples, 1.f);
+		std::vector<std::vector<float>> out(nCh, std::vector<float>(nSamples, bAccumulate ? 1.f : 0.f));
+		std::vector<float*> pOut(nCh);
+		for (unsigned int iCh = 0; iCh < nCh; ++iCh)
+			pOut[iCh] = out[iCh].data();
+		if (bAccumulate)
+			gainInterp.ProcessAccumul(in.data(), pOut.data(), nSamples, 0, gain);
+		else
+			gainInterp.Process(in.data(), pOut.data(), nSamples, 0);
+
+		for (unsigned int i = 0; i < nSamples; ++i, ++iRefCount)
+			for (unsigned int iCh = 0; iCh < nCh; ++iCh)
+			{
+				double ref = iRefCount < nRefDur ? refStart[iCh] + (refTarget[iCh] - refStart[iCh]) * iRefCount / nRefDur : refTarget[iCh];
+				double applied = bAccumulate ? (out[iCh][i] - 1.) / gain : out[iCh][i];
+				assert(std::abs(applied - ref) <= 1e-6);
+			}
+	}
+}
+
+int main()
+{
+	testInterpolation(false);
+	testInterpolation(true);
+
+	return 0;
+}
@@ -0,0 +1,366 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Renderer.h>
+
+using namespace spaudio;
+
+static const unsigned int nObjects = 24;
+static const unsigned int nDirectSpeakers = 2;
+static const unsigned int nHoaOrder = 1;
+static const unsigned int nHoaChannels = (nHoaOrder + 1) * (nHoaOrder + 1);
+static const unsigned int nBlockSize = 256;
+static const unsigned int nFrames = 8;
+
+// Options for the scene rendering
+struct SceneOptions
+{
+	// Number of workers
+	unsigned int nWorkers = 0;
+	// Add the Objects with AddObjects() instead of AddObject()
+	bool bBatch = false;
+	// Number of frames of latency of the Object gains
+	unsigned int nGainLatency = 0;
+	// Number of frames by which the Object metadata is delayed. The Objects are not added until it is available
+	unsigned int nMetadataDelay = 0;
+	// Object gain cache settings
+	adm::ObjectGainCacheSettings cacheSettings;
+	// Extent gain cache settings
+	adm::ExtentGainCacheSettings extentCacheSettings;
+	// Directory in which to cache the data calculated by Configure(). Empty if disabled
+	std::string configCacheDirectory;
+	// Switch between rendering on the calling thread and nWorkers workers after the Objects are added in each frame
+	bool bChangeWorkers = false;
+};
+
+// Render a scene of moving Objects, DirectSpeakers and an HOA stream
+static std::vector<float> renderScene(const SceneOptions& options, adm::ObjectGainCacheStatistics* pCacheStatistics = nullptr,
+	std::string* pConfigCachePath = nullptr, adm::ExtentGainCacheStatistics* pExtentCacheStatistics = nullptr,
+	adm::DirectSpeakerGainCacheStatistics* pDirectSpeakerCacheStatistics = nullptr)
+{
+	StreamInformation streamInfo;
+	for (unsigned int i = 0; i < nObjects; ++i)
+		streamInfo.typeDefinition.push_back(TypeDefinition::Objects);
+	for (unsigned int i = 0; i < nDirectSpeakers; ++i)
+		streamInfo.typeDefinition.push_back(TypeDefinition::DirectSpeakers);
+	for (unsigned int i = 0; i < nHoaChannels; ++i)
+		streamInfo.typeDefinition.push_back(TypeDefinition::HOA);
+	streamInfo.nChannels = (unsigned int)streamInfo.typeDefinition.size();
+
+	Renderer renderer;
+	assert(renderer.SetWorkerCount(options.nWorkers));
+	renderer.SetObjectGainLatency(options.nGainLatency);
+	renderer.SetObjectGainCache(options.cacheSettings);
+	renderer.SetExtentGainCache(options.extentCacheSettings);
+	renderer.SetConfigCacheDirectory(options.configCacheDirectory);
+	assert(renderer.Configure(OutputLayout::FivePointOnePointFour, nHoaOrder, 48000, nBlockSize, streamInfo));
+	assert(renderer.GetWorkerCount() == (options.nWorkers > 1 ? options.nWorkers : 0));
+	const unsigned int nOut = renderer.GetSpeakerCount();
+
+	std::mt19937 rng(2);
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	std::vector<float> in(nBlockSize);
+	std::vector<std::vector<float>> objIn(nObjects, std::vector<float>(nBlockSize));
+	std::vector<std::vector<float>> hoaIn(nHoaChannels, std::vector<float>(nBlockSize));
+	std::vector<float*> pHoaIn(nHoaChannels);
+	std::vector<std::vector<float>> out(nOut, std::vector<float>(nBlockSize));
+	std::vector<float*> pOut(nOut);
+	for (unsigned int i = 0; i < nOut; ++i)
+		pOut[i] = out[i].data();
+
+	std::vector<float> rendered;
+	for (unsigned int iFrame = 0; iFrame < nFrames; ++iFrame)
+	{
+		std::vector<ObjectMetadata> objMetadata(nObjects);
+		for (unsigned int iObj = 0; iObj < nObjects; ++iObj)
+		{
+			ObjectMetadata& metadata = objMetadata[iObj];
+			metadata.trackInd = iObj;
+			metadata.blockLength = nBlockSize;
+			double frame = (double)iFrame - options.nMetadataDelay;
+			// Some objects jump back and forth between two positions
+			if (iObj % 6 == 5)
+				frame = std::fmod(frame, 2.);
+			metadata.position = PolarPosition<double>{ 15. * iObj + 10. * frame, 5. * (iObj % 4), 1. };
+			metadata.width = (iObj % 3) * 20.;
+			metadata.diffuse = (iObj % 5) * 0.2;
+			for (auto& s : objIn[iObj])
+				s = dist(rng);
+		}
+
+		// With delayed metadata the Objects are silent until their first metadata is available
+		bool bAddObjects = iFrame >= options.nMetadataDelay;
+		if (bAddObjects && options.bBatch)
+		{
+			// Add the objects with one metadata block per frame in one batch and the split ones in two more
+			std::vector<ObjectMetadata> fullMetadata, firstHalfMetadata, secondHalfMetadata;
+			std::vector<float*> pFullIn, pFirstHalfIn, pSecondHalfIn;
+			for (unsigned int iObj = 0; iObj < nObjects; ++iObj)
+			{
+				ObjectMetadata metadata = objMetadata[iObj];
+				if (iObj % 4 == 0)
+				{
+					metadata.blockLength = nBlockSize / 2;
+					firstHalfMetadata.push_back(metadata);
+					pFirstHalfIn.push_back(objIn[iObj].data());
+					metadata.position.polarPosition().azimuth += 5.;
+					secondHalfMetadata.push_back(metadata);
+					pSecondHalfIn.push_back(objIn[iObj].data() + nBlockSize / 2);
+				}
+				else
+				{
+					fullMetadata.push_back(metadata);
+					pFullIn.push_back(objIn[iObj].data());
+				}
+			}
+			renderer.AddObjects(pFullIn.data(), fullMetadata.data(), (unsigned int)fullMetadata.size(), nBlockSize);
+			renderer.AddObjects(pFirstHalfIn.data(), firstHalfMetadata.data(), (unsigned int)firstHalfMetadata.size(), nBlockSize / 2, 0);
+			renderer.AddObjects(pSecondHalfIn.data(), secondHalfMetadata.data(), (unsigned int)secondHalfMetadata.size(), nBlockSize / 2, nBlockSize / 2);
+		}
+		else if (bAddObjects)
+		{
+			for (unsigned int iObj = 0; iObj < nObjects; ++iObj)
+			{
+				ObjectMetadata metadata = objMetadata[iObj];
+				// Use two metadata blocks per frame for some objects
+				if (iObj % 4 == 0)
+				{
+					metadata.blockLength = nBlockSize / 2;
+					renderer.AddObject(objIn[iObj].data(), nBlockSize / 2, metadata, 0);
+					metadata.position.polarPosition().azimuth += 5.;
+					renderer.AddObject(objIn[iObj].data() + nBlockSize / 2, nBlockSize / 2, metadata, nBlockSize / 2);
+				}
+				else
+					renderer.AddObject(objIn[iObj].data(), nBlockSize, metadata);
+			}
+		}
+		// The renderer must not depend on the input buffers after they are added
+		for (auto& objCh : objIn)
+			std::fill(objCh.begin(), objCh.end(), 0.f);
+
+		// The Objects already added must still be rendered
+		if (options.bChangeWorkers)
+			assert(renderer.SetWorkerCount(iFrame % 2 == 0 ? 0 : options.nWorkers));
+
+		const char* labels[nDirectSpeakers] = { "M+030", "M-030" };
+		for (unsigned int iDs = 0; iDs < nDirectSpeakers; ++iDs)
+		{
+			DirectSpeakerMetadata metadata;
+			metadata.trackInd = nObjects + iDs;
+			metadata.speakerLabel = labels[iDs];
+			metadata.polarPosition.azimuth = iDs == 0 ? 30. : -30.;
+			for (auto& s : in)
+				s = dist(rng);
+			renderer.AddDirectSpeaker(in.data(), nBlockSize, metadata);
+		}
+
+		HoaMetadata hoaMetadata;
+		for (unsigned int iCh = 0; iCh < nHoaChannels; ++iCh)
+		{
+			int order = (int)std::sqrt((double)iCh);
+			hoaMetadata.orders.push_back(order);
+			hoaMetadata.degrees.push_back((int)iCh - order * order - order);
+			hoaMetadata.trackInds.push_back(nObjects + nDirectSpeakers + iCh);
+			for (auto& s : hoaIn[iCh])
+				s = dist(rng);
+			pHoaIn[iCh] = hoaIn[iCh].data();
+		}
+		renderer.AddHoa(pHoaIn.data(), nBlockSize, hoaMetadata);
+
+		// Make sure the background gain calculation is finished so the result does not depend on thread timing
+		renderer.WaitForObjectGains();
+		renderer.GetRenderedAudio(pOut.data(), nBlockSize);
+		for (auto& ch : out)
+			rendered.insert(rendered.end(), ch.begin(), ch.end());
+	}
+
+	if (pCacheStatistics)
+		*pCacheStatistics = renderer.GetObjectGainCacheStatistics();
+	if (pConfigCachePath)
+		*pConfigCachePath = renderer.GetConfigCachePath();
+	if (pExtentCacheStatistics)
+		*pExtentCacheStatistics = renderer.GetExtentGainCacheStatistics();
+	if (pDirectSpeakerCacheStatistics)
+		*pDirectSpeakerCacheStatistics = renderer.GetDirectSpeakerGainCacheStatistics();
+
+	return rendered;
+}
+
+static std::vector<float> renderScene(unsigned int nWorkers, bool bBatch = false, unsigned int nGainLatency = 0, unsigned int nMetadataDelay = 0)
+{
+	SceneOptions options;
+	options.nWorkers = nWorkers;
+	options.bBatch = bBatch;
+	options.nGainLatency = nGainLatency;
+	options.nMetadataDelay = nMetadataDelay;
+	return renderScene(options);
+}
+
+int main()
+{
+	std::vector<float> serial = renderScene(0);
+	std::vector<float> parallel = renderScene(4);
+	std::vector<float> parallelRepeat = renderScene(4);
+	std::vector<float> batch = renderScene(0, true);
+	std::vector<float> parallelBatch = renderScene(4, true);
+
+	float peak = 0.f;
+	for (auto s : serial)
+		peak = std::max(peak, std::abs(s));
+	assert(peak > 0.f);
+
+	// The workers sum in a different order to the serial render so allow for rounding
+	assert(serial.size() == parallel.size());
+	for (size_t i = 0; i < serial.size(); ++i)
+		assert(std::abs(serial[i] - parallel[i]) <= 1e-5f * peak);
+
+	// The parallel render must not depend on thread timing
+	assert(parallel == parallelRepeat);
+
+	// Adding the objects in batches mixes them in a different order
+	assert(serial.size() == batch.size() && serial.size() == parallelBatch.size());
+	for (size_t i = 0; i < serial.size(); ++i)
+	{
+		assert(std::abs(serial[i] - batch[i]) <= 1e-5f * peak);
+		assert(std::abs(serial[i] - parallelBatch[i]) <= 1e-5f * peak);
+	}
+
+	// Changing the number of workers part way through a frame must not drop the streams already added
+	SceneOptions changeWorkersOptions;
+	changeWorkersOptions.nWorkers = 4;
+	changeWorkersOptions.bChangeWorkers = true;
+	std::vector<float> changeWorkers = renderScene(changeWorkersOptions);
+	assert(serial.size() == changeWorkers.size());
+	for (size_t i = 0; i < serial.size(); ++i)
+		assert(std::abs(serial[i] - changeWorkers[i]) <= 1e-5f * peak);
+
+	// Calculating the gains in the background must be the same as delaying the metadata by the latency
+	std::vector<float> delayed = renderScene(0, false, 0, 1);
+	std::vector<float> async = renderScene(0, false, 1);
+	std::vector<float> asyncBatch = renderScene(0, true, 1);
+	std::vector<float> asyncParallel = renderScene(4, false, 1);
+	assert(delayed == async);
+	for (size_t i = 0; i < serial.size(); ++i)
+	{
+		assert(std::abs(delayed[i] - asyncBatch[i]) <= 1e-5f * peak);
+		assert(std::abs(delayed[i] - asyncParallel[i]) <= 1e-5f * peak);
+	}
+
+	// Gains still being calculated when the workers are stopped must be applied. The metadata does not change
+	// so the gains are not requested again
+	{
+		StreamInformation streamInfo;
+		streamInfo.typeDefinition.push_back(TypeDefinition::Objects);
+		streamInfo.nChannels = 1;
+		Renderer renderer;
+		assert(renderer.SetWorkerCount(4));
+		renderer.SetObjectGainLatency(1);
+		assert(renderer.Configure(OutputLayout::FivePointOnePointFour, nHoaOrder, 48000, nBlockSize, streamInfo));
+		const unsigned int nOut = renderer.GetSpeakerCount();
+		std::vector<float> in(nBlockSize, 1.f);
+		std::vector<std::vector<float>> out(nOut, std::vector<float>(nBlockSize));
+		std::vector<float*> pOut(nOut);
+		for (unsigned int i = 0; i < nOut; ++i)
+			pOut[i] = out[i].data();
+		ObjectMetadata metadata;
+		metadata.trackInd = 0;
+		metadata.blockLength = nBlockSize;
+		metadata.position = PolarPosition<double>{ 30., 0., 1. };
+		float peakAfterChange = 0.f;
+		for (unsigned int iFrame = 0; iFrame < 3; ++iFrame)
+		{
+			renderer.AddObject(in.data(), nBlockSize, metadata);
+			renderer.WaitForObjectGains();
+			renderer.GetRenderedAudio(pOut.data(), nBlockSize);
+			if (iFrame == 0)
+				assert(renderer.SetWorkerCount(0));
+			else
+				for (auto& ch : out)
+					for (auto s : ch)
+						peakAfterChange = std::max(peakAfterChange, std::abs(s));
+		}
+		assert(peakAfterChange > 0.f);
+	}
+
+	// Gains from the cache must be the same as those calculated when the metadata is not rounded
+	SceneOptions cacheOptions;
+	cacheOptions.cacheSettings.maxEntries = 64;
+	adm::ObjectGainCacheStatistics cacheStatistics;
+	std::vector<float> cached = renderScene(cacheOptions, &cacheStatistics);
+	assert(cached == serial);
+	assert(cacheStatistics.hits > 0 && cacheStatistics.misses > 0);
+	assert(cacheStatistics.nEntries <= cacheOptions.cacheSettings.maxEntries);
+
+	// The positions in the scene are on a 5 degree grid so rounding to it must not change them
+	cacheOptions.cacheSettings.angleStep = 5.;
+	cacheOptions.cacheSettings.linearStep = 0.1;
+	cacheOptions.nWorkers = 4;
+	adm::ObjectGainCacheStatistics roundedCacheStatistics;
+	std::vector<float> roundedCached = renderScene(cacheOptions, &roundedCacheStatistics);
+	for (size_t i = 0; i < serial.size(); ++i)
+		assert(std::abs(serial[i] - roundedCached[i]) <= 1e-5f * peak);
+	assert(roundedCacheStatistics.hits + roundedCacheStatistics.misses == cacheStatistics.hits + cacheStatistics.misses);
+
+	// Spread panner gains from the extent cache must be the same as those calculated without it
+	SceneOptions extentCacheOptions;
+	extentCacheOptions.extentCacheSettings.maxEntries = 64;
+	adm::ExtentGainCacheStatistics extentCacheStatistics;
+	std::vector<float> extentCached = renderScene(extentCacheOptions, nullptr, nullptr, &extentCacheStatistics);
+	assert(extentCached == serial);
+	assert(extentCacheStatistics.hits > 0 && extentCacheStatistics.misses > 0);
+	assert(extentCacheStatistics.nEntries <= extentCacheOptions.extentCacheSettings.maxEntries);
+
+	// The scene is on a 5 degree grid so rounding to it must not change the gains
+	extentCacheOptions.extentCacheSettings.angleStep = 5.;
+	extentCacheOptions.nWorkers = 4;
+	std::vector<float> extentRounded = renderScene(extentCacheOptions);
+	for (size_t i = 0; i < serial.size(); ++i)
+		assert(std::abs(serial[i] - extentRounded[i]) <= 1e-5f * peak);
+
+	// The DirectSpeakers do not move so their gains are only calculated for the first frame
+	SceneOptions directSpeakerOptions;
+	directSpeakerOptions.nWorkers = 4;
+	adm::DirectSpeakerGainCacheStatistics directSpeakerCacheStatistics;
+	std::vector<float> directSpeakerParallel = renderScene(directSpeakerOptions, nullptr, nullptr, nullptr, &directSpeakerCacheStatistics);
+	assert(directSpeakerParallel == parallel);
+	assert(directSpeakerCacheStatistics.misses == nDirectSpeakers);
+	assert(directSpeakerCacheStatistics.hits == nDirectSpeakers * (nFrames - 1));
+
+	// The first render saves the configuration data to the cache and the second loads it. Both must match the
+	// render without the cache
+	SceneOptions configCacheOptions;
+	configCacheOptions.configCacheDirectory = ".";
+	std::string configCachePath;
+	std::vector<float> configSaved = renderScene(configCacheOptions, nullptr, &configCachePath);
+	assert(!configCachePath.empty() && std::ifstream(configCachePath).good());
+	std::vector<float> configLoaded = renderScene(configCacheOptions);
+	assert(configSaved == serial);
+	assert(configLoaded == serial);
+	std::remove(configCachePath.c_str());
+
+	// Renderers with the same configuration share their read-only tables, which are freed with the last renderer
+	assert(Renderer::GetSharedTableStatistics().nTables == 0);
+	{
+		StreamInformation streamInfo;
+		streamInfo.typeDefinition.push_back(TypeDefinition::Objects);
+		streamInfo.nChannels = 1;
+		Renderer renderer, sharingRenderer, otherRenderer;
+		assert(renderer.Configure(OutputLayout::FivePointOnePointFour, nHoaOrder, 48000, nBlockSize, streamInfo));
+		SharedTableStatistics statistics = Renderer::GetSharedTableStatistics();
+		assert(statistics.nTables > 0 && statistics.nBytes > 0);
+		assert(sharingRenderer.Configure(OutputLayout::FivePointOnePointFour, nHoaOrder, 48000, nBlockSize, streamInfo));
+		SharedTableStatistics sharingStatistics = Renderer::GetSharedTableStatistics();
+		assert(sharingStatistics.nTables == statistics.nTables && sharingStatistics.nBytes == statistics.nBytes);
+		assert(otherRenderer.Configure(OutputLayout::Stereo, nHoaOrder, 48000, nBlockSize, streamInfo));
+		assert(Renderer::GetSharedTableStatistics().nTables > statistics.nTables);
+	}
+	assert(Renderer::GetSharedTableStatistics().nTables == 0);
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#undef NDEBUG
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <AmbisonicCommons.h>
+#include <AmbisonicSource.h>
+
+using namespace spaudio;
+
+typedef std::vector<std::vector<double>> Matrix;
+
+// Rotation about the axis (x, y, z) by angle in radians
+static Matrix axisAngleRotation(double x, double y, double z, double angle)
+{
+	double norm = std::sqrt(x * x + y * y + z * z);
+	x /= norm;
+	y /= norm;
+	z /= norm;
+	double c = std::cos(angle);
+	double s = std::sin(angle);
+	return { { c + x * x * (1. - c), x * y * (1. - c) - z * s, x * z * (1. - c) + y * s },
+			 { y * x * (1. - c) + z * s, c + y * y * (1. - c), y * z * (1. - c) - x * s },
+			 { z * x * (1. - c) - y * s, z * y * (1. - c) + x * s, c + z * z * (1. - c) } };
+}
+
+static Matrix multiply(const Matrix& A, const Matrix& B)
+{
+	Matrix C(3, std::vector<double>(3, 0.));
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			for (int k = 0; k < 3; ++k)
+				C[i][j] += A[i][k] * B[k][j];
+	return C;
+}
+
+int main()
+{
+	const unsigned int nMaxOrder = 7;
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<double> dist(-1., 1.);
+
+	for (int iTest = 0; iTest < 10; ++iTest)
+	{
+		Matrix Ra = axisAngleRotation(dist(rng), dist(rng), dist(rng), 3. * dist(rng));
+		Matrix Rb = axisAngleRotation(dist(rng), dist(rng), dist(rng), 3. * dist(rng));
+		std::vector<double> blocksA, blocksB, blocksAB;
+		ShRotationMatrixBlocks(Ra, nMaxOrder, blocksA);
+		ShRotationMatrixBlocks(Rb, nMaxOrder, blocksB);
+		ShRotationMatrixBlocks(multiply(Ra, Rb), nMaxOrder, blocksAB);
+		assert(blocksA.size() == OrderToRotationBlockPosition(nMaxOrder + 1));
+
+		for (unsigned int l = 0; l <= nMaxOrder; ++l)
+		{
+			const unsigned int n = 2 * l + 1;
+			const double* pA = &blocksA[OrderToRotationBlockPosition(l)];
+			const double* pB = &blocksB[OrderToRotationBlockPosition(l)];
+			const double* pAB = &blocksAB[OrderToRotationBlockPosition(l)];
+			for (unsigned int i = 0; i < n; ++i)
+				for (unsigned int j = 0; j < n; ++j)
+				{
+					// Each block must be orthogonal
+					double dot = 0.;
+					for (unsigned int k = 0; k < n; ++k)
+						dot += pA[i * n + k] * pA[j * n + k];
+					assert(std::abs(dot - (i == j ? 1. : 0.)) < 1e-9);
+
+					// The rotation of a product must be the product of the rotations
+					double prod = 0.;
+					for (unsigned int k = 0; k < n; ++k)
+						prod += pA[i * n + k] * pB[k * n + j];
+					assert(std::abs(prod - pAB[i * n + j]) < 1e-9);
+				}
+		}
+
+		// Rotating the encoding of a direction must give the encoding of the rotated direction
+		const unsigned int nOrder = 3;
+		AmbisonicSource source, rotatedSource;
+		source.Configure(nOrder, true, 0);
+		rotatedSource.Configure(nOrder, true, 0);
+		double azimuth = M_PI * dist(rng);
+		double elevation = 0.5 * M_PI * dist(rng);
+		double d[3] = { std::cos(azimuth) * std::cos(elevation), std::sin(azimuth) * std::cos(elevation), std::sin(elevation) };
+		double rd[3] = { 0., 0., 0. };
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				rd[i] += Ra[i][j] * d[j];
+		source.SetPosition({ (float)azimuth, (float)elevation, 1.f });
+		source.Refresh();
+		rotatedSource.SetPosition({ (float)std::atan2(rd[1], rd[0]), (float)std::asin(rd[2]), 1.f });
+		rotatedSource.Refresh();
+		for (unsigned int l = 0; l <= nOrder; ++l)
+		{
+			const unsigned int n = 2 * l + 1;
+			const double* pA = &blocksA[OrderToRotationBlockPosition(l)];
+			for (unsigned int i = 0; i < n; ++i)
+			{
+				double coeff = 0.;
+				for (unsigned int j = 0; j < n; ++j)
+					coeff += pA[i * n + j] * source.GetCoefficient(l * l + j);
+				assert(std::abs(coeff - rotatedSource.GetCoefficient(l * l + i)) < 1e-5);
+			}
+		}
+	}
+
+	return 0;
+}